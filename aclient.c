@@ -0,0 +1,544 @@
+/*! Функции асинхронного клиента */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "aclient.h"
+#include "coroutine.h"
+
+#define EPOLL_BATCH 256 // событий за один вызов epoll_wait
+#define RESERVED_FDS 64 // дескрипторы, оставляемые остальной программе
+#define MAX_BACKOFF_SHIFT 5 // ожидание растёт не больше чем в 32 раза
+#define FAILOVER_MISSES 3 // попыток подряд без ответа до отказа сервера
+#define PROBE_INTERVAL_MS 500 // проверка отказавшего сервера
+
+// События, будящие сопрограмму запроса
+enum
+{
+    EVENT_NONE,
+    EVENT_READABLE,
+    EVENT_TIMEOUT
+};
+
+// Функция для получения монотонного времени в микросекундах
+uint64_t monotonicUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Функция для вычисления паузы перед попыткой: ожидание удваивается
+// с каждой попыткой, а случайная добавка до четверти не даёт клиентам,
+// получившим отказ одновременно, повторить запросы тоже одновременно
+static uint64_t backoffMs(AsyncClient* client, int attempt)
+{
+    uint64_t base = (uint64_t) client->attemptTimeoutMs
+                    << (attempt < MAX_BACKOFF_SHIFT ? attempt
+                                                    : MAX_BACKOFF_SHIFT);
+    return base + rand_r(&client->seed) % (base / 4 + 1);
+}
+
+// Функция для проверки ответа: ответ на другой номер (запоздавший ответ
+// прошлому запросу ячейки) отбрасывается, префикс номера снимается.
+// Возвращает 1, если ответ относится к запросу
+static int acceptReply(AsyncRequest* r)
+{
+    uint64_t id;
+    r->reply[r->replyLength] = '\0';
+    size_t prefix = decodeRequestId(r->reply, r->replyLength, &id);
+    if (prefix > 0 && id != r->id)
+    {
+        return 0;
+    }
+    // Отказ "занят" сервер отправляет до разбора запроса, без номера
+    memmove(r->reply, r->reply + prefix, r->replyLength - prefix + 1);
+    r->replyLength -= (int) prefix;
+    r->status = strcmp(r->reply, BUSY_REPLY) == 0 ? ASYNC_BUSY : ASYNC_OK;
+    return 1;
+}
+
+// Функция для подключения сокета ячейки к серверу. Сокет открывается
+// при первом использовании ячейки, а для сервера другого семейства
+// адресов открывается заново
+static int connectSocket(AsyncClient* client, AsyncRequest* r, int server)
+{
+    const SocketAddress* address = &client->ring.servers[server];
+    if (r->sockfd != -1 && r->connected != -1 &&
+        client->ring.servers[r->connected].any.sa_family !=
+        address->any.sa_family)
+    {
+        close(r->sockfd);
+        r->sockfd = -1;
+    }
+    r->connected = -1;
+    if (r->sockfd == -1)
+    {
+        r->sockfd = socket(address->any.sa_family, SOCK_DGRAM, 0);
+        if (r->sockfd == -1)
+        {
+            perror("socket");
+            return -1;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = r;
+        if (epoll_ctl(client->epfd, EPOLL_CTL_ADD, r->sockfd, &ev) == -1)
+        {
+            perror("epoll_ctl");
+            close(r->sockfd);
+            r->sockfd = -1;
+            return -1;
+        }
+    }
+    // Подключённый сокет получает только ответы своего сервера
+    if (connect(r->sockfd, &address->any, addressLength(address)) == -1)
+    {
+        perror("connect");
+        return -1;
+    }
+    r->connected = server;
+    return 0;
+}
+
+// Функция для учёта ответа сервера: отказавший сервер возвращается
+// на кольцо
+static void serverAnswered(AsyncClient* client, int server)
+{
+    ServerHealth* health = &client->health[server];
+    health->failures = 0;
+    health->answered++;
+    if (!client->ring.healthy[server])
+    {
+        client->ring.healthy[server] = 1;
+        timerCancel(&client->wheel, &health->probe);
+    }
+}
+
+// Функция для учёта попытки без ответа: после нескольких подряд сервер
+// считается отказавшим, и до ответа на проверку запросы его обходят.
+// Если порт сервера закрыт (ICMP "порт недоступен"), сервер отказал сразу
+static void serverMissed(AsyncClient* client, int server, int refused)
+{
+    ServerHealth* health = &client->health[server];
+    health->failures = refused ? FAILOVER_MISSES : health->failures + 1;
+    if (health->failures >= FAILOVER_MISSES && client->ring.healthy[server])
+    {
+        client->ring.healthy[server] = 0;
+        health->failovers++;
+        timerAdd(&client->wheel, &health->probe,
+                 monotonicMs() + PROBE_INTERVAL_MS);
+    }
+}
+
+// Сопрограмма запроса: отправка, ожидание ответа, повторы по таймауту
+static CoStatus requestStep(AsyncRequest* r)
+{
+    AsyncClient* client = r->client;
+
+    CO_BEGIN(r->line);
+    for (r->attempt = 0; r->attempt <= client->retries; r->attempt++)
+    {
+        // Попытка уходит серверу, которому принадлежит уравнение, а если
+        // он отказал, - следующему работающему серверу кольца
+        r->status = ASYNC_TIMEOUT;
+        r->server = ringLookup(&client->ring, r->key);
+        if ((r->server != r->connected &&
+             connectSocket(client, r, r->server) == -1) ||
+            send(r->sockfd, r->message, r->messageLength, 0) == -1)
+        {
+            r->status = ASYNC_ERROR;
+            break;
+        }
+        client->sent++;
+        client->health[r->server].sent++;
+        if (r->attempt > 0)
+        {
+            client->retransmits++;
+        }
+        timerAdd(&client->wheel, &r->timer,
+                 monotonicMs() + backoffMs(client, r->attempt));
+
+        // Ждём ответа или срабатывания таймера
+        r->event = EVENT_NONE;
+        CO_YIELD(r->line);
+        while (r->event == EVENT_READABLE)
+        {
+            r->replyLength = recv(r->sockfd, r->reply, MAXBUF - 1,
+                                  MSG_DONTWAIT);
+            if ((r->replyLength >= 0 && acceptReply(r)) ||
+                (r->replyLength == -1 && errno == ECONNREFUSED))
+            {
+                break;
+            }
+            // Ложное пробуждение или чужой ответ: ждём дальше
+            CO_YIELD(r->line);
+        }
+        if (r->event != EVENT_READABLE)
+        {
+            // Таймер сработал: датаграмма или ответ потеряны, повторяем
+            serverMissed(client, r->server, 0);
+            continue;
+        }
+        if (r->replyLength == -1)
+        {
+            // Сервер не слушает порт: повторяем сразу, уже другому серверу.
+            // Если другого нет, ждём срока попытки - сервер может ещё
+            // запускаться
+            serverMissed(client, r->server, 1);
+            if (ringLookup(&client->ring, r->key) != r->server)
+            {
+                timerCancel(&client->wheel, &r->timer);
+                continue;
+            }
+            r->event = EVENT_NONE;
+            CO_YIELD(r->line);
+            while (r->event == EVENT_READABLE)
+            {
+                while (recv(r->sockfd, r->reply, MAXBUF, MSG_DONTWAIT) >= 0)
+                {
+                }
+                CO_YIELD(r->line);
+            }
+            continue;
+        }
+        timerCancel(&client->wheel, &r->timer);
+        serverAnswered(client, r->server);
+        if (r->status != ASYNC_BUSY || r->attempt == client->retries)
+        {
+            break;
+        }
+
+        // Сервер занят: выжидаем паузу и повторяем запрос. Ответы,
+        // пришедшие за это время, выбрасываем
+        timerAdd(&client->wheel, &r->timer,
+                 monotonicMs() + backoffMs(client, r->attempt));
+        r->event = EVENT_NONE;
+        CO_YIELD(r->line);
+        while (r->event == EVENT_READABLE)
+        {
+            while (recv(r->sockfd, r->reply, MAXBUF, MSG_DONTWAIT) >= 0)
+            {
+            }
+            CO_YIELD(r->line);
+        }
+    }
+    CO_END(r->line);
+}
+
+// Функция для завершения запроса и освобождения ячейки
+static void finishRequest(AsyncRequest* r)
+{
+    AsyncClient* client = r->client;
+    r->finishedUs = monotonicUs();
+    if (r->status == ASYNC_OK)
+    {
+        client->completed++;
+    }
+    else if (r->status == ASYNC_BUSY)
+    {
+        client->busy++;
+    }
+    else
+    {
+        client->failed++;
+    }
+    client->inFlight--;
+    r->nextFree = client->freeList;
+    client->freeList = r;
+    client->callback(r, r->context);
+}
+
+// Функция для продвижения сопрограммы запроса событием
+static int resume(AsyncRequest* r, int event)
+{
+    r->event = event;
+    if (requestStep(r) == CO_DONE)
+    {
+        finishRequest(r);
+        return 1;
+    }
+    return 0;
+}
+
+// Обработчик срабатывания таймера запроса
+static void requestTimeout(Timer* timer)
+{
+    AsyncRequest* r = (AsyncRequest*) ((char*) timer -
+                                       offsetof(AsyncRequest, timer));
+    resume(r, EVENT_TIMEOUT);
+}
+
+// Обработчик срока проверки отказавшего сервера: отправляет "ping"
+static void probeServer(Timer* timer)
+{
+    ServerHealth* health = (ServerHealth*) ((char*) timer -
+                                            offsetof(ServerHealth, probe));
+    AsyncClient* client = health->client;
+    const SocketAddress* address =
+        &client->ring.servers[health - client->health];
+
+    if (health->sockfd == -1)
+    {
+        health->sockfd = socket(address->any.sa_family,
+                                SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = health;
+        if (health->sockfd != -1 &&
+            (connect(health->sockfd, &address->any,
+                     addressLength(address)) == -1 ||
+             epoll_ctl(client->epfd, EPOLL_CTL_ADD, health->sockfd,
+                       &ev) == -1))
+        {
+            close(health->sockfd);
+            health->sockfd = -1;
+        }
+    }
+    // Ошибка отправки (например, ICMP "порт недоступен" от прошлой
+    // проверки) означает лишь, что сервер ещё не отвечает
+    if (health->sockfd != -1 &&
+        send(health->sockfd, PING_REQUEST, strlen(PING_REQUEST), 0) == -1)
+    {
+        // проверим в следующий раз
+    }
+    timerAdd(&client->wheel, &health->probe,
+             monotonicMs() + PROBE_INTERVAL_MS);
+}
+
+// Функция для приёма ответов на проверку сервера
+static void receiveProbe(AsyncClient* client, ServerHealth* health)
+{
+    char reply[MAXBUF];
+    ssize_t length;
+    while ((length = recv(health->sockfd, reply, sizeof(reply) - 1,
+                          MSG_DONTWAIT)) >= 0)
+    {
+        reply[length] = '\0';
+        if (strcmp(reply, PONG_REPLY) == 0)
+        {
+            serverAnswered(client, (int) (health - client->health));
+        }
+    }
+}
+
+// Функция для определения, пришло ли событие от сокета проверки сервера
+// (у остальных сокетов в событии - ячейка запроса)
+static ServerHealth* probeOf(AsyncClient* client, void* ptr)
+{
+    uintptr_t address = (uintptr_t) ptr;
+    if (address >= (uintptr_t) client->health &&
+        address < (uintptr_t) (client->health + RING_MAX_SERVERS))
+    {
+        return ptr;
+    }
+    return NULL;
+}
+
+// Функция для создания клиента
+int asyncClientInit(AsyncClient* client, const SocketAddress* servers,
+                    int serverCount, int capacity, int attemptTimeoutMs,
+                    int retries, AsyncCallback callback)
+{
+    memset(client, 0, sizeof(*client));
+    if (serverCount < 1 || serverCount > RING_MAX_SERVERS)
+    {
+        fprintf(stderr, "Серверов должно быть от 1 до %d.\n",
+                RING_MAX_SERVERS);
+        return -1;
+    }
+
+    // Каждому запросу в полёте нужен свой сокет: поднимаем мягкое
+    // ограничение на число дескрипторов до жёсткого
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        if (limit.rlim_cur < (rlim_t) capacity + RESERVED_FDS)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+            getrlimit(RLIMIT_NOFILE, &limit);
+        }
+        if (limit.rlim_cur < (rlim_t) capacity + RESERVED_FDS)
+        {
+            capacity = (int) limit.rlim_cur - RESERVED_FDS;
+        }
+    }
+    if (capacity < 1)
+    {
+        fprintf(stderr, "Недостаточно дескрипторов файлов.\n");
+        return -1;
+    }
+
+    client->epfd = epoll_create1(0);
+    if (client->epfd == -1)
+    {
+        perror("epoll_create1");
+        return -1;
+    }
+    if (timerWheelInit(&client->wheel, monotonicMs()) == -1)
+    {
+        perror("timerWheelInit");
+        close(client->epfd);
+        return -1;
+    }
+    client->requests = calloc(capacity, sizeof(AsyncRequest));
+    if (client->requests == NULL)
+    {
+        perror("calloc");
+        timerWheelDestroy(&client->wheel);
+        close(client->epfd);
+        return -1;
+    }
+
+    for (int i = 0; i < serverCount; i++)
+    {
+        ServerHealth* health = &client->health[i];
+        ringAdd(&client->ring, &servers[i]);
+        health->sockfd = -1;
+        health->probe.callback = probeServer;
+        health->client = client;
+    }
+    client->capacity = capacity;
+    client->attemptTimeoutMs = attemptTimeoutMs;
+    client->retries = retries;
+    client->callback = callback;
+    // Номера разных запусков клиента с одного адреса не должны совпасть
+    // за время жизни ответа в кэше сервера
+    client->nextId = monotonicUs();
+    client->seed = (unsigned int) client->nextId;
+    // Ячейки выдаются с начала массива, сокеты открываются при первом
+    // использовании ячейки
+    for (int i = capacity - 1; i >= 0; i--)
+    {
+        AsyncRequest* r = &client->requests[i];
+        r->sockfd = -1;
+        r->connected = -1;
+        r->client = client;
+        r->timer.callback = requestTimeout;
+        r->nextFree = client->freeList;
+        client->freeList = r;
+    }
+    return 0;
+}
+
+// Функция для отправки запроса
+AsyncRequest* asyncClientSubmit(AsyncClient* client, const Request* request,
+                                void* context)
+{
+    AsyncRequest* r = client->freeList;
+    if (r == NULL)
+    {
+        return NULL;
+    }
+    client->freeList = r->nextFree;
+    client->inFlight++;
+
+    // Номер запроса позволяет серверу узнать повтор, а клиенту - отличить
+    // ответ на этот запрос от запоздавшего ответа на прошлый
+    Request numbered = *request;
+    numbered.id = client->nextId++;
+    r->id = numbered.id;
+    r->key = ringKey(request);
+    r->messageLength = encodeRequest(r->message, MAXBUF, &numbered);
+    uint64_t id;
+    r->idLength = r->messageLength == -1 ? 0 :
+                  (int) decodeRequestId(r->message, r->messageLength, &id);
+    r->context = context;
+    r->line = 0;
+    r->attempt = 0;
+    r->replyLength = 0;
+    r->startedUs = monotonicUs();
+    if (r->messageLength == -1)
+    {
+        // Запрос не удалось сформировать: сразу сообщаем об ошибке
+        r->status = ASYNC_ERROR;
+        finishRequest(r);
+        return r;
+    }
+
+    // Выбрасываем запоздавшие ответы на прошлый запрос этой ячейки
+    while (r->sockfd != -1 &&
+           recv(r->sockfd, r->reply, MAXBUF, MSG_DONTWAIT) >= 0)
+    {
+    }
+
+    resume(r, EVENT_NONE);
+    return r;
+}
+
+// Функция для обработки событий сокетов и таймеров
+int asyncClientPoll(AsyncClient* client, int timeoutMs)
+{
+    struct epoll_event events[EPOLL_BATCH];
+    unsigned long before = client->completed + client->failed + client->busy;
+
+    // Пока есть таймеры, просыпаемся не позже ближайшего шага колеса
+    int wheelMs = timerNextTimeout(&client->wheel, monotonicMs());
+    if (wheelMs >= 0 && (timeoutMs < 0 || timeoutMs > wheelMs))
+    {
+        timeoutMs = wheelMs;
+    }
+    int count = epoll_wait(client->epfd, events, EPOLL_BATCH, timeoutMs);
+    if (count == -1)
+    {
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+        perror("epoll_wait");
+        return -1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        ServerHealth* health = probeOf(client, events[i].data.ptr);
+        if (health != NULL)
+        {
+            receiveProbe(client, health);
+            continue;
+        }
+        AsyncRequest* r = events[i].data.ptr;
+        if (r->line != 0)
+        {
+            resume(r, EVENT_READABLE);
+            continue;
+        }
+        // В свободную ячейку пришёл запоздавший ответ: выбрасываем его
+        while (recv(r->sockfd, r->reply, MAXBUF, MSG_DONTWAIT) >= 0)
+        {
+        }
+    }
+    timerAdvance(&client->wheel, monotonicMs());
+    return (int) (client->completed + client->failed + client->busy - before);
+}
+
+// Функция для освобождения клиента
+void asyncClientDestroy(AsyncClient* client)
+{
+    for (int i = 0; i < client->capacity; i++)
+    {
+        if (client->requests[i].sockfd != -1)
+        {
+            close(client->requests[i].sockfd);
+        }
+    }
+    for (int i = 0; i < client->ring.count; i++)
+    {
+        if (client->health[i].sockfd != -1)
+        {
+            close(client->health[i].sockfd);
+        }
+    }
+    free(client->requests);
+    timerWheelDestroy(&client->wheel);
+    close(client->epfd);
+}
@@ -0,0 +1,168 @@
+/*!
+ * \file aclient.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение асинхронного клиента. Каждый
+ * запрос - бесстековая сопрограмма со своим подключённым UDP-сокетом;
+ * все сопрограммы выполняются в одном потоке поверх epoll, а сроки
+ * ожидания ответов хранятся в колесе таймеров. Запрос без ответа
+ * отправляется повторно заданное число раз с экспоненциально растущим
+ * ожиданием; так же, выждав, клиент повторяет запрос, на который сервер
+ * ответил "занят". Каждый запрос получает номер: сервер не решает повтор
+ * заново, а запоздавшие ответы на чужие запросы отбрасываются.
+ *
+ * Клиент может работать с несколькими серверами: запрос направляется
+ * по кольцу согласованного хеширования (ring.h) серверу, которому
+ * принадлежит его уравнение. Сервер, не ответивший на несколько попыток
+ * подряд, считается отказавшим: его запросы уходят следующим серверам
+ * кольца, а сам он раз в полсекунды проверяется запросом "ping" и
+ * возвращается на кольцо после первого ответа.
+*/
+
+#ifndef INC_6_LAB_ACLIENT_H
+#define INC_6_LAB_ACLIENT_H
+
+#include <stdint.h>
+#include "address.h"
+#include "protocol.h"
+#include "ring.h"
+#include "timerwheel.h"
+
+/*!
+ * \brief Итог запроса
+ */
+typedef enum
+{
+    ASYNC_OK,      /*!< Получен ответ */
+    ASYNC_BUSY,    /*!< Сервер отклонил запрос ограничением частоты */
+    ASYNC_TIMEOUT, /*!< Ответа нет после всех повторов */
+    ASYNC_ERROR    /*!< Ошибка отправки */
+} AsyncStatus;
+
+struct AsyncClient;
+
+/*!
+ * \brief Запрос в полёте (состояние сопрограммы)
+ */
+typedef struct AsyncRequest
+{
+    int line;                    /*!< Точка продолжения сопрограммы */
+    int event;                   /*!< Событие, разбудившее сопрограмму */
+    int sockfd;                  /*!< Подключённый сокет ячейки */
+    int connected;               /*!< Сервер, к которому подключён сокет
+                                      (-1 - ни к какому) */
+    int server;                  /*!< Сервер текущей попытки */
+    uint64_t key;                /*!< Ключ запроса на кольце серверов */
+    int attempt;                 /*!< Номер попытки */
+    uint64_t id;                 /*!< Номер запроса */
+    int idLength;                /*!< Длина префикса "@id " сообщения */
+    Timer timer;                 /*!< Срок ожидания текущей попытки */
+    uint64_t startedUs;          /*!< Момент первой отправки, мкс */
+    uint64_t finishedUs;         /*!< Момент завершения, мкс */
+    AsyncStatus status;          /*!< Итог запроса */
+    void* context;               /*!< Данные вызывающей стороны */
+    int messageLength;           /*!< Длина сообщения с префиксом номера */
+    char message[MAXBUF];        /*!< Сообщение серверу */
+    int replyLength;             /*!< Длина ответа */
+    char reply[MAXBUF];          /*!< Ответ сервера без префикса номера */
+    struct AsyncClient* client;  /*!< Клиент, которому принадлежит запрос */
+    struct AsyncRequest* nextFree; /*!< Следующая свободная ячейка */
+} AsyncRequest;
+
+/*!
+ * \brief Функция, вызываемая по завершении запроса
+ */
+typedef void (*AsyncCallback)(AsyncRequest* request, void* context);
+
+/*!
+ * \brief Состояние сервера с точки зрения клиента
+ */
+typedef struct ServerHealth
+{
+    int failures;                /*!< Попыток подряд без ответа */
+    int sockfd;                  /*!< Сокет проверки (-1 - не открыт) */
+    Timer probe;                 /*!< Срок следующей проверки */
+    unsigned long sent;          /*!< Отправлено датаграмм запросов */
+    unsigned long answered;      /*!< Получено ответов */
+    unsigned long failovers;     /*!< Сколько раз признан отказавшим */
+    struct AsyncClient* client;  /*!< Клиент, которому принадлежит запись */
+} ServerHealth;
+
+/*!
+ * \brief Асинхронный клиент
+ */
+typedef struct AsyncClient
+{
+    int epfd;                    /*!< Дескриптор epoll */
+    TimerWheel wheel;            /*!< Сроки ожидания ответов */
+    HashRing ring;               /*!< Серверы */
+    ServerHealth health[RING_MAX_SERVERS]; /*!< Состояние серверов */
+    AsyncRequest* requests;      /*!< Ячейки запросов */
+    int capacity;                /*!< Наибольшее число запросов в полёте */
+    AsyncRequest* freeList;      /*!< Свободные ячейки */
+    int inFlight;                /*!< Запросов в полёте */
+    int attemptTimeoutMs;        /*!< Ожидание ответа на первую попытку, мс */
+    int retries;                 /*!< Количество повторных отправок */
+    uint64_t nextId;             /*!< Номер следующего запроса */
+    unsigned int seed;           /*!< Состояние случайного разброса пауз */
+    AsyncCallback callback;      /*!< Обработчик завершения */
+    unsigned long sent;          /*!< Отправлено датаграмм */
+    unsigned long retransmits;   /*!< Из них повторных */
+    unsigned long completed;     /*!< Запросов с ответом */
+    unsigned long failed;        /*!< Запросов без ответа */
+    unsigned long busy;          /*!< Запросов, отклонённых сервером */
+} AsyncClient;
+
+/*!
+ * \brief Создаёт клиента
+ *
+ * Ёмкость уменьшается, если ограничение на число открытых файлов
+ * не позволяет открыть столько сокетов.
+ * \param[out] client Клиент
+ * \param[in] servers Адреса серверов
+ * \param[in] serverCount Количество серверов (не больше RING_MAX_SERVERS)
+ * \param[in] capacity Наибольшее число запросов в полёте
+ * \param[in] attemptTimeoutMs Ожидание ответа на первую попытку, мс
+ * (каждая следующая ждёт вдвое дольше)
+ * \param[in] retries Количество повторных отправок
+ * \param[in] callback Обработчик завершения запросов
+ * \return 0 при успехе, -1 при ошибке
+ */
+int asyncClientInit(AsyncClient* client, const SocketAddress* servers,
+                    int serverCount, int capacity, int attemptTimeoutMs,
+                    int retries, AsyncCallback callback);
+
+/*!
+ * \brief Отправляет запрос, не дожидаясь ответа
+ *
+ * Если запрос не удалось отправить, обработчик завершения вызывается
+ * сразу с итогом ASYNC_ERROR.
+ * \param[in] client Клиент
+ * \param[in] request Запрос
+ * \param[in] context Данные, передаваемые обработчику завершения
+ * \return Ячейка запроса или NULL, если все ячейки заняты
+ */
+AsyncRequest* asyncClientSubmit(AsyncClient* client, const Request* request,
+                                void* context);
+
+/*!
+ * \brief Ждёт событий сокетов и таймеров и продвигает сопрограммы
+ * \param[in] client Клиент
+ * \param[in] timeoutMs Наибольшее время ожидания, мс (-1 - без ограничения)
+ * \return Количество завершившихся запросов или -1 при ошибке
+ */
+int asyncClientPoll(AsyncClient* client, int timeoutMs);
+
+/*!
+ * \brief Закрывает сокеты и освобождает память клиента
+ * \param[in] client Клиент
+ */
+void asyncClientDestroy(AsyncClient* client);
+
+/*!
+ * \brief Возвращает текущее монотонное время
+ * \return Время в микросекундах
+ */
+uint64_t monotonicUs(void);
+
+#endif //INC_6_LAB_ACLIENT_H
@@ -0,0 +1,211 @@
+/*! Функции адресов сокетов */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+#include "address.h"
+
+// Функция для разбора адреса и порта
+int addressResolve(const char* host, int port, SocketAddress* address)
+{
+    if (port < 1 || port > 65535)
+    {
+        return -1;
+    }
+    char service[8];
+    snprintf(service, sizeof(service), "%d", port);
+
+    // Берём первый адрес узла; числовые адреса разбираются без DNS
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    struct addrinfo* result;
+    if (getaddrinfo(host, service, &hints, &result) != 0)
+    {
+        return -1;
+    }
+    memset(address, 0, sizeof(*address));
+    memcpy(address, result->ai_addr,
+           result->ai_addrlen < sizeof(*address) ? result->ai_addrlen
+                                                 : sizeof(*address));
+    freeaddrinfo(result);
+    return 0;
+}
+
+// Функция для разбора адреса с необязательным портом
+int addressParse(const char* text, int defaultPort, SocketAddress* address)
+{
+    char host[256];
+    const char* hostStart = text;
+    const char* hostEnd;
+    const char* port = NULL;
+
+    if (text[0] == '[')
+    {
+        // "[адрес IPv6]" или "[адрес IPv6]:порт"
+        hostStart = text + 1;
+        hostEnd = strchr(hostStart, ']');
+        if (hostEnd == NULL || (hostEnd[1] != '\0' && hostEnd[1] != ':'))
+        {
+            return -1;
+        }
+        if (hostEnd[1] == ':')
+        {
+            port = hostEnd + 2;
+        }
+    }
+    else
+    {
+        // Ровно одно двоеточие отделяет порт, несколько - часть адреса
+        // IPv6 без порта
+        const char* colon = strchr(text, ':');
+        if (colon != NULL && strchr(colon + 1, ':') == NULL)
+        {
+            hostEnd = colon;
+            port = colon + 1;
+        }
+        else
+        {
+            hostEnd = text + strlen(text);
+        }
+    }
+    size_t length = (size_t) (hostEnd - hostStart);
+    if (length == 0 || length >= sizeof(host))
+    {
+        return -1;
+    }
+    memcpy(host, hostStart, length);
+    host[length] = '\0';
+
+    int portNumber = defaultPort;
+    if (port != NULL)
+    {
+        char* end;
+        long value = strtol(port, &end, 10);
+        if (end == port || *end != '\0' || value < 1 || value > 65535)
+        {
+            return -1;
+        }
+        portNumber = (int) value;
+    }
+    return addressResolve(host, portNumber, address);
+}
+
+// Функция для вычисления длины адреса
+socklen_t addressLength(const SocketAddress* address)
+{
+    return address->any.sa_family == AF_INET6 ? sizeof(address->v6)
+                                              : sizeof(address->v4);
+}
+
+// Функция для сравнения адресов
+int addressEqual(const SocketAddress* x, const SocketAddress* y)
+{
+    if (x->any.sa_family != y->any.sa_family)
+    {
+        return 0;
+    }
+    if (x->any.sa_family == AF_INET6)
+    {
+        return x->v6.sin6_port == y->v6.sin6_port &&
+               memcmp(&x->v6.sin6_addr, &y->v6.sin6_addr,
+                      sizeof(x->v6.sin6_addr)) == 0;
+    }
+    return x->v4.sin_addr.s_addr == y->v4.sin_addr.s_addr &&
+           x->v4.sin_port == y->v4.sin_port;
+}
+
+// Функция для вычисления хеша адреса
+uint64_t addressHash(const SocketAddress* address)
+{
+    uint64_t h;
+    if (address->any.sa_family == AF_INET6)
+    {
+        // Адрес IPv6 - два 64-битных слова
+        uint64_t words[2];
+        memcpy(words, &address->v6.sin6_addr, sizeof(words));
+        h = words[0] * 0x9E3779B97F4A7C15ull ^ words[1];
+        h ^= (uint64_t) address->v6.sin6_port << 48;
+    }
+    else
+    {
+        h = address->v4.sin_addr.s_addr ^
+            ((uint64_t) address->v4.sin_port << 32);
+    }
+    h *= 0xBF58476D1CE4E5B9ull;
+    return h ^ (h >> 31);
+}
+
+// Функция для сравнения адресов узлов
+int addressHostEqual(const SocketAddress* x, const SocketAddress* y)
+{
+    if (x->any.sa_family != y->any.sa_family)
+    {
+        return 0;
+    }
+    if (x->any.sa_family == AF_INET6)
+    {
+        return memcmp(&x->v6.sin6_addr, &y->v6.sin6_addr,
+                      sizeof(x->v6.sin6_addr)) == 0;
+    }
+    return x->v4.sin_addr.s_addr == y->v4.sin_addr.s_addr;
+}
+
+// Функция для вычисления хеша адреса узла
+uint64_t addressHostHash(const SocketAddress* address)
+{
+    uint64_t h;
+    if (address->any.sa_family == AF_INET6)
+    {
+        uint64_t words[2];
+        memcpy(words, &address->v6.sin6_addr, sizeof(words));
+        h = words[0] * 0x9E3779B97F4A7C15ull ^ words[1];
+    }
+    else
+    {
+        h = address->v4.sin_addr.s_addr;
+    }
+    h *= 0xBF58476D1CE4E5B9ull;
+    return h ^ (h >> 31);
+}
+
+// Функция для записи адреса в буфер
+int addressFormat(const SocketAddress* address, char* out, size_t size)
+{
+    char host[INET6_ADDRSTRLEN];
+    int written;
+    if (address->any.sa_family == AF_INET6)
+    {
+        const struct in6_addr* ip = &address->v6.sin6_addr;
+        if (IN6_IS_ADDR_V4MAPPED(ip))
+        {
+            // Клиент IPv4 на сокете с двойным стеком: последние 4 байта
+            inet_ntop(AF_INET, &ip->s6_addr[12], host, sizeof(host));
+            written = snprintf(out, size, "%s:%d", host,
+                               ntohs(address->v6.sin6_port));
+        }
+        else
+        {
+            inet_ntop(AF_INET6, ip, host, sizeof(host));
+            written = snprintf(out, size, "[%s]:%d", host,
+                               ntohs(address->v6.sin6_port));
+        }
+    }
+    else
+    {
+        inet_ntop(AF_INET, &address->v4.sin_addr, host, sizeof(host));
+        written = snprintf(out, size, "%s:%d", host,
+                           ntohs(address->v4.sin_port));
+    }
+    if (written < 0)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t) written < size ? written : (int) size - 1;
+}
@@ -0,0 +1,108 @@
+/*!
+ * \file address.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение адреса сокета, общего для IPv4
+ * и IPv6. Сервер, слушающий на адресе IPv6 "::", принимает и запросы
+ * IPv4: их адреса приходят в виде ::ffff:a.b.c.d и выводятся как IPv4.
+*/
+
+#ifndef INC_6_LAB_ADDRESS_H
+#define INC_6_LAB_ADDRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/*!
+ * \brief Адрес сервера по умолчанию
+ */
+#define DEFAULT_HOST "127.0.0.1"
+
+/*!
+ * \brief Порт сервера по умолчанию
+ */
+#define DEFAULT_PORT 5555
+
+/*!
+ * \brief Достаточный размер буфера для текста адреса "[адрес]:порт"
+ */
+#define ADDRESS_TEXT_SIZE (INET6_ADDRSTRLEN + 8)
+
+/*!
+ * \brief Адрес сокета IPv4 или IPv6
+ */
+typedef union
+{
+    struct sockaddr any;     /*!< Общий заголовок (семейство адресов) */
+    struct sockaddr_in v4;   /*!< Адрес IPv4 */
+    struct sockaddr_in6 v6;  /*!< Адрес IPv6 */
+} SocketAddress;
+
+/*!
+ * \brief Разбирает адрес или имя узла и порт
+ * \param[in] host Адрес IPv4, адрес IPv6 или имя узла
+ * \param[in] port Порт
+ * \param[out] address Адрес сокета
+ * \return 0 при успехе, -1, если адрес не удалось разобрать
+ */
+int addressResolve(const char* host, int port, SocketAddress* address);
+
+/*!
+ * \brief Разбирает адрес вида "узел", "узел:порт", "[адрес IPv6]:порт"
+ * или адрес IPv6 без порта
+ * \param[in] text Текст адреса
+ * \param[in] defaultPort Порт, если он не указан
+ * \param[out] address Адрес сокета
+ * \return 0 при успехе, -1, если адрес не удалось разобрать
+ */
+int addressParse(const char* text, int defaultPort, SocketAddress* address);
+
+/*!
+ * \brief Возвращает длину адреса для bind, connect и sendto
+ * \param[in] address Адрес
+ * \return Длина структуры адреса его семейства
+ */
+socklen_t addressLength(const SocketAddress* address);
+
+/*!
+ * \brief Сравнивает адреса (семейство, адрес и порт)
+ * \param[in] x Первый адрес
+ * \param[in] y Второй адрес
+ * \return 1, если адреса совпадают, иначе 0
+ */
+int addressEqual(const SocketAddress* x, const SocketAddress* y);
+
+/*!
+ * \brief Вычисляет хеш адреса для хеш-таблиц
+ * \param[in] address Адрес
+ * \return Хеш
+ */
+uint64_t addressHash(const SocketAddress* address);
+
+/*!
+ * \brief Сравнивает адреса узлов (семейство и адрес, без порта)
+ * \param[in] x Первый адрес
+ * \param[in] y Второй адрес
+ * \return 1, если адреса узлов совпадают, иначе 0
+ */
+int addressHostEqual(const SocketAddress* x, const SocketAddress* y);
+
+/*!
+ * \brief Вычисляет хеш адреса узла (без порта)
+ * \param[in] address Адрес
+ * \return Хеш
+ */
+uint64_t addressHostHash(const SocketAddress* address);
+
+/*!
+ * \brief Записывает адрес в виде "a.b.c.d:порт" или "[адрес]:порт"
+ * \param[in] address Адрес
+ * \param[out] out Буфер размером не меньше ADDRESS_TEXT_SIZE
+ * \param[in] size Размер буфера
+ * \return Длина записанного текста
+ */
+int addressFormat(const SocketAddress* address, char* out, size_t size);
+
+#endif //INC_6_LAB_ADDRESS_H
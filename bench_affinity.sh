@@ -0,0 +1,29 @@
+#!/bin/sh
+# Сравнение задержки сервера без привязки обработчиков к процессорам
+# и с привязкой к процессорам и узлам NUMA.
+#
+# Использование: ./bench_affinity.sh "0-3" [запросов в полёте] [запросов]
+# Первый аргумент - список процессоров для обработчиков (опция -C сервера).
+# На многосокетной машине стоит указать процессоры одного узла NUMA,
+# ближайшего к сетевой карте.
+
+CPUS=${1:?укажите список процессоров, например 0-3}
+CONCURRENCY=${2:-64}
+REQUESTS=${3:-200000}
+
+run() {
+    echo "== server $*"
+    ./server -l /dev/null "$@" > /dev/null &
+    pid=$!
+    sleep 1
+    ./loadgen -c "$CONCURRENCY" -n "$REQUESTS"
+    kill "$pid"
+    wait "$pid" 2> /dev/null
+}
+
+WORKERS=$(echo "$CPUS" | tr ',' '\n' |
+          awk -F- '{ n += (NF == 2) ? $2 - $1 + 1 : 1 } END { print n }')
+
+run -w "$WORKERS"
+run -w "$WORKERS" -C "$CPUS"
+run -w "$WORKERS" -C "$CPUS" -N
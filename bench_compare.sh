@@ -0,0 +1,24 @@
+#!/bin/sh
+# Сравнение двух результатов bench_logic в формате CSV, например до и
+# после изменения решателя.
+#
+# Использование: ./bench_compare.sh old.csv new.csv
+# Для каждой пары функция/набор выводит медианное время в наносекундах
+# на уравнение и изменение в процентах (отрицательное - ускорение).
+
+OLD=${1:?укажите файл с прежними результатами}
+NEW=${2:?укажите файл с новыми результатами}
+
+awk -F, '
+    FNR == 1 { next }
+    NR == FNR { old[$1 "," $2] = $4; next }
+    {
+        key = $1 "," $2
+        if (key in old && old[key] > 0) {
+            printf "%-18s %-11s %10.1f %10.1f %+8.1f%%\n", $1, $2,
+                   old[key], $4, ($4 - old[key]) * 100 / old[key]
+        } else {
+            printf "%-18s %-11s %10s %10.1f %9s\n", $1, $2, "-", $4, "new"
+        }
+    }
+' "$OLD" "$NEW"
@@ -0,0 +1,237 @@
+/*! Микротест вычисления значений многочленов */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+
+#include "bench_eval.h"
+#include "logic.h"
+
+#define DEFAULT_POINTS 4096 // точек в массиве (помещается в кэш L1-L2)
+#define DEFAULT_REPEATS 7 // повторов замера
+#define MIN_SAMPLE_NS 20000000 // наименьшая длительность одного повтора
+#define NEAR_ROOT_POINTS 1000 // точек около кратного корня
+#define NEAR_ROOT_STEP 1e-8 // расстояние между точками около корня
+#define NAME_WIDTH 18 // ширина столбца названия способа, символов
+
+// Многочлен (x - 1)(x - 2)(x - 3)
+static const double coef[4] = {1, -6, 11, -6};
+
+// Замеряемый способ вычисления
+typedef struct
+{
+    const char* name; // название
+    int library;      // 1 - EvaluatePolynomial, 0 - простой цикл
+    unsigned flags;   // режим EvaluatePolynomial
+} Method;
+
+static const Method methods[] = {
+        {"цикл", 0, 0},
+        {"Горнер", 1, 0},
+        {"Горнер+fma", 1, EVAL_FMA},
+        {"компенсированный", 1, EVAL_COMPENSATED},
+};
+
+// Функция для получения монотонного времени в наносекундах
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Функция для вычисления значений простым циклом по точкам, как их
+// вычисляли бы без EvaluatePolynomial
+static void evaluateLoop(const double* x, size_t count, int derivatives,
+                         double* values, double* first, double* second)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        double t = x[i];
+        values[i] = ((coef[0] * t + coef[1]) * t + coef[2]) * t + coef[3];
+        if (derivatives > 0)
+        {
+            first[i] = (3 * coef[0] * t + 2 * coef[1]) * t + coef[2];
+        }
+        if (derivatives > 1)
+        {
+            second[i] = 6 * coef[0] * t + 2 * coef[1];
+        }
+    }
+}
+
+// Функция для однократного вычисления всех точек выбранным способом
+static void run(const Method* method, const double* x, size_t count,
+                int derivatives, double* values, double* first,
+                double* second)
+{
+    if (!method->library)
+    {
+        evaluateLoop(x, count, derivatives, values, first, second);
+        return;
+    }
+    EvaluatePolynomial(coef, 3, x, count, method->flags, values,
+                       derivatives > 0 ? first : NULL,
+                       derivatives > 1 ? second : NULL);
+}
+
+// Функция для подсчёта символов UTF-8 в строке
+static int textWidth(const char* text)
+{
+    int width = 0;
+    for (; *text != '\0'; text++)
+    {
+        width += ((unsigned char) *text & 0xC0) != 0x80;
+    }
+    return width;
+}
+
+static int compareDouble(const void* x, const void* y)
+{
+    double a = *(const double*) x;
+    double b = *(const double*) y;
+    return (a > b) - (a < b);
+}
+
+// Функция для замера: медиана наносекунд на точку по повторам
+static double measure(const Method* method, const double* x, size_t count,
+                      int derivatives, int repeats, double* values,
+                      double* first, double* second, volatile double* sink)
+{
+    // Прогрев и подбор числа проходов на один повтор
+    size_t passes = 1;
+    while (1)
+    {
+        uint64_t start = nowNs();
+        for (size_t p = 0; p < passes; p++)
+        {
+            run(method, x, count, derivatives, values, first, second);
+        }
+        if (nowNs() - start >= MIN_SAMPLE_NS)
+        {
+            break;
+        }
+        passes *= 2;
+    }
+
+    double ns[repeats];
+    for (int r = 0; r < repeats; r++)
+    {
+        uint64_t start = nowNs();
+        for (size_t p = 0; p < passes; p++)
+        {
+            run(method, x, count, derivatives, values, first, second);
+            *sink += values[p % count];
+        }
+        ns[r] = (double) (nowNs() - start) / ((double) passes * count);
+    }
+    qsort(ns, repeats, sizeof(double), compareDouble);
+    return ns[repeats / 2];
+}
+
+// Функция для сравнения точности около кратного корня: многочлен
+// (x - 1)^3 обычная схема Горнера вычисляет с полной потерей точности
+static void reportAccuracy(FILE* report)
+{
+    const double cube[4] = {1, -3, 3, -1};
+    double x[NEAR_ROOT_POINTS];
+    double plain[NEAR_ROOT_POINTS];
+    double compensated[NEAR_ROOT_POINTS];
+    for (int i = 0; i < NEAR_ROOT_POINTS; i++)
+    {
+        x[i] = 1 + (i - NEAR_ROOT_POINTS / 2) * NEAR_ROOT_STEP;
+    }
+    EvaluatePolynomial(cube, 3, x, NEAR_ROOT_POINTS, 0, plain, NULL, NULL);
+    EvaluatePolynomial(cube, 3, x, NEAR_ROOT_POINTS, EVAL_COMPENSATED,
+                       compensated, NULL, NULL);
+
+    // Точное значение (x - 1)^3: x - 1 вычисляется без ошибки
+    int plainWrong = 0;
+    int compensatedWrong = 0;
+    for (int i = 0; i < NEAR_ROOT_POINTS; i++)
+    {
+        double h = x[i] - 1;
+        double exact = h * h * h;
+        double tolerance = 1e-10 * fabs(exact);
+        plainWrong += fabs(plain[i] - exact) > tolerance;
+        compensatedWrong += fabs(compensated[i] - exact) > tolerance;
+    }
+    fprintf(report, "\n(x - 1)^3 в %d точках около x = 1 (шаг %g): "
+                    "относительная ошибка больше 1e-10\n"
+                    "  Горнер: %d точек, компенсированный: %d точек\n",
+            NEAR_ROOT_POINTS, NEAR_ROOT_STEP, plainWrong,
+            compensatedWrong);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = DEFAULT_POINTS;
+    int repeats = DEFAULT_REPEATS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                count = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Использование: %s [-n points] "
+                                "[-r repeats]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (count < 1 || repeats < 1)
+    {
+        fprintf(stderr, "Количество точек и повторов должно быть "
+                        "положительным.\n");
+        return 1;
+    }
+
+    double* x = malloc(sizeof(double) * count);
+    double* values = malloc(sizeof(double) * count);
+    double* first = malloc(sizeof(double) * count);
+    double* second = malloc(sizeof(double) * count);
+    if (x == NULL || values == NULL || first == NULL || second == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+    unsigned int seed = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        x[i] = 4.0 * rand_r(&seed) / ((double) RAND_MAX + 1);
+    }
+
+    volatile double sink = 0;
+    fprintf(stdout, "способ             производных   нс/точку  "
+                    "млн точек/с\n");
+    size_t methodCount = sizeof(methods) / sizeof(methods[0]);
+    for (int derivatives = 0; derivatives <= 2; derivatives++)
+    {
+        for (size_t m = 0; m < methodCount; m++)
+        {
+            double ns = measure(&methods[m], x, count, derivatives, repeats,
+                                values, first, second, &sink);
+            // Ширина первого столбца - в символах, а не в байтах
+            int padding = NAME_WIDTH - textWidth(methods[m].name);
+            fprintf(stdout, "%s%*s %11d %10.3f %12.1f\n", methods[m].name,
+                    padding, "", derivatives, ns, 1000 / ns);
+            fflush(stdout);
+        }
+    }
+    reportAccuracy(stdout);
+
+    free(x);
+    free(values);
+    free(first);
+    free(second);
+    return sink == 12345.0; // sink читается, чтобы вычисления не исчезли
+}
@@ -0,0 +1,21 @@
+/*!
+ * \file bench_eval.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение основной функции
+ * микротеста вычисления значений многочленов во многих точках.
+*/
+
+#ifndef INC_6_LAB_BENCH_EVAL_H
+#define INC_6_LAB_BENCH_EVAL_H
+
+/*!
+ * \brief Измеряет скорость EvaluatePolynomial (точек в секунду) во всех
+ * режимах и с производными и сравнивает её с простым циклом по точкам
+ * \param[in] argc Количество аргументов командной строки
+ * \param[in] argv Массив указателей на строки, содержащие аргументы
+ * \return Код завершения
+ */
+int main(int argc, char* argv[]);
+
+#endif //INC_6_LAB_BENCH_EVAL_H
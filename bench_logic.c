@@ -0,0 +1,1299 @@
+/*! Микротест решателя уравнений */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "bench_logic.h"
+#include "logic.h"
+#include "protocol.h"
+
+#define DEFAULT_COUNT 100000 // уравнений в наборе
+#define DEFAULT_REPEATS 7 // повторов замера
+#define JOURNAL_MARKER "Пакет содержит \"" // строка запроса в журнале сервера
+#define SWEEP_PATH_LENGTH 1000 // уравнений на одном пути набора sweep
+#define ROOT_MISMATCH 1e-9 // относительное отличие корня от эталона,
+                           // при котором корень неверен
+#define REFERENCE_STEPS 400 // шагов поиска эталонного корня
+#define REFERENCE_DOUBLE_MARGIN 64 // запас оценки значения многочлена
+                                   // в кратном корне, в LDBL_EPSILON^2
+// Множитель для разделения мантиссы long double на две половины
+#define REFERENCE_SPLITTER (1.0L + (1ULL << ((LDBL_MANT_DIG + 1) / 2)))
+
+// Эталонные корни уравнения, найденные независимо от logic.c
+typedef struct
+{
+    int count;            // количество различных действительных корней
+    long double roots[3]; // корни в порядке возрастания
+} Reference;
+
+// Коэффициенты уравнения для квадратных и для кубических функций
+typedef struct
+{
+    double q[3]; // a, b, c квадратного уравнения
+    double k[4]; // a, b, c, d кубического уравнения
+} Equation;
+
+// Набор входных данных
+typedef struct
+{
+    const char* name;     // имя набора
+    Equation* equations;  // уравнения
+    size_t count;         // количество уравнений
+    EquationBatch batch;  // те же уравнения пакетом: квадратные и
+                          // кубические вперемешку
+} InputSet;
+
+// Замеряемая функция: решает одно уравнение, результат - в sink
+typedef double (*Kernel)(const Equation* e, char* buffer);
+
+// Замеряемая функция, решающая весь пакет набора
+typedef void (*BatchKernel)(EquationBatch* batch);
+
+// Замеряемая функция с именем
+typedef struct
+{
+    const char* name;  // имя функции
+    Kernel run;        // обёртка или NULL
+    BatchKernel batch; // обёртка пакетной функции или NULL
+} KernelInfo;
+
+// Результат замера одной функции на одном наборе
+typedef struct
+{
+    const char* kernel;
+    const char* input;
+    size_t count;
+    double nsMedian;
+    double nsMin;
+    double cyclesMedian;
+    double branchMissesMedian; // NaN, если счётчики недоступны
+    double instructionsMedian;
+} Result;
+
+// Счётчики процессора: промахи предсказания переходов и выполненные
+// команды. Без поддержки perf_event_open (например, в виртуальной машине
+// без счётчиков) дескрипторы равны -1
+typedef struct
+{
+    int branchMisses;
+    int instructions;
+} Counters;
+
+// Показания счётчиков
+typedef struct
+{
+    uint64_t branchMisses;
+    uint64_t instructions;
+} CounterValues;
+
+// Функция для чтения счётчика тактов (0, если он недоступен)
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+#if defined(__linux__)
+// Функция для открытия счётчика процессора текущего потока (-1, если
+// он недоступен)
+static int openCounter(uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+// Функция для открытия счётчиков. Возвращает 0, если ни один
+// счётчик недоступен
+static int openCounters(Counters* counters)
+{
+#if defined(__linux__)
+    counters->branchMisses = openCounter(PERF_COUNT_HW_BRANCH_MISSES);
+    counters->instructions = openCounter(PERF_COUNT_HW_INSTRUCTIONS);
+#else
+    counters->branchMisses = -1;
+    counters->instructions = -1;
+#endif
+    return counters->branchMisses != -1 || counters->instructions != -1;
+}
+
+static void closeCounters(Counters* counters)
+{
+    if (counters->branchMisses != -1)
+    {
+        close(counters->branchMisses);
+    }
+    if (counters->instructions != -1)
+    {
+        close(counters->instructions);
+    }
+}
+
+// Функция для чтения счётчика (0, если он недоступен)
+static uint64_t readCounter(int fd)
+{
+    uint64_t value;
+    if (fd == -1 || read(fd, &value, sizeof(value)) != sizeof(value))
+    {
+        return 0;
+    }
+    return value;
+}
+
+static CounterValues readCounters(const Counters* counters)
+{
+    CounterValues values = {readCounter(counters->branchMisses),
+                            readCounter(counters->instructions)};
+    return values;
+}
+
+// Функция для получения монотонного времени в наносекундах
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Обёртки над функциями решателя. Возвращают значение, зависящее от
+// результата, чтобы компилятор не выбросил вычисление
+static double runComputeQuadratic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    EquationResult result;
+    ComputeQuadratic(e->q[0], e->q[1], e->q[2], &result);
+    return result.count > 0 ? result.roots[0] : 0;
+}
+
+static double runComputeCubic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    EquationResult result;
+    ComputeCubic(e->k[0], e->k[1], e->k[2], e->k[3], &result);
+    return result.count > 0 ? result.roots[0] : 0;
+}
+
+// Тёплый старт от корней предыдущего уравнения набора: в наборе sweep
+// соседние уравнения близки, в остальных наборах - нет
+static double runComputeSeeded(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    static EquationResult previous = {0, ROOTS_NONE, 0, {0, 0, 0}};
+    ComputeSeeded(e->k[0], e->k[1], e->k[2], e->k[3], &previous, &previous);
+    return previous.count > 0 ? previous.roots[0] : 0;
+}
+
+static double runFormatQuadratic(const Equation* e, char* buffer)
+{
+    return FormatQuadratic(buffer, SOLUTION_TEXT_SIZE, e->q[0], e->q[1],
+                           e->q[2]);
+}
+
+static double runFormatCubic(const Equation* e, char* buffer)
+{
+    return FormatCubic(buffer, SOLUTION_TEXT_SIZE, e->k[0], e->k[1], e->k[2],
+                       e->k[3]);
+}
+
+static double runSolveQuadratic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    SolveQuadratic(e->q[0], e->q[1], e->q[2]);
+    return 0;
+}
+
+static double runSolveCubic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    SolveCubic(e->k[0], e->k[1], e->k[2], e->k[3]);
+    return 0;
+}
+
+static double runCertifyQuadratic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    CertifiedResult result;
+    return CertifyRoots(e->q[0], e->q[1], e->q[2], 0, &result);
+}
+
+static double runAdaptiveQuadratic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    EquationResult result;
+    ComputeAdaptive(e->q[0], e->q[1], e->q[2], 0, &result);
+    return result.count > 0 ? result.roots[0] : 0;
+}
+
+static double runExtendedQuadratic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    EquationResult result;
+    ComputeExtended(e->q[0], e->q[1], e->q[2], 0, &result);
+    return result.count > 0 ? result.roots[0] : 0;
+}
+
+// Кубическое уравнение с d = 0 ComputeAdaptive решала бы как квадратное
+static double runAdaptiveCubic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    EquationResult result;
+    ComputeAdaptive(e->k[0], e->k[1], e->k[2], e->k[3], &result);
+    return result.count > 0 ? result.roots[0] : 0;
+}
+
+static double runExtendedCubic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    EquationResult result;
+    ComputeExtended(e->k[0], e->k[1], e->k[2], e->k[3], &result);
+    return result.count > 0 ? result.roots[0] : 0;
+}
+
+static double runFastCubic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    EquationResult result;
+    ComputeCubicFast(e->k[0], e->k[1], e->k[2], e->k[3], &result);
+    return result.count > 0 ? result.roots[0] : 0;
+}
+
+static double runCertifyCubic(const Equation* e, char* buffer)
+{
+    (void) buffer;
+    CertifiedResult result;
+    return CertifyRoots(e->k[0], e->k[1], e->k[2], e->k[3], &result);
+}
+
+// Решение пакета циклом по уравнениям: каждое уравнение выбирает формулу
+// ветвлениями по степени и знаку дискриминанта внутри ComputeQuadratic и
+// ComputeCubic. С ним сравнивается ComputeBatch, который сначала
+// раскладывает уравнения по случаям расположения корней
+static void batchEach(EquationBatch* batch)
+{
+    for (size_t i = 0; i < batch->count; i++)
+    {
+        EquationResult result = {0, ROOTS_NONE, -1, {0, 0, 0}};
+        if (batch->degree[i] == 2)
+        {
+            ComputeQuadratic(batch->a[i], batch->b[i], batch->c[i], &result);
+        }
+        else if (batch->degree[i] == 3)
+        {
+            ComputeCubic(batch->a[i], batch->b[i], batch->c[i], batch->d[i],
+                         &result);
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            batch->roots[k][i] = k < result.count ? result.roots[k] : 0;
+        }
+        batch->rootCase[i] = (int8_t) result.rootCase;
+        batch->rootCount[i] = (int8_t) result.count;
+    }
+}
+
+static void batchCompute(EquationBatch* batch)
+{
+    ComputeBatch(batch, 0, batch->count);
+}
+
+static void batchFast(EquationBatch* batch)
+{
+    ComputeBatchFast(batch, 0, batch->count);
+}
+
+static const KernelInfo kernels[] = {
+        {"ComputeQuadratic", runComputeQuadratic, NULL},
+        {"FormatQuadratic", runFormatQuadratic, NULL},
+        {"SolveQuadratic", runSolveQuadratic, NULL},
+        {"CertifyQuadratic", runCertifyQuadratic, NULL},
+        {"AdaptiveQuadratic", runAdaptiveQuadratic, NULL},
+        {"ExtendedQuadratic", runExtendedQuadratic, NULL},
+        {"ComputeCubic", runComputeCubic, NULL},
+        {"ComputeSeeded", runComputeSeeded, NULL},
+        {"FormatCubic", runFormatCubic, NULL},
+        {"SolveCubic", runSolveCubic, NULL},
+        {"CertifyCubic", runCertifyCubic, NULL},
+        {"AdaptiveCubic", runAdaptiveCubic, NULL},
+        {"ExtendedCubic", runExtendedCubic, NULL},
+        {"FastCubic", runFastCubic, NULL},
+        {"ComputeEach", NULL, batchEach},
+        {"ComputeBatch", NULL, batchCompute},
+        {"ComputeBatchFast", NULL, batchFast},
+};
+
+// Функция для получения случайного числа из [0, 1)
+static double uniform(unsigned int* seed)
+{
+    return rand_r(seed) / ((double) RAND_MAX + 1);
+}
+
+// Функция для получения случайного ненулевого коэффициента
+static double nonZero(double value)
+{
+    return value != 0 ? value : 1;
+}
+
+// Генератор: равномерно распределённые коэффициенты из [-100, 100]
+static void generateRandom(Equation* e, size_t count, unsigned int* seed)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            e[i].q[j] = 200 * uniform(seed) - 100;
+        }
+        for (int j = 0; j < 4; j++)
+        {
+            e[i].k[j] = 200 * uniform(seed) - 100;
+        }
+        e[i].q[0] = nonZero(e[i].q[0]);
+        e[i].k[0] = nonZero(e[i].k[0]);
+    }
+}
+
+// Генератор: почти кратные корни (дискриминант близок к нулю):
+// a(x - r)^2 и a(x - r)^2(x - s) со слегка возмущённым свободным членом
+static void generateDegenerate(Equation* e, size_t count, unsigned int* seed)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        double a = nonZero(20 * uniform(seed) - 10);
+        double r = 20 * uniform(seed) - 10;
+        double s = 20 * uniform(seed) - 10;
+        double eps = (uniform(seed) - 0.5) * 1e-12;
+        e[i].q[0] = a;
+        e[i].q[1] = -2 * a * r;
+        e[i].q[2] = a * r * r * (1 + eps);
+        e[i].k[0] = a;
+        e[i].k[1] = -a * (2 * r + s);
+        e[i].k[2] = a * (r * r + 2 * r * s);
+        e[i].k[3] = -a * r * r * s * (1 + eps);
+    }
+}
+
+// Генератор: небольшие целые коэффициенты из [-20, 20]
+static void generateInteger(Equation* e, size_t count, unsigned int* seed)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            e[i].q[j] = (double) (rand_r(seed) % 41 - 20);
+        }
+        for (int j = 0; j < 4; j++)
+        {
+            e[i].k[j] = (double) (rand_r(seed) % 41 - 20);
+        }
+        e[i].q[0] = nonZero(e[i].q[0]);
+        e[i].k[0] = nonZero(e[i].k[0]);
+    }
+}
+
+// Функция для получения числа случайного знака с порядком из [-150, 150]
+static double wideValue(unsigned int* seed)
+{
+    double value = pow(10, 300 * uniform(seed) - 150);
+    return rand_r(seed) % 2 ? value : -value;
+}
+
+// Генератор: коэффициенты с порядками от 1e-150 до 1e150
+static void generateWide(Equation* e, size_t count, unsigned int* seed)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            e[i].q[j] = wideValue(seed);
+        }
+        for (int j = 0; j < 4; j++)
+        {
+            e[i].k[j] = wideValue(seed);
+        }
+    }
+}
+
+// Генератор: плавные пути по SWEEP_PATH_LENGTH уравнений между двумя
+// случайными уравнениями из [-100, 100], как при переборе параметра
+static void generateSweep(Equation* e, size_t count, unsigned int* seed)
+{
+    double from[4];
+    double to[4];
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t step = i % SWEEP_PATH_LENGTH;
+        if (step == 0)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                from[j] = 200 * uniform(seed) - 100;
+                to[j] = 200 * uniform(seed) - 100;
+            }
+            // Старший коэффициент не меняет знак и не проходит через 0
+            from[0] = 50 + fabs(from[0]) / 2;
+            to[0] = 50 + fabs(to[0]) / 2;
+        }
+        double t = (double) step / SWEEP_PATH_LENGTH;
+        for (int j = 0; j < 4; j++)
+        {
+            e[i].k[j] = (1 - t) * from[j] + t * to[j];
+        }
+        for (int j = 0; j < 3; j++)
+        {
+            e[i].q[j] = e[i].k[j];
+        }
+    }
+}
+
+// Функция для чтения запросов из журнала сервера. Набор повторяется
+// по кругу до нужного размера
+static size_t loadJournal(const char* path, Equation* e, size_t count)
+{
+    FILE* input = fopen(path, "r");
+    if (input == NULL)
+    {
+        perror("fopen");
+        return 0;
+    }
+    char line[MAXBUF + 64];
+    size_t loaded = 0;
+    while (loaded < count && fgets(line, sizeof(line), input) != NULL)
+    {
+        char* text = strstr(line, JOURNAL_MARKER);
+        if (text == NULL)
+        {
+            continue;
+        }
+        text += strlen(JOURNAL_MARKER);
+        char* end = strchr(text, '"');
+        if (end == NULL)
+        {
+            continue;
+        }
+        *end = '\0';
+        Request request;
+        // Уравнения - только запросы решения и границ корней
+        if (decodeRequest(text, end - text, &request) == -1 ||
+            (request.type != REQUEST_SOLVE && request.type != REQUEST_CERT))
+        {
+            continue;
+        }
+        // Квадратный запрос (d = 0) для кубических функций - уравнение
+        // с корнем x = 0, его тоже можно решать
+        e[loaded].q[0] = request.a;
+        e[loaded].q[1] = request.b;
+        e[loaded].q[2] = request.c;
+        e[loaded].k[0] = request.a;
+        e[loaded].k[1] = request.b;
+        e[loaded].k[2] = request.c;
+        e[loaded].k[3] = request.d;
+        loaded++;
+    }
+    fclose(input);
+    for (size_t i = loaded; loaded > 0 && i < count; i++)
+    {
+        e[i] = e[i % loaded];
+    }
+    return loaded > 0 ? count : 0;
+}
+
+// Сравнение чисел для qsort
+static int compareDouble(const void* x, const void* y)
+{
+    double a = *(const double*) x;
+    double b = *(const double*) y;
+    return (a > b) - (a < b);
+}
+
+// Функция для однократного решения всех уравнений набора
+static double runAll(const KernelInfo* kernel, const InputSet* input,
+                     char* buffer)
+{
+    if (kernel->batch != NULL)
+    {
+        EquationBatch batch = input->batch;
+        kernel->batch(&batch);
+        return batch.roots[0][0];
+    }
+    double acc = 0;
+    for (size_t i = 0; i < input->count; i++)
+    {
+        acc += kernel->run(&input->equations[i], buffer);
+    }
+    return acc;
+}
+
+// Функция для получения медианы показаний счётчика на уравнение (NaN,
+// если счётчик недоступен)
+static double counterMedian(int fd, double* perEquation, int repeats)
+{
+    if (fd == -1)
+    {
+        return NAN;
+    }
+    qsort(perEquation, repeats, sizeof(double), compareDouble);
+    return perEquation[repeats / 2];
+}
+
+// Функция для замера одной функции на одном наборе
+static Result measure(const KernelInfo* kernel, const InputSet* input,
+                      int repeats, const Counters* counters,
+                      volatile double* sink)
+{
+    char buffer[SOLUTION_TEXT_SIZE];
+    double ns[repeats];
+    double cyclesPerEquation[repeats];
+    double branchMisses[repeats];
+    double instructions[repeats];
+
+    // Прогрев: кэши, предсказатель переходов и частота процессора
+    *sink += runAll(kernel, input, buffer);
+
+    for (int r = 0; r < repeats; r++)
+    {
+        CounterValues startValues = readCounters(counters);
+        uint64_t startCycles = cycles();
+        uint64_t start = nowNs();
+        double acc = runAll(kernel, input, buffer);
+        uint64_t elapsed = nowNs() - start;
+        uint64_t elapsedCycles = cycles() - startCycles;
+        CounterValues values = readCounters(counters);
+        *sink += acc;
+        ns[r] = (double) elapsed / input->count;
+        cyclesPerEquation[r] = (double) elapsedCycles / input->count;
+        branchMisses[r] = (double) (values.branchMisses -
+                                    startValues.branchMisses) / input->count;
+        instructions[r] = (double) (values.instructions -
+                                    startValues.instructions) / input->count;
+    }
+    qsort(ns, repeats, sizeof(double), compareDouble);
+    qsort(cyclesPerEquation, repeats, sizeof(double), compareDouble);
+
+    Result result = {kernel->name, input->name, input->count,
+                     ns[repeats / 2], ns[0], cyclesPerEquation[repeats / 2],
+                     counterMedian(counters->branchMisses, branchMisses,
+                                   repeats),
+                     counterMedian(counters->instructions, instructions,
+                                   repeats)};
+    return result;
+}
+
+// Функция для вычисления значения многочлена степени degree в long double.
+// В bound записывается оценка ошибки округления значения
+static long double referenceValue(const double* coef, int degree,
+                                  long double x, long double* derivative,
+                                  long double* bound)
+{
+    long double value = coef[0];
+    long double slope = 0;
+    long double size = fabsl(value);
+    for (int i = 1; i <= degree; i++)
+    {
+        slope = slope * x + value;
+        value = value * x + coef[i];
+        size = size * fabsl(x) + fabsl(coef[i]);
+    }
+    *derivative = slope;
+    *bound = 2 * degree * LDBL_EPSILON * size;
+    return value;
+}
+
+// Функция для точного умножения в long double: x y = *product + *error.
+// Множители делятся на половины мантиссы (разбиение Вельткампа и
+// произведение Деккера), потому что fmal на x86 вычисляется программно
+// и в сотни раз медленнее
+static void referenceProduct(long double x, long double y,
+                             long double* product, long double* error)
+{
+    long double cx = REFERENCE_SPLITTER * x;
+    long double cy = REFERENCE_SPLITTER * y;
+    long double xHigh = cx - (cx - x);
+    long double yHigh = cy - (cy - y);
+    long double xLow = x - xHigh;
+    long double yLow = y - yHigh;
+    *product = x * y;
+    *error = ((xHigh * yHigh - *product) + xHigh * yLow + xLow * yHigh) +
+             xLow * yLow;
+}
+
+// Функция для вычисления значения многочлена компенсированной схемой
+// Горнера в long double: ошибки округления собираются отдельно, и
+// значение получается с точностью порядка LDBL_EPSILON^2 от суммы
+// модулей слагаемых, которая записывается в size
+static long double referenceExact(const double* coef, int degree,
+                                  long double x, long double* size)
+{
+    long double value = coef[0];
+    long double error = 0;
+    *size = fabsl(value);
+    for (int i = 1; i <= degree; i++)
+    {
+        long double product, productError;
+        referenceProduct(value, x, &product, &productError);
+        value = product + coef[i];
+        long double rest = value - product;
+        long double sumError = (product - (value - rest)) + (coef[i] - rest);
+        error = error * x + (productError + sumError);
+        *size = *size * fabsl(x) + fabsl(coef[i]);
+    }
+    return value + error;
+}
+
+// Функция для выбора точки деления отрезка [lo, hi]: 0, если отрезок его
+// содержит, середина, если концы одного порядка, иначе среднее
+// геометрическое концов. Так корень, который намного меньше длины
+// отрезка, находится за десятки шагов, а не за тысячи
+static long double referenceSplit(long double lo, long double hi)
+{
+    if (lo < 0 && hi > 0)
+    {
+        return 0;
+    }
+    long double small = lo >= 0 ? lo : -hi;
+    long double large = lo >= 0 ? hi : -lo;
+    if (large <= 4 * small)
+    {
+        return lo + (hi - lo) / 2;
+    }
+    small = small > LDBL_MIN ? small : LDBL_MIN;
+    long double middle = sqrtl(small) * sqrtl(large);
+    return lo >= 0 ? middle : -middle;
+}
+
+// Функция для уточнения корня многочлена на отрезке [lo, hi], на котором
+// он монотонен (rising - возрастает) и меняет знак: шаги Ньютона, а если
+// шаг выходит за отрезок или уменьшается меньше чем вчетверо - деление
+// отрезка referenceSplit. Вблизи корня, где знак значения в long double
+// не определён, значение вычисляется referenceExact. Поиск
+// заканчивается, когда отрезок перестаёт сужаться
+static long double referenceRoot(const double* coef, int degree,
+                                 long double lo, long double hi, int rising)
+{
+    long double x = referenceSplit(lo, hi);
+    long double previous = hi - lo;
+    for (int i = 0; i < REFERENCE_STEPS; i++)
+    {
+        long double derivative, bound;
+        long double value = referenceValue(coef, degree, x, &derivative,
+                                           &bound);
+        if (fabsl(value) <= bound)
+        {
+            long double size;
+            value = referenceExact(coef, degree, x, &size);
+        }
+        if (value == 0)
+        {
+            break;
+        }
+        if ((value < 0) == rising)
+        {
+            lo = x;
+        }
+        else
+        {
+            hi = x;
+        }
+        long double next = x - value / derivative;
+        if (next == x)
+        {
+            break;
+        }
+        if (!(next > lo && next < hi) ||
+            !(fabsl(next - x) <= previous / 4))
+        {
+            next = referenceSplit(lo, hi);
+        }
+        if (!(next > lo && next < hi))
+        {
+            break;
+        }
+        previous = fabsl(next - x);
+        x = next;
+    }
+    return x;
+}
+
+// Функция для вычисления эталонных корней квадратного (degree = 2) или
+// кубического уравнения. Корни отделяются точками, где производная
+// равна 0, и границей корней Фудзивары, а затем уточняются
+// referenceRoot. Знак многочлена в точках, где производная равна 0,
+// определяет referenceExact; если значение не больше его ошибки, корень
+// кратный. Эталон не использует функции logic.c и вычисляется точнее
+// их: с точностью порядка LDBL_EPSILON^2, а не DBL_EPSILON^2
+static void referenceSolve(const double* coef, int degree,
+                           Reference* reference)
+{
+    // Все корни по модулю меньше границы Фудзивары
+    long double limit = 0;
+    for (int i = 1; i <= degree; i++)
+    {
+        long double ratio = fabsl(coef[i] / (long double) coef[0]);
+        if (i == degree)
+        {
+            ratio /= 2;
+        }
+        long double root = i == 1 ? ratio : i == 2 ? sqrtl(ratio)
+                                                   : cbrtl(ratio);
+        limit = root > limit ? root : limit;
+    }
+    limit *= 4;
+    reference->count = 0;
+    if (limit == 0)
+    {
+        reference->roots[reference->count++] = 0; // a x^n = 0
+        return;
+    }
+
+    // Точки, где производная равна 0: отделяют корни друг от друга.
+    // У тройного корня кубического уравнения они совпадают
+    long double ends[4];
+    int endCount = 0;
+    ends[endCount++] = -limit;
+    if (degree == 2)
+    {
+        ends[endCount++] = -coef[1] / (2 * (long double) coef[0]);
+    }
+    else
+    {
+        long double a = 3 * (long double) coef[0];
+        long double b = coef[1];
+        long double disc = b * b - a * coef[2];
+        if (disc >= 0)
+        {
+            long double t = b >= 0 ? -b - sqrtl(disc) : -b + sqrtl(disc);
+            long double x1 = t / a;
+            long double x2 = t != 0 ? coef[2] / t : x1;
+            ends[endCount++] = x1 < x2 ? x1 : x2;
+            ends[endCount++] = x1 < x2 ? x2 : x1;
+        }
+    }
+    ends[endCount++] = limit;
+
+    // На отрезках между ними многочлен монотонен. Знак на -limit
+    // определяет старший коэффициент
+    int previous = (degree == 2) == (coef[0] > 0) ? 1 : -1;
+    int rising = previous < 0;
+    for (int i = 1; i < endCount; i++)
+    {
+        int sign = coef[0] > 0 ? 1 : -1;
+        if (i < endCount - 1)
+        {
+            long double size;
+            long double value = referenceExact(coef, degree, ends[i], &size);
+            sign = value > 0 ? 1 : value < 0 ? -1 : 0;
+            if (fabsl(value) <= REFERENCE_DOUBLE_MARGIN * LDBL_EPSILON *
+                                LDBL_EPSILON * size)
+            {
+                // Кратный корень в точке, где производная равна 0
+                reference->roots[reference->count++] = ends[i];
+                sign = 0;
+            }
+        }
+        if (previous * sign < 0)
+        {
+            reference->roots[reference->count++] =
+                referenceRoot(coef, degree, ends[i - 1], ends[i], rising);
+        }
+        previous = sign;
+        rising = !rising;
+    }
+}
+
+// Функция для получения корней решения в порядке возрастания
+static void sortedRoots(const EquationResult* result, double roots[3])
+{
+    for (int k = 0; k < result->count; k++)
+    {
+        roots[k] = result->roots[k];
+    }
+    qsort(roots, result->count, sizeof(double), compareDouble);
+}
+
+// Функция для проверки решения: количество корней и корни совпадают
+// с эталоном с точностью ROOT_MISMATCH
+static int sameRoots(const EquationResult* result,
+                     const Reference* reference)
+{
+    if (result->count != reference->count)
+    {
+        return 0;
+    }
+    double roots[3];
+    sortedRoots(result, roots);
+    for (int k = 0; k < result->count; k++)
+    {
+        long double error = fabsl(roots[k] - reference->roots[k]);
+        if (!(error <= ROOT_MISMATCH * fabsl(reference->roots[k])))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Функция для сравнения ComputeAdaptive и решения в double с эталоном:
+// сколько уравнений каждого набора решается заново и сколько решений
+// неверны
+static void reportAdaptive(FILE* report, const InputSet* inputs,
+                           int inputCount)
+{
+    fprintf(report, "\nПовышение точности: решено заново и неверных "
+                    "решений (корень отличается от эталона\nбольше чем "
+                    "на %g от него), %% уравнений\n",
+            ROOT_MISMATCH);
+    fprintf(report, "набор       степень     заново     double   adaptive\n");
+    for (int i = 0; i < inputCount; i++)
+    {
+        for (int degree = 2; degree <= 3; degree++)
+        {
+            size_t escalated = 0;
+            size_t plainWrong = 0;
+            size_t adaptiveWrong = 0;
+            for (size_t j = 0; j < inputs[i].count; j++)
+            {
+                const Equation* e = &inputs[i].equations[j];
+                const double* coef = degree == 2 ? e->q : e->k;
+                double d = degree == 2 ? 0 : e->k[3];
+                EquationResult plain, adaptive;
+                Reference reference;
+                if (d == 0)
+                {
+                    ComputeQuadratic(coef[0], coef[1], coef[2], &plain);
+                }
+                else
+                {
+                    ComputeCubic(coef[0], coef[1], coef[2], d, &plain);
+                }
+                escalated += ComputeAdaptive(coef[0], coef[1], coef[2], d,
+                                             &adaptive);
+                referenceSolve(coef, d == 0 ? 2 : 3, &reference);
+                plainWrong += !sameRoots(&plain, &reference);
+                adaptiveWrong += !sameRoots(&adaptive, &reference);
+            }
+            double scale = 100.0 / inputs[i].count;
+            fprintf(report, "%-11s %7d %10.3f %10.3f %10.3f\n",
+                    inputs[i].name, degree, escalated * scale,
+                    plainWrong * scale, adaptiveWrong * scale);
+        }
+    }
+}
+
+// Функция для вычисления ошибки корней относительно эталона, отнесённой
+// к наибольшему по модулю корню, в единицах DBL_EPSILON
+static double rootError(const EquationResult* result,
+                        const Reference* reference)
+{
+    double roots[3];
+    sortedRoots(result, roots);
+    long double error = 0;
+    long double scale = 0;
+    for (int k = 0; k < result->count; k++)
+    {
+        long double difference = fabsl(roots[k] - reference->roots[k]);
+        error = difference > error ? difference : error;
+        long double size = fabsl(reference->roots[k]);
+        scale = size > scale ? size : scale;
+    }
+    return (double) ((scale > 0 ? error / scale : error) / DBL_EPSILON);
+}
+
+// Функция для проверки, что все корни конечны
+static int finiteRoots(const EquationResult* result)
+{
+    for (int k = 0; k < result->count; k++)
+    {
+        if (!isfinite(result->roots[k]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Функция для сравнения точности ComputeCubic (cbrt, acos и cos из libm)
+// и ComputeCubicFast с эталоном: медиана, 99-й перцентиль
+// и наибольшая ошибка корней на каждом наборе. Наибольшую ошибку
+// определяют плохо обусловленные уравнения, медиану - точность функций.
+// Уравнения, у которых приведённое уравнение переполняется (корни не
+// конечны) или случай расположения корней неверен, не учитываются
+static int reportFast(FILE* report, const InputSet* inputs, int inputCount)
+{
+    fprintf(report, "\nПриближённые функции: ошибка корней кубических "
+                    "уравнений относительно эталона\n"
+                    "(в долях наибольшего корня), единиц DBL_EPSILON: "
+                    "libm / fast\n");
+    fprintf(report, "набор       медиана            99%%                "
+                    "наибольшая\n");
+    for (int i = 0; i < inputCount; i++)
+    {
+        double* libm = malloc(sizeof(double) * inputs[i].count);
+        double* fast = malloc(sizeof(double) * inputs[i].count);
+        if (libm == NULL || fast == NULL)
+        {
+            perror("malloc");
+            free(libm);
+            free(fast);
+            return -1;
+        }
+        size_t n = 0;
+        for (size_t j = 0; j < inputs[i].count; j++)
+        {
+            const double* k = inputs[i].equations[j].k;
+            EquationResult plain, approximate;
+            Reference reference;
+            ComputeCubic(k[0], k[1], k[2], k[3], &plain);
+            ComputeCubicFast(k[0], k[1], k[2], k[3], &approximate);
+            referenceSolve(k, 3, &reference);
+            if (plain.count == reference.count &&
+                approximate.count == reference.count &&
+                finiteRoots(&plain) && finiteRoots(&approximate))
+            {
+                libm[n] = rootError(&plain, &reference);
+                fast[n] = rootError(&approximate, &reference);
+                n++;
+            }
+        }
+        if (n > 0)
+        {
+            qsort(libm, n, sizeof(double), compareDouble);
+            qsort(fast, n, sizeof(double), compareDouble);
+            size_t median = n / 2;
+            size_t tail = (size_t) (0.99 * (n - 1));
+            fprintf(report, "%-11s %8.3g / %-8.3g %8.3g / %-8.3g "
+                            "%8.3g / %-8.3g\n", inputs[i].name,
+                    libm[median], fast[median], libm[tail], fast[tail],
+                    libm[n - 1], fast[n - 1]);
+        }
+        free(libm);
+        free(fast);
+    }
+    return 0;
+}
+
+// Функции для вывода показания счётчика: в таблицу (прочерк, если
+// счётчик недоступен) и в CSV или JSON (вместо NaN - missing)
+static void printCounter(FILE* out, double value, int width)
+{
+    if (isnan(value))
+    {
+        fprintf(out, " %*s", width - 1, "-");
+        return;
+    }
+    fprintf(out, " %*.2f", width - 1, value);
+}
+
+static void printValue(FILE* out, double value, const char* missing)
+{
+    if (isnan(value))
+    {
+        fputs(missing, out);
+        return;
+    }
+    fprintf(out, "%.3f", value);
+}
+
+// Функция для составления пакета из уравнений набора. В наборах, где
+// у каждой строки есть и квадратное, и кубическое уравнение, степень
+// выбирается случайно: ветвление по степени не угадать
+static int makeBatch(InputSet* input, int mixed, unsigned int seed)
+{
+    EquationBatch* batch = &input->batch;
+    size_t count = input->count;
+    batch->count = count;
+    batch->a = malloc(sizeof(double) * count);
+    batch->b = malloc(sizeof(double) * count);
+    batch->c = malloc(sizeof(double) * count);
+    batch->d = malloc(sizeof(double) * count);
+    batch->degree = malloc(count);
+    for (int k = 0; k < 3; k++)
+    {
+        batch->roots[k] = malloc(sizeof(double) * count);
+    }
+    batch->rootCase = malloc(count);
+    batch->rootCount = malloc(count);
+    if (batch->a == NULL || batch->b == NULL || batch->c == NULL ||
+        batch->d == NULL || batch->degree == NULL || batch->roots[0] == NULL ||
+        batch->roots[1] == NULL || batch->roots[2] == NULL ||
+        batch->rootCase == NULL || batch->rootCount == NULL)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const Equation* e = &input->equations[i];
+        int quadratic = mixed ? rand_r(&seed) % 2 : e->k[3] == 0;
+        batch->a[i] = quadratic ? e->q[0] : e->k[0];
+        batch->b[i] = quadratic ? e->q[1] : e->k[1];
+        batch->c[i] = quadratic ? e->q[2] : e->k[2];
+        batch->d[i] = quadratic ? 0 : e->k[3];
+        batch->degree[i] = quadratic ? 2 : 3;
+    }
+    return 0;
+}
+
+static void freeBatch(EquationBatch* batch)
+{
+    free(batch->a);
+    free(batch->b);
+    free(batch->c);
+    free(batch->d);
+    free(batch->degree);
+    for (int k = 0; k < 3; k++)
+    {
+        free(batch->roots[k]);
+    }
+    free(batch->rootCase);
+    free(batch->rootCount);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = DEFAULT_COUNT;
+    int repeats = DEFAULT_REPEATS;
+    unsigned int seed = 1;
+    const char* journal = NULL;
+    const char* csvPath = NULL;
+    const char* jsonPath = NULL;
+    const char* filter = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:s:f:c:j:k:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                count = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            case 's':
+                seed = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                journal = optarg;
+                break;
+            case 'c':
+                csvPath = optarg;
+                break;
+            case 'j':
+                jsonPath = optarg;
+                break;
+            case 'k':
+                filter = optarg;
+                break;
+            default:
+                fprintf(stderr, "Использование: %s [-n equations] "
+                                "[-r repeats] [-s seed] [-f server.log] "
+                                "[-k kernel] [-c results.csv] "
+                                "[-j results.json]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (count < 1 || repeats < 1)
+    {
+        fprintf(stderr, "Количество уравнений и повторов должно быть "
+                        "положительным.\n");
+        return 1;
+    }
+
+    // Наборы входных данных; один и тот же seed даёт одни и те же наборы
+    InputSet inputs[6];
+    int inputCount = 0;
+    void (*generators[])(Equation*, size_t, unsigned int*) = {
+            generateRandom, generateDegenerate, generateInteger,
+            generateWide, generateSweep};
+    const char* generatorNames[] = {"random", "degenerate", "integer",
+                                    "wide", "sweep"};
+    for (int g = 0; g < 5; g++)
+    {
+        Equation* equations = malloc(sizeof(Equation) * count);
+        if (equations == NULL)
+        {
+            perror("malloc");
+            return 1;
+        }
+        unsigned int generatorSeed = seed + g;
+        generators[g](equations, count, &generatorSeed);
+        inputs[inputCount] = (InputSet) {generatorNames[g], equations,
+                                         count, {0}};
+        if (makeBatch(&inputs[inputCount++], 1, generatorSeed) == -1)
+        {
+            perror("malloc");
+            return 1;
+        }
+    }
+    if (journal != NULL)
+    {
+        Equation* equations = malloc(sizeof(Equation) * count);
+        if (equations == NULL)
+        {
+            perror("malloc");
+            return 1;
+        }
+        if (loadJournal(journal, equations, count) == 0)
+        {
+            fprintf(stderr, "В журнале %s нет запросов.\n", journal);
+            free(equations);
+        }
+        else
+        {
+            inputs[inputCount] = (InputSet) {"journal", equations, count,
+                                             {0}};
+            if (makeBatch(&inputs[inputCount++], 0, seed) == -1)
+            {
+                perror("malloc");
+                return 1;
+            }
+        }
+    }
+
+    // Solve* выводят решение на экран: направляем вывод в /dev/null,
+    // а таблицу результатов печатаем в stderr
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || freopen("/dev/null", "w", stdout) == NULL)
+    {
+        perror("freopen");
+        return 1;
+    }
+    FILE* report = fdopen(console, "w");
+
+    size_t kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+    Result* results = malloc(sizeof(Result) * kernelCount * inputCount);
+    if (results == NULL || report == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+    int resultCount = 0;
+    volatile double sink = 0;
+    Counters counters;
+    if (!openCounters(&counters))
+    {
+        fprintf(report, "Счётчики процессора недоступны (perf_event_open): "
+                        "промахи и команды не замеряются.\n");
+    }
+
+    // Заголовок выровнен вручную: printf считает ширину в байтах
+    fprintf(report, "функция            набор       нс (медиана)"
+                    "     нс (мин)  тактов (мед.)  промахов   команд\n");
+    for (size_t k = 0; k < kernelCount; k++)
+    {
+        if (filter != NULL && strstr(kernels[k].name, filter) == NULL)
+        {
+            continue;
+        }
+        for (int i = 0; i < inputCount; i++)
+        {
+            Result result = measure(&kernels[k], &inputs[i], repeats,
+                                    &counters, &sink);
+            results[resultCount++] = result;
+            fprintf(report, "%-18s %-11s %12.1f %12.1f %14.1f",
+                    result.kernel, result.input, result.nsMedian,
+                    result.nsMin, result.cyclesMedian);
+            printCounter(report, result.branchMissesMedian, 10);
+            printCounter(report, result.instructionsMedian, 9);
+            fprintf(report, "\n");
+            fflush(report);
+        }
+    }
+
+    if (filter == NULL || strstr("AdaptiveQuadratic AdaptiveCubic",
+                                 filter) != NULL)
+    {
+        reportAdaptive(report, inputs, inputCount);
+    }
+    if (filter == NULL || strstr("FastCubic ComputeBatchFast",
+                                 filter) != NULL)
+    {
+        if (reportFast(report, inputs, inputCount) == -1)
+        {
+            return 1;
+        }
+    }
+
+    // Результаты в машиночитаемом виде для сравнения между версиями
+    if (csvPath != NULL)
+    {
+        FILE* csv = fopen(csvPath, "w");
+        if (csv == NULL)
+        {
+            perror("fopen");
+            return 1;
+        }
+        fprintf(csv, "kernel,input,equations,ns_median,ns_min,"
+                     "cycles_median,branch_misses_median,"
+                     "instructions_median\n");
+        for (int i = 0; i < resultCount; i++)
+        {
+            fprintf(csv, "%s,%s,%zu,%.3f,%.3f,%.3f,", results[i].kernel,
+                    results[i].input, results[i].count,
+                    results[i].nsMedian, results[i].nsMin,
+                    results[i].cyclesMedian);
+            printValue(csv, results[i].branchMissesMedian, "");
+            fprintf(csv, ",");
+            printValue(csv, results[i].instructionsMedian, "");
+            fprintf(csv, "\n");
+        }
+        fclose(csv);
+    }
+    if (jsonPath != NULL)
+    {
+        FILE* json = fopen(jsonPath, "w");
+        if (json == NULL)
+        {
+            perror("fopen");
+            return 1;
+        }
+        fprintf(json, "{\"seed\":%u,\"repeats\":%d,\"results\":[\n", seed,
+                repeats);
+        for (int i = 0; i < resultCount; i++)
+        {
+            fprintf(json, "{\"kernel\":\"%s\",\"input\":\"%s\","
+                          "\"equations\":%zu,\"ns_median\":%.3f,"
+                          "\"ns_min\":%.3f,\"cycles_median\":%.3f,"
+                          "\"branch_misses_median\":",
+                    results[i].kernel, results[i].input, results[i].count,
+                    results[i].nsMedian, results[i].nsMin,
+                    results[i].cyclesMedian);
+            printValue(json, results[i].branchMissesMedian, "null");
+            fprintf(json, ",\"instructions_median\":");
+            printValue(json, results[i].instructionsMedian, "null");
+            fprintf(json, "}%s\n", i + 1 < resultCount ? "," : "");
+        }
+        fprintf(json, "]}\n");
+        fclose(json);
+    }
+
+    closeCounters(&counters);
+    for (int i = 0; i < inputCount; i++)
+    {
+        free(inputs[i].equations);
+        freeBatch(&inputs[i].batch);
+    }
+    free(results);
+    fclose(report);
+    return sink == 12345.0; // sink читается, чтобы вычисления не исчезли
+}
@@ -0,0 +1,21 @@
+/*!
+ * \file bench_logic.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение основной функции
+ * микротеста решателя уравнений.
+*/
+
+#ifndef INC_6_LAB_BENCH_LOGIC_H
+#define INC_6_LAB_BENCH_LOGIC_H
+
+/*!
+ * \brief Измеряет время решения уравнений на наборах входных данных
+ * и записывает результаты в CSV и JSON
+ * \param[in] argc Количество аргументов командной строки
+ * \param[in] argv Массив указателей на строки, содержащие аргументы
+ * \return Код завершения
+ */
+int main(int argc, char* argv[]);
+
+#endif //INC_6_LAB_BENCH_LOGIC_H
@@ -0,0 +1,70 @@
+#!/bin/sh
+# Сравнение пакетного решателя solve_file с решением тех же уравнений
+# через сервер (client -f и отдельный процесс client на уравнение).
+#
+# Использование: ./bench_solve_file.sh [уравнений] [потоков]
+# Создаёт во временном каталоге текстовый файл со случайными квадратными
+# и кубическими уравнениями и его двоичную и столбцовую копии, затем
+# выводит время и пропускную способность каждого способа.
+
+COUNT=${1:-2000000}
+THREADS=${2:-$(nproc)}
+CLIENT_COUNT=20000 # уравнений для client -f
+PROCESS_COUNT=200 # уравнений для отдельных процессов client
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+awk -v n="$COUNT" 'BEGIN {
+    srand(1)
+    for (i = 0; i < n; i++) {
+        a = rand() * 20 - 10; if (a == 0) a = 1
+        if (i % 2)
+            printf "%f %f %f\n", a, rand() * 20 - 10, rand() * 20 - 10
+        else
+            printf "%f %f %f %f\n", a, rand() * 20 - 10, rand() * 20 - 10,
+                   rand() * 20 - 10
+    }
+}' > "$DIR/eq.txt"
+./solve_file -O coef "$DIR/eq.txt" "$DIR/eq.bin" > /dev/null
+./solve_file -O columns "$DIR/eq.txt" "$DIR/eq.cols" > /dev/null
+
+echo "== solve_file, текст -> текст, 1 поток"
+./solve_file -j 1 "$DIR/eq.txt" "$DIR/out.txt"
+echo "== solve_file, текст -> текст, $THREADS потоков"
+./solve_file -j "$THREADS" "$DIR/eq.txt" "$DIR/out.txt"
+echo "== solve_file, текст -> текст (-p 4), $THREADS потоков"
+./solve_file -j "$THREADS" -p 4 "$DIR/eq.txt" "$DIR/out.txt"
+echo "== solve_file, двоичный -> двоичный, 1 поток"
+./solve_file -j 1 -b -O binary "$DIR/eq.bin" "$DIR/out.bin"
+echo "== solve_file, двоичный -> двоичный, $THREADS потоков"
+./solve_file -j "$THREADS" -b -O binary "$DIR/eq.bin" "$DIR/out.bin"
+echo "== solve_file, столбцовый -> столбцовый, $THREADS потоков"
+./solve_file -j "$THREADS" -O columns "$DIR/eq.cols" "$DIR/out.cols"
+
+./server -o silent -l /dev/null > /dev/null &
+pid=$!
+sleep 1
+
+echo "== client -f, $CLIENT_COUNT уравнений"
+head -n "$CLIENT_COUNT" "$DIR/eq.txt" > "$DIR/client.txt"
+start=$(date +%s.%N)
+./client -f "$DIR/client.txt" -l /dev/null > /dev/null
+end=$(date +%s.%N)
+echo "$start $end $CLIENT_COUNT" |
+    awk '{ printf "время: %.3f с, %.0f уравнений/с\n", $2 - $1,
+                  $3 / ($2 - $1) }'
+
+echo "== отдельный процесс client на уравнение, $PROCESS_COUNT уравнений"
+head -n "$PROCESS_COUNT" "$DIR/eq.txt" > "$DIR/process.txt"
+start=$(date +%s.%N)
+while read -r a b c d; do
+    ./client -a "$a" -b "$b" -c "$c" ${d:+-d "$d"} -l /dev/null > /dev/null
+done < "$DIR/process.txt"
+end=$(date +%s.%N)
+echo "$start $end $PROCESS_COUNT" |
+    awk '{ printf "время: %.3f с, %.0f уравнений/с\n", $2 - $1,
+                  $3 / ($2 - $1) }'
+
+kill "$pid"
+wait "$pid" 2> /dev/null
@@ -0,0 +1,120 @@
+/*! Микротест колеса таймеров */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "bench_timers.h"
+#include "timerwheel.h"
+
+#define MAX_DELAY_MS 600000 // наибольшая задержка таймера (10 минут)
+
+static TimerWheel wheel;
+static unsigned long fired; // сработавших таймеров
+static unsigned long early; // сработавших раньше срока
+static unsigned long late;  // сработавших позже срока
+
+// Обработчик срабатывания: проверяет, что таймер сработал в свой шаг
+static void onTimer(Timer* timer)
+{
+    // Колесо увеличивает текущий момент до вызова обработчиков
+    uint64_t moment = wheel.current - 1;
+    if (timer->expires > moment)
+    {
+        early++;
+    }
+    else if (timer->expires < moment)
+    {
+        late++;
+    }
+    fired++;
+}
+
+// Функция для получения времени в наносекундах
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char* argv[])
+{
+    long count = 1000000; // количество таймеров
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                count = atol(optarg);
+                break;
+            default:
+                fprintf(stderr, "Использование: %s [-n timers]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (count < 2)
+    {
+        fprintf(stderr, "Количество таймеров должно быть больше 1.\n");
+        return 1;
+    }
+
+    Timer* timers = calloc(count, sizeof(Timer));
+    if (timers == NULL || timerWheelInit(&wheel, 0) == -1)
+    {
+        perror("calloc");
+        return 1;
+    }
+    unsigned int seed = 12345u;
+    for (long i = 0; i < count; i++)
+    {
+        timers[i].callback = onTimer;
+    }
+
+    // Запуск таймеров со сроками до 10 минут: все уровни, кроме верхнего
+    double start = nowNs();
+    for (long i = 0; i < count; i++)
+    {
+        timerAdd(&wheel, &timers[i], 1 + rand_r(&seed) % MAX_DELAY_MS);
+    }
+    double addNs = (nowNs() - start) / count;
+
+    // Перезапуск каждого таймера, как при продлении срока запроса
+    start = nowNs();
+    for (long i = 0; i < count; i++)
+    {
+        timerCancel(&wheel, &timers[i]);
+        timerAdd(&wheel, &timers[i], 1 + rand_r(&seed) % MAX_DELAY_MS);
+    }
+    double rearmNs = (nowNs() - start) / count;
+
+    // Отмена половины таймеров, как при своевременном ответе
+    start = nowNs();
+    for (long i = 0; i < count; i += 2)
+    {
+        timerCancel(&wheel, &timers[i]);
+    }
+    double cancelNs = (nowNs() - start) / ((count + 1) / 2);
+
+    // Продвижение колеса по всем шагам до последнего срока
+    start = nowNs();
+    timerAdvance(&wheel, MAX_DELAY_MS);
+    double advanceMs = (nowNs() - start) / 1e6;
+
+    printf("Таймеров: %ld\n", count);
+    printf("Запуск: %.1f нс, перезапуск: %.1f нс, отмена: %.1f нс\n",
+           addNs, rearmNs, cancelNs);
+    printf("Продвижение на %d мс: %.1f мс, сработало %lu "
+           "(%.1f нс на таймер)\n", MAX_DELAY_MS, advanceMs, fired,
+           fired > 0 ? advanceMs * 1e6 / fired : 0);
+    printf("Раньше срока: %lu, позже срока: %lu, осталось: %zu\n",
+           early, late, wheel.count);
+
+    timerWheelDestroy(&wheel);
+    free(timers);
+    return early > 0 || late > 0 || wheel.count > 0 ||
+           fired != (unsigned long) (count / 2);
+}
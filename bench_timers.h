@@ -0,0 +1,20 @@
+/*!
+ * \file bench_timers.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение основной функции
+ * микротеста колеса таймеров.
+*/
+
+#ifndef INC_6_LAB_BENCH_TIMERS_H
+#define INC_6_LAB_BENCH_TIMERS_H
+
+/*!
+ * \brief Измеряет время запуска, отмены и срабатывания таймеров колеса
+ * \param[in] argc Количество аргументов командной строки
+ * \param[in] argv Массив указателей на строки, содержащие аргументы
+ * \return Код завершения
+ */
+int main(int argc, char* argv[]);
+
+#endif //INC_6_LAB_BENCH_TIMERS_H
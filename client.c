@@ -5,49 +5,140 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
 
 #include "client.h"
 #include "interface.h"
 #include "signals.h"
+#include "protocol.h"
+#include "aclient.h"
+#include "address.h"
+#include "crash.h"
+#include "gridclient.h"
+
+#define DEFAULT_IN_FLIGHT 256 // запросов в полёте по умолчанию
+#define DEFAULT_RETRIES 3 // повторных отправок по умолчанию
+#define DEFAULT_ATTEMPT_MS 1000 // ожидание ответа на одну попытку, мс
+
+// Обработчик завершения запроса: выводит ответ сервера
+static void onReply(AsyncRequest* request, void* context)
+{
+    (void) context;
+    if (request->status == ASYNC_OK)
+    {
+        // Выводим ответ сервера на экран и в файл журнала
+        const char* message = request->message + request->idLength;
+        printf("Получен ответ на запрос \"%s\":\n%s", message, request->reply);
+        writeLog("Получен ответ на запрос \"%s\":\n%s", message,
+                 request->reply);
+    }
+    else if (request->status == ASYNC_BUSY)
+    {
+        fprintf(stderr, "Сервер занят, запрос \"%s\" отклонён после %d "
+                        "попыток.\n", request->message + request->idLength,
+                request->attempt + 1);
+        writeLog("Сервер занят, запрос \"%s\" отклонён после %d попыток.\n",
+                 request->message + request->idLength, request->attempt + 1);
+    }
+    else
+    {
+        fprintf(stderr, "Нет ответа на запрос \"%s\" после %d попыток.\n",
+                request->message + request->idLength, request->attempt);
+        writeLog("Нет ответа на запрос \"%s\" после %d попыток.\n",
+                 request->message + request->idLength, request->attempt);
+    }
+}
 
-#define PORT 5555
-#define MAXDATASIZE 1024
+// Обработчик истечения времени работы клиента (опция -t)
+static void deadlineExpired(Timer* timer)
+{
+    (void) timer;
+    timeoutHandler();
+}
 
-// Переменная для хранения дескриптора файла журнала
-extern FILE* logfd;
+// Отправляет запрос, дожидаясь свободной ячейки
+static void submit(AsyncClient* client, const Request* request)
+{
+    AsyncRequest* sent;
+    while ((sent = asyncClientSubmit(client, request, NULL)) == NULL)
+    {
+        if (asyncClientPoll(client, -1) == -1)
+        {
+            exit(1);
+        }
+    }
+    // Выводим информацию об отправленном запросе на экран и в файл журнала
+    printf("Отправлен запрос: %s\n", sent->message + sent->idLength);
+    writeLog("Отправлен запрос: %s\n", sent->message + sent->idLength);
+}
 
-int main(int argc, char *argv[])
+// Отправляет все уравнения из файла, по одному в строке
+static int submitFile(AsyncClient* client, const ClientOptions* options)
 {
-    int sockfd; // Дескриптор сокета
-    char buffer[MAXDATASIZE]; // Буфер для приема и отправки данных
-    struct sockaddr_in servAddr; // Структура адреса сервера
+    FILE* input = strcmp(options->inputFile, "-") == 0 ?
+                  stdin : fopen(options->inputFile, "r");
+    if (input == NULL)
+    {
+        perror("fopen");
+        return -1;
+    }
+
+    char line[MAXBUF];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), input) != NULL)
+    {
+        lineNumber++;
+        Request request;
+        if (decodeRequest(line, strlen(line), &request) == -1)
+        {
+            fprintf(stderr, "Строка %d: неверный формат уравнения.\n",
+                    lineNumber);
+            continue;
+        }
+        // Ответ на запрос сетки - много датаграмм, его получает опция -g
+        if (request.type == REQUEST_GRID)
+        {
+            fprintf(stderr, "Строка %d: сетку можно запросить только "
+                            "опцией -g.\n", lineNumber);
+            continue;
+        }
+        if (options->certified && request.type == REQUEST_SOLVE)
+        {
+            request.type = REQUEST_CERT;
+        }
+        submit(client, &request);
+    }
+    if (input != stdin)
+    {
+        fclose(input);
+    }
+    return 0;
+}
 
-    // Объявляем переменные для коэффициентов уравнения
-    double a = 0;
-    double b = 0;
-    double c = 0;
-    double d = 0; // Добавляем переменную для четвертого коэффициента
+int main(int argc, char *argv[])
+{
+    SocketAddress servers[MAX_SERVERS]; // Адреса серверов
 
-    // Устанавливаем обработчики сигналов SIGINT, SIGTERM и SIGSEGV
+    // Устанавливаем обработчики сигналов SIGINT и SIGTERM, а для
+    // аварийных сигналов - обработчик с отчётом о сбое
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
-    signal(SIGSEGV, signalHandler);
+    crashInit(-1);
 
-    // Объявляем и инициализируем переменные для хранения аргументов командной строки
-    char *logFile = NULL; // Имя файла журнала
-    int timeout = 0; // время ожидания ввода пользователя в секундах
+    // Объявляем и инициализируем параметры запуска значениями по умолчанию
+    ClientOptions options;
+    memset(&options, 0, sizeof(options));
+    options.inFlight = DEFAULT_IN_FLIGHT;
+    options.retries = DEFAULT_RETRIES;
+    options.attemptTimeoutMs = DEFAULT_ATTEMPT_MS;
+    options.port = DEFAULT_PORT;
 
     // Вызываем функцию для обработки коэффициентов уравнения из командной строки
-    int result = ParseArgsClient(argc, argv, &logFile, &timeout, &a, &b, &c,
-                                 &d);
+    int result = ParseArgsClient(argc, argv, &options);
 
     char* logFileName = "client.log";
 
     // Открываем файл журнала
-    openLog(&logFile, logFileName);
+    openLog(&options.logFile, logFileName);
 
     // Проверяем результат функции
     if (result != 0) {
@@ -56,53 +147,93 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
-    // Создаем сокет с протоколом UDP
-    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    // Проверяем на ошибки
-    if (sockfd == -1) {
-        perror("socket");
+    // Адреса серверов: IPv4, IPv6 или имя узла, возможно, с портом
+    if (options.hostCount == 0) {
+        options.hosts[options.hostCount++] = DEFAULT_HOST;
+    }
+    for (int i = 0; i < options.hostCount; i++) {
+        if (addressParse(options.hosts[i], options.port,
+                         &servers[i]) == -1) {
+            fprintf(stderr, "Неверный адрес сервера: %s\n", options.hosts[i]);
+            writeLog("Неверный адрес сервера: %s\n", options.hosts[i]);
+            exit(1);
+        }
+    }
+
+    // Сетка запрашивается блоками у первого сервера, решения выводятся
+    // на экран без описания запросов
+    if (options.grid != NULL) {
+        char line[MAXBUF];
+        Request grid;
+        snprintf(line, sizeof(line), "%s%s", GRID_PREFIX, options.grid);
+        if (decodeRequest(line, strlen(line), &grid) == -1 ||
+            grid.type != REQUEST_GRID) {
+            fprintf(stderr, "Неверная сетка коэффициентов: %s\n",
+                    options.grid);
+            writeLog("Неверная сетка коэффициентов: %s\n", options.grid);
+            exit(1);
+        }
+        int failed = gridFetch(&servers[0], &grid, options.attemptTimeoutMs,
+                               options.retries, stdout) == -1;
+        closeLog();
+        return failed;
+    }
+
+    // Все запросы выполняются в одном потоке асинхронным клиентом
+    AsyncClient client;
+    if (asyncClientInit(&client, servers, options.hostCount,
+                        options.inFlight, options.attemptTimeoutMs,
+                        options.retries, onReply) == -1) {
         exit(1);
     }
 
-    servAddr.sin_family = AF_INET; // семейство адресов IPv4
-    servAddr.sin_addr.s_addr = inet_addr(
-            "127.0.0.1"); // адрес сервера (локальный)
-    servAddr.sin_port = htons(PORT); // порт
+    // Срок работы клиента ведёт то же колесо таймеров, что и сроки
+    // ожидания ответов
+    Timer deadline = {NULL, NULL, 0, deadlineExpired};
+    if (options.timeout > 0) {
+        timerAdd(&client.wheel, &deadline,
+                 monotonicMs() + (uint64_t) options.timeout * 1000);
+    }
 
-    // Формируем строку с коэффициентами уравнения в зависимости от количества аргументов
-    if (d == 0) {
-        sprintf(buffer, "%lf %lf %lf", a, b, c);
+    if (options.inputFile != NULL) {
+        if (submitFile(&client, &options) == -1) {
+            exit(1);
+        }
     } else {
-        sprintf(buffer, "%lf %lf %lf %lf", a, b, c, d);
+        // Формируем один запрос из аргументов командной строки
+        Request request = {
+            .type = options.certified ? REQUEST_CERT : REQUEST_SOLVE,
+            .a = options.a, .b = options.b, .c = options.c, .d = options.d
+        };
+        if (options.stats) {
+            request.type = REQUEST_STATS;
+        }
+        submit(&client, &request);
     }
 
-    // Отправляем данные серверу с помощью функции sendto
-    if (sendto(sockfd, buffer, strlen(buffer), 0,
-               (struct sockaddr *) &servAddr, sizeof(servAddr)) == -1) {
-        perror("sendto");
-        exit(1);
+    // Дожидаемся ответов на все запросы
+    while (client.inFlight > 0) {
+        if (asyncClientPoll(&client, -1) == -1) {
+            exit(1);
+        }
     }
 
-    // Выводим информацию об отправленном запросе на экран и в файл журнала
-    printf("Отправлен запрос: %s\n", buffer);
-    writeLog("Отправлен запрос: %s\n", buffer);
-
-    // Устанавливаем таймер неактивности пользователя
-    setTimer(timeout);
-
-    // Принимаем данные от сервера с помощью функции recvfrom
-    int numbytes = recvfrom(sockfd, buffer, MAXDATASIZE - 1, 0,
-                            NULL, NULL);
-    // Проверяем на ошибки
-    if (numbytes == -1) {
-        perror("recvfrom");
-        exit(1);
+    writeLog("Отправлено датаграмм: %lu (повторных: %lu), ответов: %lu, "
+             "без ответа: %lu, отклонено: %lu\n", client.sent,
+             client.retransmits, client.completed, client.failed,
+             client.busy);
+    // С несколькими серверами - распределение запросов и отказы
+    for (int i = 0; options.hostCount > 1 && i < options.hostCount; i++) {
+        writeLog("Сервер %s: отправлено %lu, ответов %lu, отказов %lu\n",
+                 options.hosts[i], client.health[i].sent,
+                 client.health[i].answered, client.health[i].failovers);
     }
-    buffer[numbytes] = '\0'; // добавляем нулевой символ в конец сообщения
 
-    // Закрываем сокет и файл журнала
-    close(sockfd);
-    fclose(logfd);
+    // Закрываем сокеты и файл журнала
+    timerCancel(&client.wheel, &deadline);
+    int failed = client.failed + client.busy > 0;
+    asyncClientDestroy(&client);
+    closeLog();
 
-    return 0;
+    return failed;
 }
@@ -0,0 +1,43 @@
+/*!
+ * \file coroutine.h
+ * \brief Заголовочный файл с описанием макросов
+ *
+ * Данный файл содержит в себе макросы бесстековых сопрограмм. Состояние
+ * сопрограммы - номер строки, на которой она остановилась; при следующем
+ * вызове функция продолжается с этой строки через switch. Локальные
+ * переменные между вызовами не сохраняются, поэтому всё состояние
+ * хранится в структуре сопрограммы.
+*/
+
+#ifndef INC_6_LAB_COROUTINE_H
+#define INC_6_LAB_COROUTINE_H
+
+/*!
+ * \brief Результат шага сопрограммы
+ */
+typedef enum
+{
+    CO_RUNNING, /*!< Сопрограмма ждёт события */
+    CO_DONE     /*!< Сопрограмма завершилась */
+} CoStatus;
+
+/*!
+ * \brief Начало тела сопрограммы
+ * \param line Поле структуры, в котором хранится точка продолжения
+ */
+#define CO_BEGIN(line) switch (line) { case 0:
+
+/*!
+ * \brief Приостанавливает сопрограмму до следующего вызова
+ * \param line Поле структуры, в котором хранится точка продолжения
+ */
+#define CO_YIELD(line) \
+    do { (line) = __LINE__; return CO_RUNNING; case __LINE__:; } while (0)
+
+/*!
+ * \brief Конец тела сопрограммы
+ * \param line Поле структуры, в котором хранится точка продолжения
+ */
+#define CO_END(line) } (line) = 0; return CO_DONE
+
+#endif //INC_6_LAB_COROUTINE_H
@@ -0,0 +1,246 @@
+/*! Функции обработчика аварийного завершения */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <execinfo.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "crash.h"
+#include "signals.h"
+
+#define CRASH_STACK_SIZE 65536 // стек сигналов одного потока
+#define BACKTRACE_DEPTH 64 // кадров стека вызовов в отчёте
+
+// Запись кольцевого буфера запросов
+typedef struct
+{
+    atomic_ulong sequence;       // номер запроса + 1; 0 - запись пишется
+    int worker;                  // обработчик, выполнявший запрос
+    int length;                  // длина текста
+    char text[CRASH_TEXT_SIZE];  // начало текста запроса
+} CrashEntry;
+
+static CrashEntry ring[CRASH_RING_SIZE];
+static atomic_ulong ringHead;    // номер следующего запроса
+static int extraFd = -1;         // дополнительный дескриптор для отчёта
+static char header[128];         // заголовок отчёта, подготовленный заранее
+static size_t headerLength;
+static __thread int threadWorker = -1; // номер обработчика потока
+
+// Сигналы, при которых выводится отчёт
+static const int crashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+// Функция для получения имени аварийного сигнала
+static const char* signalName(int signum)
+{
+    switch (signum)
+    {
+        case SIGSEGV:
+            return "SIGSEGV";
+        case SIGBUS:
+            return "SIGBUS";
+        case SIGFPE:
+            return "SIGFPE";
+        case SIGILL:
+            return "SIGILL";
+        case SIGABRT:
+            return "SIGABRT";
+        default:
+            return "?";
+    }
+}
+
+// Функция для вывода буфера во все дескрипторы отчёта
+static void emit(const char* text, size_t length)
+{
+    // write(2) допустим в обработчике сигнала, в отличие от stdio
+    if (write(STDERR_FILENO, text, length) == -1)
+    {
+        // отчёт выводится как получится
+    }
+    if (extraFd != -1 && write(extraFd, text, length) == -1)
+    {
+    }
+}
+
+// Функция для вывода строки
+static void emitText(const char* text)
+{
+    emit(text, strlen(text));
+}
+
+// Функция для вывода числа без printf
+static void emitNumber(unsigned long value, int base)
+{
+    char digits[32];
+    int position = sizeof(digits);
+    do
+    {
+        digits[--position] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value != 0 && position > 2);
+    if (base == 16)
+    {
+        digits[--position] = 'x';
+        digits[--position] = '0';
+    }
+    emit(digits + position, sizeof(digits) - position);
+}
+
+// Функция для вывода знакового числа
+static void emitSigned(long value)
+{
+    if (value < 0)
+    {
+        emit("-", 1);
+        emitNumber((unsigned long) -value, 10);
+        return;
+    }
+    emitNumber((unsigned long) value, 10);
+}
+
+// Функция для вывода последних запросов из кольцевого буфера
+static void emitRecentRequests(void)
+{
+    unsigned long head = atomic_load(&ringHead);
+    unsigned long first = head > CRASH_RING_SIZE ? head - CRASH_RING_SIZE : 0;
+    emitText("Последние запросы:\n");
+    for (unsigned long n = first; n < head; n++)
+    {
+        CrashEntry* entry = &ring[n % CRASH_RING_SIZE];
+        // Запись могла быть перезаписана или ещё не дописана
+        if (atomic_load(&entry->sequence) != n + 1)
+        {
+            continue;
+        }
+        emitText("  #");
+        emitNumber(n, 10);
+        emitText(" обработчик ");
+        emitSigned(entry->worker);
+        emitText(": ");
+        emit(entry->text, entry->length);
+        emit("\n", 1);
+    }
+}
+
+// Обработчик аварийных сигналов
+static void crashHandler(int signum, siginfo_t* info, void* context)
+{
+    (void) context;
+    // Записи журнала, ещё не выведенные из буфера, пропали бы вместе
+    // с процессом; в файле журнала они окажутся перед отчётом
+    writePendingLog();
+    emit(header, headerLength);
+    emitText("Сигнал ");
+    emitNumber(signum, 10);
+    emitText(" (");
+    emitText(signalName(signum));
+    emitText("), адрес ");
+    emitNumber((unsigned long) (uintptr_t) info->si_addr, 16);
+    emitText(", код ");
+    emitSigned(info->si_code);
+    emitText("\nПоток ");
+    emitNumber((unsigned long) syscall(SYS_gettid), 10);
+    emitText(", обработчик ");
+    emitSigned(threadWorker);
+    emitText("\nСтек вызовов:\n");
+
+    void* frames[BACKTRACE_DEPTH];
+    int depth = backtrace(frames, BACKTRACE_DEPTH);
+    backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+    if (extraFd != -1)
+    {
+        backtrace_symbols_fd(frames, depth, extraFd);
+    }
+
+    emitRecentRequests();
+    emitText("Конец отчёта\n");
+
+    // Действие по умолчанию восстановлено флагом SA_RESETHAND: повторно
+    // посылаем сигнал, чтобы процесс завершился с ним и оставил дамп
+    raise(signum);
+}
+
+// Функция для выделения стека сигналов текущего потока
+void crashThreadInit(int workerId)
+{
+    threadWorker = workerId;
+    // Стек, выделенный до fork, достаётся потоку процесса-потомка
+    stack_t stack;
+    if (sigaltstack(NULL, &stack) == 0 && !(stack.ss_flags & SS_DISABLE))
+    {
+        return;
+    }
+    stack.ss_sp = mmap(NULL, CRASH_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (stack.ss_sp == MAP_FAILED)
+    {
+        perror("mmap");
+        return;
+    }
+    stack.ss_size = CRASH_STACK_SIZE;
+    stack.ss_flags = 0;
+    if (sigaltstack(&stack, NULL) == -1)
+    {
+        perror("sigaltstack");
+    }
+}
+
+// Функция для установки обработчика аварийных сигналов
+void crashInit(int reportFd)
+{
+    extraFd = reportFd;
+    headerLength = snprintf(header, sizeof(header),
+                            "\nАварийное завершение процесса %ld\n",
+                            (long) getpid());
+    if (headerLength >= sizeof(header))
+    {
+        headerLength = sizeof(header) - 1;
+    }
+
+    // Первый вызов backtrace загружает libgcc и выделяет память: делаем
+    // его заранее, чтобы в обработчике сигнала этого не происходило
+    void* frames[1];
+    backtrace(frames, 1);
+
+    crashThreadInit(-1);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = crashHandler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(crashSignals) / sizeof(crashSignals[0]);
+         i++)
+    {
+        sigaction(crashSignals[i], &action, NULL);
+    }
+}
+
+// Функция для записи запроса в кольцевой буфер
+void crashRecord(int workerId, const char* text, int length)
+{
+    // Номер записи выдаётся атомарно, поэтому потоки не ждут друг друга
+    unsigned long n = atomic_fetch_add_explicit(&ringHead, 1,
+                                                memory_order_relaxed);
+    CrashEntry* entry = &ring[n % CRASH_RING_SIZE];
+    atomic_store_explicit(&entry->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    if (length > CRASH_TEXT_SIZE)
+    {
+        length = CRASH_TEXT_SIZE;
+    }
+    entry->worker = workerId;
+    entry->length = length;
+    memcpy(entry->text, text, length);
+    // Запись видна обработчику только после того, как полностью заполнена
+    atomic_store_explicit(&entry->sequence, n + 1, memory_order_release);
+}
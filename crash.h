@@ -0,0 +1,53 @@
+/*!
+ * \file crash.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение обработчика аварийного
+ * завершения. При SIGSEGV, SIGBUS, SIGFPE, SIGILL и SIGABRT он выводит
+ * в файл журнала ещё не выведенные записи, затем отчёт - только через
+ * write(2) на отдельном стеке сигналов: номер сигнала и адрес, номер
+ * обработчика, стек вызовов и последние запросы из кольцевого буфера,
+ * после чего процесс завершается сигналом с
+ * действием по умолчанию (и может оставить дамп памяти).
+*/
+
+#ifndef INC_6_LAB_CRASH_H
+#define INC_6_LAB_CRASH_H
+
+/*!
+ * \brief Количество последних запросов, попадающих в отчёт
+ */
+#define CRASH_RING_SIZE 64
+
+/*!
+ * \brief Наибольшая длина текста запроса в кольцевом буфере
+ */
+#define CRASH_TEXT_SIZE 96
+
+/*!
+ * \brief Устанавливает обработчик аварийных сигналов
+ *
+ * Вызывается главным потоком до создания остальных потоков, а также
+ * в процессе, созданном fork: заголовок отчёта содержит номер процесса.
+ * \param[in] reportFd Дополнительный дескриптор для отчёта (например,
+ * файл журнала) или -1; отчёт всегда выводится в stderr
+ */
+void crashInit(int reportFd);
+
+/*!
+ * \brief Выделяет отдельный стек сигналов для текущего потока
+ *
+ * Без него обработчик не сможет выполниться при переполнении стека.
+ * \param[in] workerId Номер обработчика, выводимый в отчёте
+ */
+void crashThreadInit(int workerId);
+
+/*!
+ * \brief Запоминает запрос в кольцевом буфере без блокировок
+ * \param[in] workerId Номер обработчика, выполняющего запрос
+ * \param[in] text Текст запроса
+ * \param[in] length Длина текста
+ */
+void crashRecord(int workerId, const char* text, int length);
+
+#endif //INC_6_LAB_CRASH_H
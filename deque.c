@@ -0,0 +1,74 @@
+/*! Функции очереди задач Чейза-Лева */
+
+#include <stdlib.h>
+
+#include "deque.h"
+
+/*
+ * Порядок доступа к памяти взят из работы Lê, Pop, Cohen, Zappa Nardelli
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ * Ёмкость фиксирована: задачи занимают буферы пула, поэтому их не может
+ * быть больше, чем буферов, и массив не нужно увеличивать.
+ */
+
+// Функция для выделения массива очереди
+int dequeInit(TaskDeque* deque, long capacity)
+{
+    deque->buffer = calloc(capacity, sizeof(*deque->buffer));
+    if (deque->buffer == NULL)
+    {
+        return -1;
+    }
+    deque->mask = capacity - 1;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    return 0;
+}
+
+// Функция для добавления задачи владельцем
+int dequePush(TaskDeque* deque, void* task)
+{
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (b - t > deque->mask)
+    {
+        return -1;
+    }
+    atomic_store_explicit(&deque->buffer[b & deque->mask], task,
+                          memory_order_relaxed);
+    // Задача должна стать видимой раньше нового значения bottom
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+
+// Функция для извлечения самой старой задачи любым потоком
+void* dequeSteal(TaskDeque* deque)
+{
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b)
+    {
+        return NULL;
+    }
+
+    void* task = atomic_load_explicit(&deque->buffer[t & deque->mask],
+                                      memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+    {
+        // Задачу забрал владелец или другой перехватчик
+        return NULL;
+    }
+    return task;
+}
+
+// Функция для оценки длины очереди
+long dequeSize(TaskDeque* deque)
+{
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    return b > t ? b - t : 0;
+}
@@ -0,0 +1,62 @@
+/*!
+ * \file deque.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение двусторонней очереди задач
+ * Чейза-Лева для планировщика с перехватом работы (work stealing).
+ * Владелец кладёт задачи в один конец без блокировок, а забирают их
+ * с противоположного конца и владелец, и другие потоки. Извлечения
+ * владельцем с его конца (LIFO) в очереди нет: задачи - это запросы
+ * клиентов, и при выполнении в порядке поступления (FIFO) ответы уходят
+ * в том же порядке, а ранние запросы не ждут поздних.
+*/
+
+#ifndef INC_6_LAB_DEQUE_H
+#define INC_6_LAB_DEQUE_H
+
+#include <stdatomic.h>
+
+#include "pool.h"
+
+/*!
+ * \brief Очередь задач фиксированной ёмкости
+ */
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_long top;    /*!< Конец для перехвата */
+    _Alignas(CACHE_LINE) atomic_long bottom; /*!< Конец владельца */
+    _Alignas(CACHE_LINE) _Atomic(void*)* buffer; /*!< Кольцевой массив */
+    long mask;                               /*!< Ёмкость минус один */
+} TaskDeque;
+
+/*!
+ * \brief Выделяет массив очереди
+ * \param[out] deque Очередь
+ * \param[in] capacity Ёмкость, степень двойки
+ * \return 0 при успехе, -1 при ошибке
+ */
+int dequeInit(TaskDeque* deque, long capacity);
+
+/*!
+ * \brief Кладёт задачу в очередь (только владелец)
+ * \param[in] deque Очередь
+ * \param[in] task Задача
+ * \return 0 при успехе, -1 если очередь заполнена
+ */
+int dequePush(TaskDeque* deque, void* task);
+
+/*!
+ * \brief Забирает самую старую задачу (любой поток, в том числе владелец)
+ * \param[in] deque Очередь
+ * \return Задача или NULL, если очередь пуста или задачу забрали раньше
+ */
+void* dequeSteal(TaskDeque* deque);
+
+/*!
+ * \brief Возвращает приблизительное количество задач в очереди
+ * \param[in] deque Очередь
+ * \return Количество задач
+ */
+long dequeSize(TaskDeque* deque);
+
+#endif //INC_6_LAB_DEQUE_H
@@ -0,0 +1,317 @@
+/*! Функции столбцового файла уравнений */
+
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "eqfile.h"
+
+// Размеры элементов столбцов
+static const size_t columnSizes[EQ_COLUMN_COUNT] = {
+    sizeof(double), sizeof(double), sizeof(double), sizeof(double),
+    sizeof(uint8_t), sizeof(double), sizeof(double), sizeof(double),
+    sizeof(int8_t), sizeof(int8_t)
+};
+
+// Функция для выравнивания смещения вверх до EQFILE_ALIGN
+static uint64_t alignUp(uint64_t offset)
+{
+    return (offset + EQFILE_ALIGN - 1) / EQFILE_ALIGN * EQFILE_ALIGN;
+}
+
+// Функция для расположения столбцов и таблицы блоков в новом файле
+static void layout(EqFileHeader* header)
+{
+    int columns = header->flags & EQFILE_RESULTS ? EQ_COLUMN_COUNT
+                                                 : EQ_COLUMN_ROOT0;
+    uint64_t offset = EQFILE_HEADER_SIZE;
+    for (int i = 0; i < EQ_COLUMN_COUNT; i++)
+    {
+        header->columns[i] = 0;
+        if (i < columns)
+        {
+            header->columns[i] = offset;
+            offset = alignUp(offset + header->count * columnSizes[i]);
+        }
+    }
+    header->chunkOffset = offset;
+    header->fileSize = offset + header->chunkCount * sizeof(EqChunkStats);
+}
+
+// Функция для заполнения указателей пакета по смещениям столбцов
+static void attach(EquationFile* file)
+{
+    char* base = (char*) file->header;
+    const uint64_t* columns = file->header->columns;
+    EquationBatch* batch = &file->batch;
+
+    batch->count = file->header->count;
+    batch->a = (double*) (base + columns[EQ_COLUMN_A]);
+    batch->b = (double*) (base + columns[EQ_COLUMN_B]);
+    batch->c = (double*) (base + columns[EQ_COLUMN_C]);
+    batch->d = (double*) (base + columns[EQ_COLUMN_D]);
+    batch->degree = (uint8_t*) (base + columns[EQ_COLUMN_DEGREE]);
+    if (file->header->flags & EQFILE_RESULTS)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            batch->roots[k] = (double*) (base + columns[EQ_COLUMN_ROOT0 + k]);
+        }
+        batch->rootCase = (int8_t*) (base + columns[EQ_COLUMN_ROOT_CASE]);
+        batch->rootCount = (int8_t*) (base + columns[EQ_COLUMN_ROOT_COUNT]);
+    }
+    else
+    {
+        batch->roots[0] = batch->roots[1] = batch->roots[2] = NULL;
+        batch->rootCase = NULL;
+        batch->rootCount = NULL;
+    }
+    file->chunks = (EqChunkStats*) (base + file->header->chunkOffset);
+}
+
+// Функция для создания файла уравнений
+int eqfileCreate(const char* path, size_t count, unsigned flags,
+                 EquationFile* file)
+{
+    EqFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EQFILE_MAGIC, sizeof(header.magic));
+    header.version = EQFILE_VERSION;
+    header.flags = flags & (EQFILE_RESULTS | EQFILE_CHECKSUM);
+    header.count = count;
+    header.chunkSize = EQFILE_CHUNK_SIZE;
+    header.chunkCount = (count + EQFILE_CHUNK_SIZE - 1) / EQFILE_CHUNK_SIZE;
+    layout(&header);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t) header.fileSize) == -1)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    void* base = mmap(NULL, header.fileSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        errno = error;
+        return -1;
+    }
+    memcpy(base, &header, sizeof(header));
+    file->header = base;
+    file->size = header.fileSize;
+    attach(file);
+    return 0;
+}
+
+// Функция для проверки заголовка открытого файла
+static int checkHeader(const EqFileHeader* header, size_t size)
+{
+    if (memcmp(header->magic, EQFILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != EQFILE_VERSION || header->fileSize != size ||
+        header->chunkSize == 0 || header->count > size ||
+        header->chunkCount !=
+            (header->count + header->chunkSize - 1) / header->chunkSize)
+    {
+        return -1;
+    }
+    // Столбцы коэффициентов есть всегда, столбцы результатов - с флагом
+    int results = (header->flags & EQFILE_RESULTS) != 0;
+    for (int i = 0; i < EQ_COLUMN_COUNT; i++)
+    {
+        uint64_t offset = header->columns[i];
+        if (i >= EQ_COLUMN_ROOT0 && !results)
+        {
+            if (offset != 0)
+            {
+                return -1;
+            }
+            continue;
+        }
+        if (offset < EQFILE_HEADER_SIZE || offset % EQFILE_ALIGN != 0 ||
+            offset > size || header->count * columnSizes[i] > size - offset)
+        {
+            return -1;
+        }
+    }
+    uint64_t offset = header->chunkOffset;
+    if (offset < EQFILE_HEADER_SIZE || offset % sizeof(uint64_t) != 0 ||
+        offset > size ||
+        (uint64_t) header->chunkCount * sizeof(EqChunkStats) > size - offset)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+// Функция для открытия файла уравнений
+int eqfileOpen(const char* path, int writable, EquationFile* file)
+{
+    int fd = open(path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    size_t size = (size_t) st.st_size;
+    if (size < EQFILE_HEADER_SIZE)
+    {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* base = mmap(NULL, size, protection, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        errno = error;
+        return -1;
+    }
+    if (checkHeader(base, size) == -1)
+    {
+        munmap(base, size);
+        errno = EINVAL;
+        return -1;
+    }
+    file->header = base;
+    file->size = size;
+    attach(file);
+    return 0;
+}
+
+// Функция для перемешивания битов (финализатор splitmix64)
+static uint64_t mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+// Функция для добавления байтов к контрольной сумме: по 8 байт за шаг,
+// остаток дополняется нулями
+static uint64_t hashBytes(uint64_t h, const void* data, size_t length)
+{
+    const unsigned char* p = data;
+    uint64_t word;
+    for (; length >= sizeof(word); p += sizeof(word), length -= sizeof(word))
+    {
+        memcpy(&word, p, sizeof(word));
+        h = (h ^ word) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 32;
+    }
+    word = 0;
+    memcpy(&word, p, length);
+    return mix(h ^ word ^ length);
+}
+
+// Функция для вычисления контрольной суммы блока [first, last)
+static uint64_t chunkChecksum(const EquationFile* file, size_t chunk,
+                              size_t first, size_t last)
+{
+    const char* base = (const char*) file->header;
+    uint64_t h = mix(chunk + 1);
+    for (int i = 0; i < EQ_COLUMN_COUNT; i++)
+    {
+        uint64_t offset = file->header->columns[i];
+        if (offset != 0)
+        {
+            h = hashBytes(h, base + offset + first * columnSizes[i],
+                          (last - first) * columnSizes[i]);
+        }
+    }
+    return h;
+}
+
+// Функция для запечатывания файла
+void eqfileSeal(EquationFile* file)
+{
+    const EquationBatch* batch = &file->batch;
+    size_t chunkSize = file->header->chunkSize;
+    for (size_t chunk = 0; chunk < file->header->chunkCount; chunk++)
+    {
+        size_t first = chunk * chunkSize;
+        size_t last = first + chunkSize < batch->count ? first + chunkSize
+                                                       : batch->count;
+        EqChunkStats* stats = &file->chunks[chunk];
+        memset(stats, 0, sizeof(*stats));
+        for (int k = 0; k < 4; k++)
+        {
+            stats->min[k] = INFINITY;
+            stats->max[k] = -INFINITY;
+        }
+        for (size_t i = first; i < last; i++)
+        {
+            if (batch->degree[i] == 0)
+            {
+                continue;
+            }
+            double coef[4] = {batch->a[i], batch->b[i], batch->c[i],
+                              batch->d[i]};
+            for (int k = 0; k < 4; k++)
+            {
+                stats->min[k] = coef[k] < stats->min[k] ? coef[k]
+                                                        : stats->min[k];
+                stats->max[k] = coef[k] > stats->max[k] ? coef[k]
+                                                        : stats->max[k];
+            }
+            stats->valid++;
+        }
+        if (file->header->flags & EQFILE_CHECKSUM)
+        {
+            stats->checksum = chunkChecksum(file, chunk, first, last);
+        }
+    }
+}
+
+// Функция для проверки контрольных сумм
+long eqfileVerify(const EquationFile* file)
+{
+    if (!(file->header->flags & EQFILE_CHECKSUM))
+    {
+        return -1;
+    }
+    size_t count = file->header->count;
+    size_t chunkSize = file->header->chunkSize;
+    for (size_t chunk = 0; chunk < file->header->chunkCount; chunk++)
+    {
+        size_t first = chunk * chunkSize;
+        size_t last = first + chunkSize < count ? first + chunkSize : count;
+        if (chunkChecksum(file, chunk, first, last) !=
+            file->chunks[chunk].checksum)
+        {
+            return (long) chunk;
+        }
+    }
+    return -1;
+}
+
+// Функция для снятия отображения
+int eqfileClose(EquationFile* file)
+{
+    int result = munmap(file->header, file->size);
+    file->header = NULL;
+    file->size = 0;
+    return result;
+}
@@ -0,0 +1,175 @@
+/*!
+ * \file eqfile.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение столбцового двоичного формата
+ * файла уравнений и результатов. Файл отображается в память прямо
+ * в пакет уравнений (EquationBatch), поэтому пакетный решатель получает
+ * коэффициенты без разбора текста.
+ *
+ * Устройство файла (числа - в порядке байтов машины, записавшей файл):
+ * - заголовок EqFileHeader, дополненный нулями до EQFILE_HEADER_SIZE байт;
+ * - столбцы a, b, c, d (double), degree (uint8_t) и, если установлен флаг
+ *   EQFILE_RESULTS, столбцы корней roots0, roots1, roots2 (double),
+ *   rootCase и rootCount (int8_t). Каждый столбец начинается со смещения,
+ *   кратного EQFILE_ALIGN, и занимает count элементов;
+ * - таблица блоков: по записи EqChunkStats на каждые chunkSize уравнений.
+ *
+ * Запись блока содержит наименьшие и наибольшие коэффициенты верных
+ * уравнений блока (по ним можно пропускать блоки, не читая столбцов)
+ * и, если установлен флаг EQFILE_CHECKSUM, контрольную сумму всех
+ * столбцов блока. Контрольная сумма защищает от повреждения файла,
+ * но не от намеренной подделки.
+*/
+
+#ifndef INC_6_LAB_EQFILE_H
+#define INC_6_LAB_EQFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "logic.h"
+
+/*!
+ * \brief Подпись в начале файла
+ */
+#define EQFILE_MAGIC "EQCOLS\r\n"
+
+/*!
+ * \brief Версия формата
+ */
+#define EQFILE_VERSION 1
+
+/*!
+ * \brief Размер заголовка: столбцы начинаются с границы страницы
+ */
+#define EQFILE_HEADER_SIZE 4096
+
+/*!
+ * \brief Выравнивание столбцов в файле (и в памяти после отображения)
+ */
+#define EQFILE_ALIGN 64
+
+/*!
+ * \brief Уравнений в блоке по умолчанию
+ */
+#define EQFILE_CHUNK_SIZE 65536
+
+/*!
+ * \brief Флаг: в файле есть столбцы результатов
+ */
+#define EQFILE_RESULTS 1u
+
+/*!
+ * \brief Флаг: у блоков есть контрольные суммы
+ */
+#define EQFILE_CHECKSUM 2u
+
+/*!
+ * \brief Столбцы файла
+ */
+typedef enum
+{
+    EQ_COLUMN_A,          /*!< Первые коэффициенты */
+    EQ_COLUMN_B,          /*!< Вторые коэффициенты */
+    EQ_COLUMN_C,          /*!< Третьи коэффициенты */
+    EQ_COLUMN_D,          /*!< Четвёртые коэффициенты */
+    EQ_COLUMN_DEGREE,     /*!< Степени уравнений */
+    EQ_COLUMN_ROOT0,      /*!< Первые корни */
+    EQ_COLUMN_ROOT1,      /*!< Вторые корни */
+    EQ_COLUMN_ROOT2,      /*!< Третьи корни */
+    EQ_COLUMN_ROOT_CASE,  /*!< Случаи расположения корней */
+    EQ_COLUMN_ROOT_COUNT, /*!< Количества корней */
+    EQ_COLUMN_COUNT       /*!< Количество столбцов */
+} EqColumn;
+
+/*!
+ * \brief Заголовок файла
+ */
+typedef struct
+{
+    char magic[8];         /*!< EQFILE_MAGIC */
+    uint32_t version;      /*!< EQFILE_VERSION */
+    uint32_t flags;        /*!< EQFILE_RESULTS, EQFILE_CHECKSUM */
+    uint64_t count;        /*!< Количество уравнений */
+    uint32_t chunkSize;    /*!< Уравнений в блоке */
+    uint32_t chunkCount;   /*!< Количество блоков */
+    uint64_t columns[EQ_COLUMN_COUNT]; /*!< Смещения столбцов от начала
+                                            файла (0 - столбца нет) */
+    uint64_t chunkOffset;  /*!< Смещение таблицы блоков */
+    uint64_t fileSize;     /*!< Размер файла */
+} EqFileHeader;
+
+/*!
+ * \brief Запись таблицы блоков
+ */
+typedef struct
+{
+    double min[4];     /*!< Наименьшие a, b, c, d верных уравнений блока */
+    double max[4];     /*!< Наибольшие a, b, c, d верных уравнений блока */
+    uint32_t valid;    /*!< Верных уравнений в блоке */
+    uint32_t reserved; /*!< Не используется, 0 */
+    uint64_t checksum; /*!< Контрольная сумма столбцов блока */
+} EqChunkStats;
+
+/*!
+ * \brief Файл уравнений, отображённый в память
+ */
+typedef struct
+{
+    EqFileHeader* header; /*!< Начало отображения */
+    EquationBatch batch;  /*!< Столбцы файла (без результатов - NULL) */
+    EqChunkStats* chunks; /*!< Таблица блоков */
+    size_t size;          /*!< Размер отображения */
+} EquationFile;
+
+/*!
+ * \brief Создаёт файл для count уравнений и отображает его в память
+ *
+ * Столбцы нового файла заполнены нулями; после записи коэффициентов
+ * (и, возможно, результатов) файл нужно запечатать eqfileSeal.
+ * \param[in] path Имя файла
+ * \param[in] count Количество уравнений
+ * \param[in] flags EQFILE_RESULTS и EQFILE_CHECKSUM
+ * \param[out] file Отображённый файл
+ * \return 0 при успехе, -1 при ошибке (errno указывает причину)
+ */
+int eqfileCreate(const char* path, size_t count, unsigned flags,
+                 EquationFile* file);
+
+/*!
+ * \brief Открывает файл и отображает его в память
+ *
+ * Заголовок проверяется: подпись, версия, границы и выравнивание
+ * столбцов. Контрольные суммы проверяет eqfileVerify.
+ * \param[in] path Имя файла
+ * \param[in] writable 1, если столбцы будут изменяться (например,
+ * заполняться результаты); изменения попадают в файл
+ * \param[out] file Отображённый файл
+ * \return 0 при успехе, -1 при ошибке (EINVAL - файл не в этом формате)
+ */
+int eqfileOpen(const char* path, int writable, EquationFile* file);
+
+/*!
+ * \brief Вычисляет таблицу блоков (границы коэффициентов и контрольные
+ * суммы) по текущему содержимому столбцов
+ * \param[in,out] file Отображённый для записи файл
+ */
+void eqfileSeal(EquationFile* file);
+
+/*!
+ * \brief Проверяет контрольные суммы блоков
+ * \param[in] file Отображённый файл
+ * \return Номер первого повреждённого блока или -1, если повреждений нет
+ * (или у файла нет контрольных сумм)
+ */
+long eqfileVerify(const EquationFile* file);
+
+/*!
+ * \brief Снимает отображение файла
+ * \param[in,out] file Отображённый файл
+ * \return 0 при успехе, -1 при ошибке
+ */
+int eqfileClose(EquationFile* file);
+
+#endif //INC_6_LAB_EQFILE_H
@@ -0,0 +1,174 @@
+/*!
+ * \file fastmath.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе приближённые функции cbrt, acos, cos и sin
+ * для быстрого решения кубических уравнений. Функции не содержат
+ * переходов и вызовов библиотеки: в цикле постоянной длины компилятор
+ * выполняет их векторными командами (при сборке с -fno-math-errno и
+ * -fno-trapping-math). Границы ошибок измерены на 2*10^8 случайных
+ * аргументах сравнением с функциями long double и указаны в описании
+ * каждой функции в ulp правильно округлённого результата; тест
+ * test_fastmath проверяет их на случайных и трудных аргументах.
+*/
+
+#ifndef INC_6_LAB_FASTMATH_H
+#define INC_6_LAB_FASTMATH_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#define FAST_SIGN_BIT 0x8000000000000000ull // знаковый бит double
+#define FAST_CBRT_MAGIC 0x2AA0015500000000ull // смещение начального
+                                               // приближения cbrt
+#define FAST_SUBNORMAL_SCALE 0x1p54 // множитель для субнормальных чисел
+#define FAST_SUBNORMAL_UNSCALE 0x1p-18 // кубический корень из 2^-54
+#define FAST_PIO2_HI 1.57079632679489655800e+00 // pi/2, старшая часть
+#define FAST_PIO2_LO 6.12323399573676603587e-17 // pi/2, младшая часть
+#define FAST_SQRT3_2 0.86602540378443864676 // sqrt(3) / 2
+#define FAST_SPLITTER 134217729.0 // 2^27 + 1: множитель разбиения Вельткампа
+
+/*!
+ * \brief Вычисляет кубический корень. Начальное приближение берётся из
+ * двоичного представления (показатель делится на 3 суммой сдвигов, так
+ * как деление 64-битных целых не векторизуется), затем уточняется
+ * тремя итерациями Галлея. Ошибка не больше 2 ulp (у cbrt из glibc - до
+ * 3 ulp) для всех конечных чисел, включая субнормальные; cbrt(+-0) = +-0,
+ * бесконечность и NaN возвращаются без изменения
+ * \param[in] x Аргумент
+ * \return Кубический корень из x
+ */
+static inline double fastCbrt(double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    uint64_t sign = bits & FAST_SIGN_BIT;
+    bits ^= sign;
+    double ax;
+    memcpy(&ax, &bits, sizeof(ax));
+
+    // Субнормальные числа масштабируются, чтобы приближение было близким
+    double tiny = ax < DBL_MIN ? 1 : 0;
+    double scaled = ax * (tiny != 0 ? FAST_SUBNORMAL_SCALE : 1);
+    memcpy(&bits, &scaled, sizeof(bits));
+    uint64_t third = (bits >> 2) + (bits >> 4) + (bits >> 6) + (bits >> 8) +
+                     (bits >> 10) + (bits >> 12) + (bits >> 14) +
+                     (bits >> 16) + (bits >> 18) + (bits >> 20);
+    bits = third + FAST_CBRT_MAGIC;
+    double y;
+    memcpy(&y, &bits, sizeof(y));
+
+    // Итерации Галлея в виде y (t + 2) / (2t + 1), где t = y^3 / x:
+    // отношение не переполняется и при x около DBL_MAX. Последняя
+    // итерация - в виде поправки, которая округляется точнее
+    double inverse = 1 / scaled;
+    double t = y * (y * (y * inverse));
+    y = y * (t + 2) / (2 * t + 1);
+    t = y * (y * (y * inverse));
+    y = y * (t + 2) / (2 * t + 1);
+    t = y * (y * (y * inverse));
+    y = y - y * (t - 1) / (2 * t + 1);
+
+    y *= tiny != 0 ? FAST_SUBNORMAL_UNSCALE : 1;
+    y = ax == 0 || ax == INFINITY ? ax : y;
+    memcpy(&bits, &y, sizeof(bits));
+    bits |= sign;
+    memcpy(&y, &bits, sizeof(y));
+    return y;
+}
+
+/*!
+ * \brief Вычисляет поправку для арксинуса на отрезке [0, 0.5]:
+ * asin(s) = s + s * z * P(z) / Q(z), где z = s^2, с коэффициентами
+ * рациональной аппроксимации fdlibm. Ошибка арксинуса не больше 0.6 ulp
+ * \param[in] z Квадрат аргумента арксинуса, из отрезка [0, 0.25]
+ * \return Поправка z * P(z) / Q(z) к s
+ */
+static inline double fastAsinRatio(double z)
+{
+    double p = z * (1.66666666666666657415e-01 +
+               z * (-3.25565818622400915405e-01 +
+               z * (2.01212532134862925881e-01 +
+               z * (-4.00555345006794114027e-02 +
+               z * (7.91534994289814532176e-04 +
+               z * 3.47933107596021167570e-05)))));
+    double q = 1 + z * (-2.40339491173441421878e+00 +
+                   z * (2.02094576023350569471e+00 +
+                   z * (-6.88283971605453293030e-01 +
+                   z * 7.70381505559019352791e-02)));
+    return p / q;
+}
+
+/*!
+ * \brief Вычисляет арккосинус. При |x| <= 0.5 acos(x) = pi/2 - asin(x),
+ * иначе acos(|x|) = 2 asin(sqrt((1 - |x|) / 2)); обе ветви вычисляются
+ * и выбираются без переходов. Ошибка не больше 1.2 ulp
+ * \param[in] x Аргумент из отрезка [-1, 1]
+ * \return Арккосинус x из отрезка [0, pi]
+ */
+static inline double fastAcos(double x)
+{
+    double ax = fabs(x);
+    double big = ax > 0.5 ? 1 : 0;
+    double z = big != 0 ? 0.5 - 0.5 * ax : x * x;
+    double s = big != 0 ? sqrt(z) : x;
+    double r = fastAsinRatio(z);
+
+    // |x| <= 0.5: pi/2 - (x + x * r) с учётом младшей части pi/2
+    double middle = FAST_PIO2_HI - (x - (FAST_PIO2_LO - x * r));
+    // |x| > 0.5: 2 asin(s) или pi - 2 asin(s) для отрицательного x
+    double positive = 2 * (s + s * r);
+    double negative = 2 * FAST_PIO2_HI - 2 * (s + (s * r - FAST_PIO2_LO));
+    return big == 0 ? middle : x > 0 ? positive : negative;
+}
+
+/*!
+ * \brief Вычисляет косинус и синус угла из отрезка [0, pi/3]
+ * многочленами Тейлора до 18 и 19 степени; квадрат угла и разность
+ * 1 - z/2 в косинусе учитываются с ошибкой округления. Ошибка косинуса
+ * не больше 0.75 ulp, синуса - не больше 1.2 ulp
+ * \param[in] theta Угол
+ * \param[out] c Косинус угла
+ * \param[out] s Синус угла
+ */
+static inline void fastCosSin(double theta, double* c, double* s)
+{
+    // theta^2 = z + zLow точно
+    double z = theta * theta;
+#ifdef FP_FAST_FMA
+    double zLow = fma(theta, theta, -z);
+#else
+    // Без аппаратного fma theta делится на старшие и младшие 26 бит
+    double split = FAST_SPLITTER * theta;
+    double high = split - (split - theta);
+    double low = theta - high;
+    double zLow = ((high * high - z) + 2 * high * low) + low * low;
+#endif
+
+    // cos = 1 - z/2 + r: при угле около pi/3 вычитание 1 - z/2 теряет
+    // ошибку округления z и разности, поэтому обе прибавляются отдельно
+    double half = 0.5 * z;
+    double w = 1 - half;
+    double r = z * z * (1.0 / 24 +
+                    z * (-1.0 / 720 +
+                    z * (1.0 / 40320 +
+                    z * (-1.0 / 3628800 +
+                    z * (1.0 / 479001600 +
+                    z * (-1.0 / 87178291200 +
+                    z * (1.0 / 20922789888000 +
+                    z * (-1.0 / 6402373705728000))))))));
+    *c = w + (((1 - w) - half) + (r - 0.5 * zLow));
+    *s = theta + theta * z * (-1.0 / 6 +
+                          z * (1.0 / 120 +
+                          z * (-1.0 / 5040 +
+                          z * (1.0 / 362880 +
+                          z * (-1.0 / 39916800 +
+                          z * (1.0 / 6227020800 +
+                          z * (-1.0 / 1307674368000 +
+                          z * (1.0 / 355687428096000 +
+                          z * (-1.0 / 121645100408832000)))))))));
+}
+
+#endif //INC_6_LAB_FASTMATH_H
@@ -0,0 +1,351 @@
+/*! Функции построения текста */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <float.h>
+
+#include "format.h"
+
+// Произведение double (53 бита мантиссы) на 10^p = 2^p * 5^p точно
+// представимо в long double с 64-битной мантиссой, пока 5^p занимает
+// не больше 11 бит, то есть при p <= 4. Тогда округление до целого
+// в текущем режиме (к ближайшему чётному) совпадает с округлением
+// точного десятичного значения, которое выполняет printf
+#if LDBL_MANT_DIG >= 64
+#define FIXED_MAX_PRECISION 4
+#else
+#define FIXED_MAX_PRECISION -1 // без расширенной точности только printf
+#endif
+
+// Граница быстрого пути: целая часть произведения помещается в 64 бита
+#define FIXED_MAX_SCALED 1e18L
+
+static const long double powers[] = {1.0L, 10.0L, 100.0L, 1000.0L, 10000.0L};
+static const unsigned long long divisors[] = {1, 10, 100, 1000, 10000};
+
+// Значащих цифр у числа, которое читается обратно без потерь
+#define EXACT_DIGITS 17
+#define EXACT_LIMIT 100000000000000000ULL // 10^EXACT_DIGITS
+
+// Мантисса double (меньше 2^53), умноженная на 5^32 (меньше 2^75) или
+// сдвинутая на 74 бита влево, помещается в 128 бит
+#define EXACT_MAX_FIVES 32
+#define EXACT_MAX_SHIFT 74
+
+// Функция для начала текста в буфере
+void textInit(TextBuffer* text, char* data, size_t size)
+{
+    text->data = data;
+    text->size = size;
+    text->length = 0;
+    data[0] = '\0';
+}
+
+// Функция для добавления строки известной длины
+void textAppend(TextBuffer* text, const char* string, size_t length)
+{
+    size_t space = text->size - 1 - text->length;
+    if (length > space)
+    {
+        length = space;
+    }
+    memcpy(text->data + text->length, string, length);
+    text->length += length;
+    text->data[text->length] = '\0';
+}
+
+// Функция для добавления строки, завершённой нулевым символом
+void textAppendString(TextBuffer* text, const char* string)
+{
+    textAppend(text, string, strlen(string));
+}
+
+// Записывает цифры числа в конец массива digits, возвращает начало
+static char* formatDigits(char* end, unsigned long long value)
+{
+    do
+    {
+        *--end = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return end;
+}
+
+// Функция для добавления целого числа
+void textAppendInt(TextBuffer* text, long value)
+{
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long) value
+                                             : (unsigned long long) value;
+    char* start = formatDigits(end, magnitude);
+    if (value < 0)
+    {
+        *--start = '-';
+    }
+    textAppend(text, start, end - start);
+}
+
+// Функция для добавления целого числа без знака
+void textAppendUnsigned(TextBuffer* text, unsigned long long value)
+{
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* start = formatDigits(end, value);
+    textAppend(text, start, end - start);
+}
+
+// Функция для добавления числа с фиксированным количеством знаков
+void textAppendFixed(TextBuffer* text, double value, int precision)
+{
+    long double scaled = 0;
+    if (precision >= 0 && precision <= FIXED_MAX_PRECISION &&
+        isfinite(value))
+    {
+        scaled = fabsl((long double) value * powers[precision]);
+    }
+    if (precision < 0 || precision > FIXED_MAX_PRECISION ||
+        !isfinite(value) || scaled >= FIXED_MAX_SCALED)
+    {
+        textAppendFormat(text, "%.*f", precision, value);
+        return;
+    }
+
+    unsigned long long rounded = (unsigned long long) llrintl(scaled);
+    char digits[32];
+    char* end = digits + sizeof(digits);
+    char* start = end;
+    if (precision > 0)
+    {
+        // Дробная часть с ведущими нулями
+        unsigned long long fraction = rounded % divisors[precision];
+        for (int i = 0; i < precision; i++)
+        {
+            *--start = (char) ('0' + fraction % 10);
+            fraction /= 10;
+        }
+        *--start = '.';
+    }
+    start = formatDigits(start, rounded / divisors[precision]);
+    // printf сохраняет знак и у отрицательного нуля, и у числа,
+    // округлившегося до нуля
+    if (signbit(value))
+    {
+        *--start = '-';
+    }
+    textAppend(text, start, end - start);
+}
+
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 Exact128;
+
+// Вычисляет 17 значащих цифр числа m * 2^e (2^52 <= m < 2^53),
+// округлённых к ближайшему с чётной последней цифрой при равенстве, как
+// округляет printf. Возвращает цифры и порядок первой из них в *power
+// или -1, если 128 бит не хватает
+static long long exactDigits(uint64_t m, int e, int* power)
+{
+    // Нижняя оценка десятичного порядка: floor(log10(2^(e + 52)));
+    // 78913 / 2^18 - приближение log10(2) снизу
+    int estimate = ((e + 52) * 78913) >> 18;
+    uint64_t digits;
+    int above; // сравнение отброшенной части с половиной единицы: -1, 0, 1
+    if (e >= 0)
+    {
+        if (e > EXACT_MAX_SHIFT)
+        {
+            return -1;
+        }
+        // Целое число: отбрасываются младшие десятичные цифры
+        Exact128 n = (Exact128) m << e;
+        Exact128 divisor = 1;
+        *power = EXACT_DIGITS - 1;
+        while (n / divisor >= EXACT_LIMIT)
+        {
+            divisor *= 10;
+            (*power)++;
+        }
+        digits = (uint64_t) (n / divisor);
+        Exact128 rest = n % divisor * 2;
+        above = rest > divisor ? 1 : rest < divisor ? -1 : 0;
+        if (n < EXACT_LIMIT)
+        {
+            // Меньше 17 цифр: у числа нет отброшенной части
+            *power = 0;
+            for (uint64_t v = digits; v >= 10; v /= 10)
+            {
+                (*power)++;
+            }
+        }
+    }
+    else
+    {
+        // x * 10^p = m * 5^p / 2^(-e - p) содержит 17 или 18 цифр
+        int p = EXACT_DIGITS - 1 - estimate;
+        int shift = -e - p;
+        if (p > EXACT_MAX_FIVES || shift >= 128)
+        {
+            return -1;
+        }
+        Exact128 n = m;
+        for (int i = 0; i < p; i++)
+        {
+            n *= 5;
+        }
+        Exact128 rest = 0;
+        above = -1;
+        if (shift <= 0)
+        {
+            digits = (uint64_t) (n << -shift);
+        }
+        else
+        {
+            digits = (uint64_t) (n >> shift);
+            rest = n & (((Exact128) 1 << shift) - 1);
+            Exact128 half = (Exact128) 1 << (shift - 1);
+            above = rest > half ? 1 : rest < half ? -1 : 0;
+        }
+        *power = estimate;
+        if (digits >= EXACT_LIMIT)
+        {
+            // 18 цифр: отброшенная часть - последняя цифра и остаток
+            int last = (int) (digits % 10);
+            digits /= 10;
+            above = last > 5 ? 1 : last < 5 ? -1 : rest != 0 ? 1 : 0;
+            (*power)++;
+        }
+    }
+    if (above > 0 || (above == 0 && (digits & 1) != 0))
+    {
+        digits++;
+        if (digits == EXACT_LIMIT)
+        {
+            digits /= 10;
+            (*power)++;
+        }
+    }
+    return (long long) digits;
+}
+#endif
+
+// Функция для добавления числа со всеми значащими цифрами
+void textAppendExact(TextBuffer* text, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biased = (int) ((bits >> 52) & 0x7FF);
+    char sign[1] = {'-'};
+    if ((bits << 1) == 0)
+    {
+        // Ноль, в том числе отрицательный
+        textAppend(text, sign, signbit(value) ? 1 : 0);
+        textAppendLiteral(text, "0");
+        return;
+    }
+    long long digits = -1;
+    int power = 0;
+#ifdef __SIZEOF_INT128__
+    // Денормализованные числа, NaN и бесконечности выводит printf
+    if (biased != 0 && biased != 0x7FF)
+    {
+        digits = exactDigits((bits & ((1ULL << 52) - 1)) | (1ULL << 52),
+                             biased - 1075, &power);
+    }
+#endif
+    if (digits == -1)
+    {
+        textAppendFormat(text, "%.17g", value);
+        return;
+    }
+
+    // Цифры без нулей в конце, как у %g
+    char buffer[EXACT_DIGITS + 1];
+    char* end = buffer + sizeof(buffer);
+    char* start = formatDigits(end, (unsigned long long) digits);
+    while (end - start > 1 && end[-1] == '0')
+    {
+        end--;
+    }
+    int count = (int) (end - start);
+    textAppend(text, sign, signbit(value) ? 1 : 0);
+    if (power < -4 || power >= EXACT_DIGITS)
+    {
+        // 1.2345e-07, 1e+20
+        textAppend(text, start, 1);
+        if (count > 1)
+        {
+            textAppendLiteral(text, ".");
+            textAppend(text, start + 1, count - 1);
+        }
+        textAppend(text, power < 0 ? "e-" : "e+", 2);
+        int magnitude = power < 0 ? -power : power;
+        if (magnitude < 10)
+        {
+            textAppendLiteral(text, "0");
+        }
+        textAppendInt(text, magnitude);
+    }
+    else if (power >= 0)
+    {
+        // Целая часть, при необходимости дополненная нулями
+        int whole = power + 1;
+        textAppend(text, start, count < whole ? count : whole);
+        for (int i = count; i < whole; i++)
+        {
+            textAppendLiteral(text, "0");
+        }
+        if (count > whole)
+        {
+            textAppendLiteral(text, ".");
+            textAppend(text, start + whole, count - whole);
+        }
+    }
+    else
+    {
+        // 0.000123
+        textAppendLiteral(text, "0.");
+        for (int i = power + 1; i < 0; i++)
+        {
+            textAppendLiteral(text, "0");
+        }
+        textAppend(text, start, count);
+    }
+}
+
+// Функция для добавления форматированной строки
+void textAppendFormat(TextBuffer* text, const char* format, ...)
+{
+    size_t space = text->size - text->length;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(text->data + text->length, space, format, args);
+    va_end(args);
+    if (written < 0)
+    {
+        text->data[text->length] = '\0';
+        return;
+    }
+    // Усечённая строка занимает буфер до конца
+    text->length += (size_t) written < space ? (size_t) written : space - 1;
+}
+
+// Функция для разбора названия режима вывода
+int parseOutputMode(const char* name)
+{
+    if (strcmp(name, "human") == 0)
+    {
+        return OUTPUT_HUMAN;
+    }
+    if (strcmp(name, "compact") == 0)
+    {
+        return OUTPUT_COMPACT;
+    }
+    if (strcmp(name, "silent") == 0)
+    {
+        return OUTPUT_SILENT;
+    }
+    return -1;
+}
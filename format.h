@@ -0,0 +1,121 @@
+/*!
+ * \file format.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение построителя текста в буфере
+ * без printf. Числа с фиксированным количеством знаков после запятой
+ * переводятся в строку целочисленной арифметикой и совпадают с выводом
+ * printf("%.Nf"); printf остаётся только для очень больших чисел, NaN
+ * и бесконечностей. Так же без printf выводятся числа со всеми
+ * значащими цифрами, как printf("%.17g").
+*/
+
+#ifndef INC_6_LAB_FORMAT_H
+#define INC_6_LAB_FORMAT_H
+
+#include <stddef.h>
+
+/*!
+ * \brief Текст, накапливаемый в буфере вызывающей функции
+ *
+ * Текст не выходит за границу буфера и всегда завершается нулевым
+ * символом; не поместившийся хвост отбрасывается.
+ */
+typedef struct
+{
+    char* data;    /*!< Буфер */
+    size_t size;   /*!< Размер буфера */
+    size_t length; /*!< Длина записанного текста */
+} TextBuffer;
+
+/*!
+ * \brief Режим вывода запросов сервера на экран и в журнал
+ */
+typedef enum
+{
+    OUTPUT_HUMAN,   /*!< Подробный вывод: клиент, запрос и ответ */
+    OUTPUT_COMPACT, /*!< Одна строка на запрос */
+    OUTPUT_SILENT   /*!< Запросы не выводятся */
+} OutputMode;
+
+/*!
+ * \brief Дописывает строковую константу без вызова strlen
+ */
+#define textAppendLiteral(text, literal) \
+    textAppend((text), (literal), sizeof(literal) - 1)
+
+/*!
+ * \brief Начинает текст в буфере
+ * \param[out] text Текст
+ * \param[in] data Буфер
+ * \param[in] size Размер буфера (не меньше 1)
+ */
+void textInit(TextBuffer* text, char* data, size_t size);
+
+/*!
+ * \brief Дописывает строку известной длины
+ * \param[in] text Текст
+ * \param[in] string Строка
+ * \param[in] length Длина строки
+ */
+void textAppend(TextBuffer* text, const char* string, size_t length);
+
+/*!
+ * \brief Дописывает строку, завершённую нулевым символом
+ * \param[in] text Текст
+ * \param[in] string Строка
+ */
+void textAppendString(TextBuffer* text, const char* string);
+
+/*!
+ * \brief Дописывает целое число
+ * \param[in] text Текст
+ * \param[in] value Число
+ */
+void textAppendInt(TextBuffer* text, long value);
+
+/*!
+ * \brief Дописывает целое число без знака
+ * \param[in] text Текст
+ * \param[in] value Число
+ */
+void textAppendUnsigned(TextBuffer* text, unsigned long long value);
+
+/*!
+ * \brief Дописывает число с фиксированным количеством знаков после
+ * запятой, как printf("%.*f", precision, value)
+ * \param[in] text Текст
+ * \param[in] value Число
+ * \param[in] precision Количество знаков после запятой
+ */
+void textAppendFixed(TextBuffer* text, double value, int precision);
+
+/*!
+ * \brief Дописывает число с 17 значащими цифрами, как printf("%.17g"):
+ * прочитанное обратно strtod, оно совпадает с исходным до бита
+ *
+ * Цифры вычисляются точно в 128-битной целочисленной арифметике для
+ * чисел от 1e-16 до 1e38 по модулю и нуля; остальные числа выводит
+ * printf.
+ * \param[in] text Текст
+ * \param[in] value Число
+ */
+void textAppendExact(TextBuffer* text, double value);
+
+/*!
+ * \brief Дописывает форматированную строку через vsnprintf (для редких
+ * сообщений, где скорость не важна)
+ * \param[in] text Текст
+ * \param[in] format Формат
+ * \param[in] ... Остальные параметры
+ */
+void textAppendFormat(TextBuffer* text, const char* format, ...);
+
+/*!
+ * \brief Разбирает название режима вывода
+ * \param[in] name "human", "compact" или "silent"
+ * \return Режим или -1, если название неизвестно
+ */
+int parseOutputMode(const char* name);
+
+#endif //INC_6_LAB_FORMAT_H
@@ -0,0 +1,200 @@
+/*! Функции ответа на запрос решения уравнений на сетке */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "grid.h"
+
+// Сохранённые значения корней блока: по два последних на каждый корень
+typedef struct
+{
+    double last[3];     // последнее значение корня
+    double previous[3]; // значение перед последним
+} RootHistory;
+
+// Функция для предсказания следующего значения корня k
+static uint64_t predictRoot(const RootHistory* history, int k)
+{
+    double prediction = 2 * history->last[k] - history->previous[k];
+    if (!isfinite(prediction))
+    {
+        prediction = history->last[k];
+    }
+    uint64_t bits;
+    memcpy(&bits, &prediction, sizeof(bits));
+    return bits;
+}
+
+// Функция для запоминания значения корня k
+static void rememberRoot(RootHistory* history, int k, double value)
+{
+    history->previous[k] = history->last[k];
+    history->last[k] = value;
+}
+
+// Функция для подсчёта значащих (ненулевых старших) байтов разности
+static int significantBytes(uint64_t difference)
+{
+    int bytes = 0;
+    while (difference != 0)
+    {
+        difference >>= 8;
+        bytes++;
+    }
+    return bytes;
+}
+
+// Функция для вычисления коэффициентов уравнения сетки
+void gridCoefficients(const Request* request, const long counts[4],
+                      long index, double coef[4])
+{
+    const double from[4] = {request->a, request->b, request->c, request->d};
+    // Быстрее всего меняется d, медленнее всего - a
+    for (int k = 3; k >= 0; k--)
+    {
+        long i = index % counts[k];
+        index /= counts[k];
+        coef[k] = from[k] + (double) i * request->step[k];
+    }
+}
+
+// Функция для решения уравнений блока и записи датаграммы блока
+int gridEncodeChunk(const Request* request, const long counts[4],
+                    long chunk, char* out, size_t size, int* warm)
+{
+    long total = counts[0] * counts[1] * counts[2] * counts[3];
+    long first = chunk * GRID_CHUNK_POINTS;
+    long last = first + GRID_CHUNK_POINTS < total ? first + GRID_CHUNK_POINTS
+                                                  : total;
+    int header = snprintf(out, size, "%s%ld %ld\n", GRID_REPLY_PREFIX,
+                          chunk, total);
+    // Худший случай - три корня без нулевых байтов в разностях
+    size_t worst = (size_t) (last - first) * (1 + 2 + 3 * sizeof(double));
+    if (header < 0 || (size_t) header + worst > size)
+    {
+        return -1;
+    }
+
+    unsigned char* p = (unsigned char*) out + header;
+    RootHistory history = {{0, 0, 0}, {0, 0, 0}};
+    EquationResult results[2];
+    const EquationResult* previous = NULL;
+    *warm = 0;
+    for (long i = first; i < last; i++)
+    {
+        double coef[4];
+        gridCoefficients(request, counts, i, coef);
+        if (coef[0] == 0)
+        {
+            *p++ = GRID_INVALID;
+            previous = NULL;
+            continue;
+        }
+        EquationResult* result = &results[i % 2];
+        *warm += ComputeSeeded(coef[0], coef[1], coef[2], coef[3], previous,
+                               result);
+        previous = result;
+
+        // Байты управления идут перед байтами корней, поэтому сначала
+        // считаем разности
+        uint64_t differences[3];
+        int bytes[3];
+        *p++ = (unsigned char) result->count;
+        unsigned char* control = p;
+        p += (result->count + 1) / 2;
+        memset(control, 0, (size_t) (p - control));
+        for (int k = 0; k < result->count; k++)
+        {
+            uint64_t bits;
+            memcpy(&bits, &result->roots[k], sizeof(bits));
+            differences[k] = bits ^ predictRoot(&history, k);
+            bytes[k] = significantBytes(differences[k]);
+            control[k / 2] |= (unsigned char) (bytes[k] << (k % 2 * 4));
+            rememberRoot(&history, k, result->roots[k]);
+        }
+        for (int k = 0; k < result->count; k++)
+        {
+            for (int j = 0; j < bytes[k]; j++)
+            {
+                *p++ = (unsigned char) (differences[k] >> (j * 8));
+            }
+        }
+    }
+    return (int) (p - (unsigned char*) out);
+}
+
+// Функция для разбора заголовка датаграммы блока
+int gridDecodeHeader(const char* data, int length, long* chunk, long* total)
+{
+    size_t prefix = strlen(GRID_REPLY_PREFIX);
+    const char* newline = memchr(data, '\n', (size_t) length);
+    if (newline == NULL || (size_t) length < prefix ||
+        memcmp(data, GRID_REPLY_PREFIX, prefix) != 0)
+    {
+        return -1;
+    }
+    char* next;
+    *chunk = strtol(data + prefix, &next, 10);
+    if (next == data + prefix || *next != ' ')
+    {
+        return -1;
+    }
+    *total = strtol(next + 1, &next, 10);
+    if (next != newline || *chunk < 0 || *total < 1 ||
+        *chunk > (*total - 1) / GRID_CHUNK_POINTS)
+    {
+        return -1;
+    }
+    return (int) (newline - data) + 1;
+}
+
+// Функция для восстановления результатов уравнений блока
+int gridDecodeChunk(const char* payload, int length, int points,
+                    EquationResult* results)
+{
+    const unsigned char* p = (const unsigned char*) payload;
+    const unsigned char* end = p + length;
+    RootHistory history = {{0, 0, 0}, {0, 0, 0}};
+    for (int i = 0; i < points; i++)
+    {
+        EquationResult* result = &results[i];
+        memset(result, 0, sizeof(*result));
+        if (p == end)
+        {
+            return -1;
+        }
+        int count = *p++;
+        if (count == GRID_INVALID)
+        {
+            continue;
+        }
+        const unsigned char* control = p;
+        p += (count + 1) / 2;
+        if (count > 3 || p > end)
+        {
+            return -1;
+        }
+        result->degree = 3;
+        result->count = count;
+        for (int k = 0; k < count; k++)
+        {
+            int bytes = control[k / 2] >> (k % 2 * 4) & 0x0F;
+            if (bytes > (int) sizeof(double) || end - p < bytes)
+            {
+                return -1;
+            }
+            uint64_t difference = 0;
+            for (int j = 0; j < bytes; j++)
+            {
+                difference |= (uint64_t) *p++ << (j * 8);
+            }
+            uint64_t bits = difference ^ predictRoot(&history, k);
+            memcpy(&result->roots[k], &bits, sizeof(bits));
+            rememberRoot(&history, k, result->roots[k]);
+        }
+    }
+    return p == end ? 0 : -1;
+}
@@ -0,0 +1,92 @@
+/*!
+ * \file grid.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение функций ответа на запрос
+ * решения уравнений на сетке коэффициентов (REQUEST_GRID, protocol.h).
+ * Сетка делится на блоки по GRID_CHUNK_POINTS уравнений; каждый блок
+ * уходит отдельной датаграммой, поэтому клиент может запросить заново
+ * только потерянные блоки, а обработчики сервера - решать разные блоки
+ * одновременно.
+ *
+ * Датаграмма блока - текстовый заголовок "grid K N\n" (K - номер блока,
+ * N - уравнений в сетке) и двоичные результаты уравнений блока по порядку.
+ * Результат уравнения - байт количества корней (GRID_INVALID - старший
+ * коэффициент равен 0), байты управления (по полбайта на корень: сколько
+ * младших байтов корня записано) и сами байты. Записываются не корни,
+ * а их разность (XOR) с линейным предсказанием по двум предыдущим
+ * значениям того же корня в блоке: у соседних уравнений сетки корни
+ * близки, и старшие байты разности - нули.
+*/
+
+#ifndef INC_6_LAB_GRID_H
+#define INC_6_LAB_GRID_H
+
+#include <stddef.h>
+
+#include "logic.h"
+#include "protocol.h"
+
+/*!
+ * \brief Префикс заголовка блока ответа
+ */
+#define GRID_REPLY_PREFIX "grid "
+
+/*!
+ * \brief Размер буфера датаграммы блока (с номером запроса и заголовком)
+ */
+#define GRID_REPLY_SIZE 8192
+
+/*!
+ * \brief Количество корней неверного уравнения в блоке
+ */
+#define GRID_INVALID 0xFF
+
+/*!
+ * \brief Вычисляет коэффициенты уравнения сетки
+ * \param[in] request Запрос REQUEST_GRID
+ * \param[in] counts Размеры сетки (gridPoints)
+ * \param[in] index Номер уравнения
+ * \param[out] coef Коэффициенты a, b, c, d
+ */
+void gridCoefficients(const Request* request, const long counts[4],
+                      long index, double coef[4]);
+
+/*!
+ * \brief Решает уравнения блока сетки и записывает датаграмму блока
+ *
+ * Уравнения решаются ComputeSeeded от решения предыдущего уравнения
+ * блока (первое уравнение блока - по формуле).
+ * \param[in] request Запрос REQUEST_GRID
+ * \param[in] counts Размеры сетки (gridPoints)
+ * \param[in] chunk Номер блока
+ * \param[out] out Буфер датаграммы
+ * \param[in] size Размер буфера
+ * \param[out] warm Количество уравнений, решённых уточнением
+ * \return Длина датаграммы или -1, если буфер мал
+ */
+int gridEncodeChunk(const Request* request, const long counts[4],
+                    long chunk, char* out, size_t size, int* warm);
+
+/*!
+ * \brief Разбирает заголовок датаграммы блока
+ * \param[in] data Датаграмма (без номера запроса)
+ * \param[in] length Длина датаграммы
+ * \param[out] chunk Номер блока
+ * \param[out] total Количество уравнений в сетке
+ * \return Длина заголовка или -1, если это не датаграмма блока
+ */
+int gridDecodeHeader(const char* data, int length, long* chunk, long* total);
+
+/*!
+ * \brief Восстанавливает результаты уравнений блока
+ * \param[in] payload Результаты после заголовка
+ * \param[in] length Длина результатов
+ * \param[in] points Количество уравнений в блоке
+ * \param[out] results Результаты (у неверных уравнений степень равна 0)
+ * \return 0 при успехе, -1, если результаты повреждены
+ */
+int gridDecodeChunk(const char* payload, int length, int points,
+                    EquationResult* results);
+
+#endif //INC_6_LAB_GRID_H
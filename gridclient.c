@@ -0,0 +1,288 @@
+/*! Функции клиента сетки коэффициентов */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "gridclient.h"
+#include "grid.h"
+#include "format.h"
+#include "signals.h"
+#include "timerwheel.h"
+
+#define GRID_RECEIVE_BUFFER (4 * 1024 * 1024) // буфер приёма сокета: окно
+                                              // блоков приходит разом
+#define GRID_PRECISION 6 // знаков после запятой в корнях
+
+// Состояние получения сетки
+typedef struct
+{
+    int sockfd;                // подключённый к серверу сокет
+    Request request;           // запрос сетки (диапазон блоков меняется)
+    long total;                // уравнений в сетке
+    long first;                // первый блок окна
+    long count;                // блоков в окне
+    unsigned char received[GRID_WINDOW_CHUNKS]; // пришедшие блоки окна
+    long missing;              // блоков окна, которых ещё нет
+    EquationResult* results;   // решения уравнений окна
+    uint64_t nextId;           // номер следующего запроса
+    unsigned long requests;    // отправлено запросов
+    unsigned long datagrams;   // принято блоков (с повторами)
+    unsigned long bytes;       // принято байтов
+} GridFetch;
+
+// Функция для запроса блоков [first, last]
+static int requestChunks(GridFetch* fetch, long first, long last)
+{
+    char message[MAXBUF];
+    fetch->request.id = fetch->nextId++;
+    fetch->request.firstChunk = first;
+    fetch->request.lastChunk = last;
+    int length = encodeRequest(message, sizeof(message), &fetch->request);
+    if (length == -1)
+    {
+        fprintf(stderr, "Запрос сетки не помещается в датаграмму.\n");
+        return -1;
+    }
+    // Сервер, который ещё не запущен, не отвечает так же, как потерянный
+    // ответ: блоки будут запрошены заново
+    if (send(fetch->sockfd, message, length, 0) == -1 &&
+        errno != ECONNREFUSED)
+    {
+        perror("send");
+        return -1;
+    }
+    fetch->requests++;
+    return 0;
+}
+
+// Функция для запроса недостающих блоков окна: каждый непрерывный
+// участок - отдельным запросом
+static int requestMissing(GridFetch* fetch)
+{
+    long i = 0;
+    while (i < fetch->count)
+    {
+        if (fetch->received[i])
+        {
+            i++;
+            continue;
+        }
+        long start = i;
+        while (i < fetch->count && !fetch->received[i])
+        {
+            i++;
+        }
+        if (requestChunks(fetch, fetch->first + start,
+                          fetch->first + i - 1) == -1)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Функция для приёма пришедших блоков
+static int receiveChunks(GridFetch* fetch)
+{
+    static char buffer[GRID_REPLY_SIZE + 1];
+    while (1)
+    {
+        ssize_t length = recv(fetch->sockfd, buffer, GRID_REPLY_SIZE,
+                              MSG_DONTWAIT);
+        if (length == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ||
+                errno == ECONNREFUSED)
+            {
+                return 0;
+            }
+            perror("recv");
+            return -1;
+        }
+        buffer[length] = '\0';
+        fetch->datagrams++;
+        fetch->bytes += (unsigned long) length;
+
+        // Блоки прошлых окон и повторы уже собранных не нужны
+        uint64_t id;
+        size_t prefix = decodeRequestId(buffer, (size_t) length, &id);
+        long chunk, total;
+        int header = gridDecodeHeader(buffer + prefix, (int) length - prefix,
+                                      &chunk, &total);
+        long slot = chunk - fetch->first;
+        if (header == -1 || total != fetch->total || slot < 0 ||
+            slot >= fetch->count || fetch->received[slot])
+        {
+            continue;
+        }
+        long firstPoint = chunk * GRID_CHUNK_POINTS;
+        long points = total - firstPoint < GRID_CHUNK_POINTS
+                      ? total - firstPoint : GRID_CHUNK_POINTS;
+        const char* payload = buffer + prefix + header;
+        if (gridDecodeChunk(payload, (int) (length - prefix - header),
+                            (int) points,
+                            &fetch->results[slot * GRID_CHUNK_POINTS]) == -1)
+        {
+            continue;
+        }
+        fetch->received[slot] = 1;
+        fetch->missing--;
+    }
+}
+
+// Функция для вывода решений собранного окна
+static void printWindow(const GridFetch* fetch, FILE* out)
+{
+    long first = fetch->first * GRID_CHUNK_POINTS;
+    long last = (fetch->first + fetch->count) * GRID_CHUNK_POINTS;
+    last = last < fetch->total ? last : fetch->total;
+    char line[1024];
+    for (long i = first; i < last; i++)
+    {
+        const EquationResult* result = &fetch->results[i - first];
+        TextBuffer text;
+        textInit(&text, line, sizeof(line));
+        if (result->degree == 0)
+        {
+            textAppendLiteral(&text, "-");
+        }
+        else
+        {
+            textAppendInt(&text, result->count);
+            for (int k = 0; k < result->count; k++)
+            {
+                textAppendLiteral(&text, " ");
+                textAppendFixed(&text, result->roots[k], GRID_PRECISION);
+            }
+        }
+        textAppendLiteral(&text, "\n");
+        fwrite(text.data, 1, text.length, out);
+    }
+}
+
+// Функция для получения одного окна блоков
+static int fetchWindow(GridFetch* fetch, int attemptTimeoutMs, int retries)
+{
+    memset(fetch->received, 0, sizeof(fetch->received));
+    fetch->missing = fetch->count;
+    if (requestChunks(fetch, fetch->first,
+                      fetch->first + fetch->count - 1) == -1)
+    {
+        return -1;
+    }
+    int attempts = 0;
+    while (fetch->missing > 0)
+    {
+        struct pollfd fds = {fetch->sockfd, POLLIN, 0};
+        int ready = poll(&fds, 1, attemptTimeoutMs);
+        if (ready == -1 && errno != EINTR)
+        {
+            perror("poll");
+            return -1;
+        }
+        if (ready > 0)
+        {
+            long missing = fetch->missing;
+            if (receiveChunks(fetch) == -1)
+            {
+                return -1;
+            }
+            // Пока блоки приходят, сервер ещё отвечает на запрос окна
+            if (fetch->missing < missing)
+            {
+                attempts = 0;
+            }
+            continue;
+        }
+        if (ready == 0)
+        {
+            if (attempts++ == retries)
+            {
+                return -1;
+            }
+            if (requestMissing(fetch) == -1)
+            {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Функция для получения и вывода решений уравнений сетки
+int gridFetch(const SocketAddress* server, const Request* grid,
+              int attemptTimeoutMs, int retries, FILE* out)
+{
+    GridFetch fetch;
+    memset(&fetch, 0, sizeof(fetch));
+    long counts[4];
+    fetch.request = *grid;
+    fetch.total = gridPoints(grid, counts);
+    fetch.nextId = 1;
+    if (fetch.total < 1)
+    {
+        fprintf(stderr, "Неверная сетка коэффициентов.\n");
+        return -1;
+    }
+    long chunks = (fetch.total - 1) / GRID_CHUNK_POINTS + 1;
+
+    // Подключённый сокет получает только датаграммы своего сервера
+    fetch.sockfd = socket(server->any.sa_family, SOCK_DGRAM, 0);
+    if (fetch.sockfd == -1)
+    {
+        perror("socket");
+        return -1;
+    }
+    int size = GRID_RECEIVE_BUFFER;
+    if (setsockopt(fetch.sockfd, SOL_SOCKET, SO_RCVBUF, &size,
+                   sizeof(size)) == -1)
+    {
+        perror("setsockopt(SO_RCVBUF)");
+    }
+    if (connect(fetch.sockfd, &server->any, addressLength(server)) == -1)
+    {
+        perror("connect");
+        close(fetch.sockfd);
+        return -1;
+    }
+    fetch.results = malloc(GRID_WINDOW_CHUNKS * GRID_CHUNK_POINTS *
+                           sizeof(EquationResult));
+    if (fetch.results == NULL)
+    {
+        perror("malloc");
+        close(fetch.sockfd);
+        return -1;
+    }
+
+    int result = 0;
+    uint64_t start = monotonicMs();
+    for (fetch.first = 0; fetch.first < chunks;
+         fetch.first += GRID_WINDOW_CHUNKS)
+    {
+        fetch.count = chunks - fetch.first < GRID_WINDOW_CHUNKS
+                      ? chunks - fetch.first : GRID_WINDOW_CHUNKS;
+        result = fetchWindow(&fetch, attemptTimeoutMs, retries);
+        if (result == -1)
+        {
+            fprintf(stderr, "Сервер не прислал блоки %ld-%ld сетки.\n",
+                    fetch.first, fetch.first + fetch.count - 1);
+            break;
+        }
+        printWindow(&fetch, out);
+    }
+    uint64_t elapsed = monotonicMs() - start;
+    writeLog("Сетка: уравнений %ld, блоков %ld, запросов %lu, принято "
+             "блоков %lu, байтов %lu (%.2f на уравнение), %lu мс\n",
+             fetch.total, chunks, fetch.requests, fetch.datagrams,
+             fetch.bytes, (double) fetch.bytes / fetch.total,
+             (unsigned long) elapsed);
+
+    free(fetch.results);
+    close(fetch.sockfd);
+    return result;
+}
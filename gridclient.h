@@ -0,0 +1,41 @@
+/*!
+ * \file gridclient.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение функции клиента, получающей
+ * решения уравнений сетки коэффициентов (REQUEST_GRID, grid.h). Клиент
+ * запрашивает блоки окнами по GRID_WINDOW_CHUNKS, собирает пришедшие
+ * блоки окна и запрашивает заново только недостающие; решения окна
+ * выводятся по порядку уравнений, как только окно собрано.
+*/
+
+#ifndef INC_6_LAB_GRIDCLIENT_H
+#define INC_6_LAB_GRIDCLIENT_H
+
+#include <stdio.h>
+
+#include "protocol.h"
+#include "address.h"
+
+/*!
+ * \brief Блоков сетки в одном окне запросов: столько сервер отправляет
+ * в ответ на один запрос
+ */
+#define GRID_WINDOW_CHUNKS GRID_MAX_CHUNKS
+
+/*!
+ * \brief Получает решения уравнений сетки и выводит их
+ *
+ * Решение уравнения выводится строкой "k x1 ... xk" (k - количество
+ * корней) или "-", если старший коэффициент уравнения равен 0.
+ * \param[in] server Адрес сервера
+ * \param[in] grid Запрос REQUEST_GRID
+ * \param[in] attemptTimeoutMs Ожидание блоков до повторного запроса, мс
+ * \param[in] retries Повторных запросов окна подряд без новых блоков
+ * \param[in] out Поток вывода решений
+ * \return 0 при успехе, -1 при ошибке или если сервер не ответил
+ */
+int gridFetch(const SocketAddress* server, const Request* grid,
+              int attemptTimeoutMs, int retries, FILE* out);
+
+#endif //INC_6_LAB_GRIDCLIENT_H
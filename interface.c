@@ -6,23 +6,45 @@
 
 #include "interface.h"
 
+// Подсказка по запуску клиента
+#define CLIENT_USAGE \
+    "Использование: ./client [-H host[:port]]... [-p port] [-l logFile] " \
+    "[-t timeout]\n" \
+    "                        [-i] -a a -b b -c c [-d d]\n" \
+    "               ./client [-H host[:port]]... [-p port] [-l logFile] " \
+    "[-t timeout]\n" \
+    "                        [-i] -f file [-n inFlight] [-r retries] " \
+    "[-m ms]\n" \
+    "               ./client [-H host[:port]]... [-p port] [-l logFile] " \
+    "[-t timeout] -s\n" \
+    "               ./client [-H host[:port]]... [-p port] [-l logFile] " \
+    "[-t timeout]\n" \
+    "                        -g \"a0[:a1:da] b0[:b1:db] c0[:c1:dc] " \
+    "[d0[:d1:dd]]\" [-r retries] [-m ms]\n"
+
+// Функция для разбора номера порта
+static int parsePort(const char* text)
+{
+    char* end;
+    long port = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || port < 1 || port > 65535)
+    {
+        return -1;
+    }
+    return (int) port;
+}
+
 // Функция для обработки аргументов из командной строки для клиента
 int
-ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
-                double *a,
-                double *b, double *c,
-                double *d)
+ParseArgsClient(int argc, char *argv[], ClientOptions *options)
                 {
     // Объявляем переменную для хранения кода возврата функции getopt
     int opt;
 
-    // Проверяем количество аргументов командной строки
-    // Проверяем, что аргументов 7, 9, 11, 13
-    if (argc != 7 && argc != 9 && argc != 11 && argc != 13)
+    // Проверяем, что аргументы заданы
+    if (argc < 2)
     {
-        fprintf(stderr,
-                "Использование: ./client [-l logFile] [-t timeout] "
-                "-a a -b b -c c [-d d]\n");
+        fputs(CLIENT_USAGE, stderr);
         return -1;
     }
 
@@ -43,17 +65,79 @@ ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
     //  указатель на первый символ, который не является частью числа.
     //  Если этот символ не равен нулевому символу ‘\0’, то это означает,
     //  что строка содержит неверный формат числа.
-    while ((opt = getopt(argc, argv, "a:b:c:d:t:l:")) != -1)
+    while ((opt = getopt(argc, argv, "a:b:c:d:t:l:isf:g:n:r:m:H:p:")) != -1)
     {
         switch (opt)
         {
+            case 'H':
+                // Адрес сервера; серверов может быть несколько
+                if (options->hostCount == MAX_SERVERS)
+                {
+                    fprintf(stderr, "Серверов может быть не больше %d.\n",
+                            MAX_SERVERS);
+                    return -1;
+                }
+                options->hosts[options->hostCount++] = optarg;
+                break;
+            case 'p':
+                // Порт сервера
+                options->port = parsePort(optarg);
+                if (options->port == -1)
+                {
+                    fprintf(stderr, "Неверный номер порта: %s\n", optarg);
+                    return -1;
+                }
+                break;
             case 'l':
                 // Имя файла журнала
-                *logFile = optarg;
+                options->logFile = optarg;
                 break;
             case 't':
                 // Время ожидания ввода пользователя
-                *timeout = atoi(optarg);
+                options->timeout = atoi(optarg);
+                break;
+            case 'i':
+                // Запросить гарантированные границы корней
+                options->certified = 1;
+                break;
+            case 's':
+                // Запросить статистику сервера вместо решения уравнения
+                options->stats = 1;
+                break;
+            case 'f':
+                // Файл с уравнениями, по одному в строке ("-" - stdin)
+                options->inputFile = optarg;
+                break;
+            case 'g':
+                // Сетка коэффициентов: решения всех её уравнений
+                options->grid = optarg;
+                break;
+            case 'n':
+                // Наибольшее число запросов в полёте
+                options->inFlight = atoi(optarg);
+                if (options->inFlight < 1)
+                {
+                    fprintf(stderr, "Неверное значение опции -n.\n");
+                    return -1;
+                }
+                break;
+            case 'r':
+                // Количество повторных отправок без ответа
+                options->retries = atoi(optarg);
+                if (options->retries < 0)
+                {
+                    fprintf(stderr, "Неверное значение опции -r.\n");
+                    return -1;
+                }
+                break;
+            case 'm':
+                // Ожидание ответа на одну попытку в миллисекундах
+                options->attemptTimeoutMs = atoi(optarg);
+                if (options->attemptTimeoutMs < 1)
+                {
+                    fprintf(stderr, "Неверное значение опции -m.\n");
+                    return -1;
+                }
                 break;
             case 'a':
                 // Проверяем флаг a
@@ -70,7 +154,7 @@ ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
                     aFlag = 1; // Устанавливаем флаг a в 1
                 }
                 // Преобразуем строку в число с плавающей точкой и сохраняем в указателе a
-                *a = strtod(optarg,
+                options->a = strtod(optarg,
                             &endptrA); // Присваиваем значение и адрес конца числа
                 if (*endptrA !=
                     '\0')
@@ -96,7 +180,7 @@ ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
                 }
                 // Преобразуем строку в число с плавающей точкой и сохраняем в указателе b
 
-                *b = strtod(optarg,
+                options->b = strtod(optarg,
                             &endptrB); // Присваиваем значение и адрес конца числа
                 if (*endptrB !=
                     '\0')
@@ -122,7 +206,7 @@ ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
                 }
                 // Преобразуем строку в число с плавающей точкой и сохраняем в указателе c
 
-                *c = strtod(optarg,
+                options->c = strtod(optarg,
                             &endptrC); // Присваиваем значение и адрес конца числа
                 if (*endptrC !=
                     '\0')
@@ -147,7 +231,7 @@ ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
                     dFlag = 1; // Устанавливаем флаг d в 1
                 }
                 // Преобразуем строку в число с плавающей точкой и сохраняем в указателе d
-                *d = strtod(optarg,
+                options->d = strtod(optarg,
                             &endptrD); // Присваиваем значение и адрес конца числа
                 if (*endptrD !=
                     '\0')
@@ -159,15 +243,27 @@ ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
                 }
                 break;
             default:
-                fprintf(stderr,
-                        "Использование: ./client [-l logFile] "
-                        "[-t timeout] -a a -b b -c c [-d d]\n");
+                fputs(CLIENT_USAGE, stderr);
                 return -1;
         }
     }
 
+    // Для запроса статистики, чтения из файла и сетки коэффициенты не нужны
+    if (options->stats || options->inputFile != NULL || options->grid != NULL)
+    {
+        return 0;
+    }
+
+    // Проверяем, что заданы обязательные коэффициенты
+    if (aFlag == 0 || bFlag == 0 || cFlag == 0)
+    {
+        fprintf(stderr, "Опции -a, -b и -c обязательны.\n");
+        return -1;
+    }
+
     // Проверяем, что коэффициенты уравнения не равны нулю или единице
-    if (*a == 0 || *a == 1 || *b == 0 || *b == 1 || *c == 0 || *c == 1)
+    if (options->a == 0 || options->a == 1 || options->b == 0 ||
+        options->b == 1 || options->c == 0 || options->c == 1)
     {
         fprintf(stderr, "Неверные коэффициенты.\n");
         return -1;
@@ -177,26 +273,174 @@ ParseArgsClient(int argc, char *argv[], char **logFile, int *timeout,
     return 0;
 }
 
+// Функция для разбора списка процессоров
+int parseCpuList(const char* list, int* cpus, int max)
+{
+    int count = 0;
+    const char* p = list;
+    while (*p != '\0')
+    {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p || first < 0)
+        {
+            return -1;
+        }
+        p = end;
+        // Диапазон вида "4-7"
+        if (*p == '-')
+        {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first)
+            {
+                return -1;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            if (count == max)
+            {
+                return -1;
+            }
+            cpus[count++] = (int) cpu;
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p != '\0')
+        {
+            return -1;
+        }
+    }
+    return count;
+}
+
 // Функция для разбора аргументов командной строки сервера
-void parseArgsServer(int argc, char* argv[], char** logFile, int* timeout)
+void parseArgsServer(int argc, char* argv[], ServerOptions* options)
 {
     int opt;
     // Опции для getopt
-    const char* optstring = "l:t:";
+    const char* optstring = "l:t:gw:C:No:R:b:DH:p:c:e:P:";
     // Парсим аргументы с помощью getopt
     while ((opt = getopt(argc, argv, optstring)) != -1)
     {
         switch (opt) {
             case 'l': // имя файла журнала
-                *logFile = optarg;
+                options->logFile = optarg;
                 break;
             case 't': // время ожидания сообщений от клиента
-                *timeout = atoi(optarg);
+                options->timeout = atoi(optarg);
+                break;
+            case 'g': // выделять пул буферов в huge pages
+                options->hugePages = 1;
+                break;
+            case 'w': // количество обработчиков
+                options->workers = atoi(optarg);
+                if (options->workers < 1 || options->workers > MAX_WORKERS)
+                {
+                    fprintf(stderr, "Количество обработчиков должно быть "
+                                    "от 1 до %d.\n", MAX_WORKERS);
+                    exit(1);
+                }
+                break;
+            case 'C': // список процессоров для обработчиков
+                options->cpuCount = parseCpuList(optarg, options->cpus,
+                                                 MAX_WORKERS);
+                if (options->cpuCount <= 0)
+                {
+                    fprintf(stderr, "Неверный список процессоров: %s\n",
+                            optarg);
+                    exit(1);
+                }
+                break;
+            case 'N': // размещать память на узле NUMA обработчика
+                options->numa = 1;
+                break;
+            case 'o': // режим вывода запросов
+            {
+                int mode = parseOutputMode(optarg);
+                if (mode == -1)
+                {
+                    fprintf(stderr, "Режим вывода должен быть human, "
+                                    "compact или silent.\n");
+                    exit(1);
+                }
+                options->output = mode;
+                break;
+            }
+            case 'R': // запросов в секунду на клиента
+                options->rateLimit = atoi(optarg);
+                if (options->rateLimit < 0)
+                {
+                    fprintf(stderr, "Ограничение частоты запросов не может "
+                                    "быть отрицательным.\n");
+                    exit(1);
+                }
+                break;
+            case 'b': // запросов подряд сверх ограничения
+                options->burst = atoi(optarg);
+                if (options->burst < 1)
+                {
+                    fprintf(stderr, "Размер пачки запросов должен быть "
+                                    "положительным.\n");
+                    exit(1);
+                }
+                break;
+            case 'D': // отбрасывать лишние запросы без ответа
+                options->dropShed = 1;
+                break;
+            case 'H': // адрес, на котором слушает сервер
+                if (options->hostCount == MAX_LISTEN)
+                {
+                    fprintf(stderr, "Адресов может быть не больше %d.\n",
+                            MAX_LISTEN);
+                    exit(1);
+                }
+                options->hosts[options->hostCount++] = optarg;
+                break;
+            case 'p': // порт сервера
+                options->port = parsePort(optarg);
+                if (options->port == -1)
+                {
+                    fprintf(stderr, "Неверный номер порта: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'c': // файл постоянного кэша корней
+                options->rootCache = optarg;
+                break;
+            case 'e': // записей в новом файле кэша корней
+                options->rootCacheEntries = atol(optarg);
+                if (options->rootCacheEntries < 1)
+                {
+                    fprintf(stderr, "Размер кэша корней должен быть "
+                                    "положительным.\n");
+                    exit(1);
+                }
+                break;
+            case 'P': // количество процессов-обработчиков
+                options->processes = atoi(optarg);
+                if (options->processes < 1 ||
+                    options->processes > MAX_WORKERS)
+                {
+                    fprintf(stderr, "Количество процессов должно быть "
+                                    "от 1 до %d.\n", MAX_WORKERS);
+                    exit(1);
+                }
                 break;
             default: // неверный аргумент
                 fprintf(stderr,
-                        "Использование: %s [-l logFile] [-t timeout]\n", argv[0]);
+                        "Использование: %s [-H host[:port]]... [-p port] "
+                        "[-l logFile] [-t timeout] [-g] "
+                        "[-w workers] [-C cpuList] [-N] "
+                        "[-o human|compact|silent] [-R rate] [-b burst] [-D] "
+                        "[-c rootCache] [-e entries] [-P processes]\n",
+                        argv[0]);
                 exit(1);
         }
     }
-}
\ No newline at end of file
+}
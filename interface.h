@@ -9,30 +9,101 @@
 #ifndef INC_5_LAB_INTERFACE_H
 #define INC_5_LAB_INTERFACE_H
 
+#include "format.h"
+
 /*!
- * \brief Разбирает аргументы командной строки
+ * \brief Максимальное количество серверов клиента
+ */
+#define MAX_SERVERS 16
+
+/*!
+ * \brief Параметры запуска клиента
+ */
+typedef struct
+{
+    char* logFile;        /*!< Имя файла журнала */
+    int timeout;          /*!< Время ожидания в секундах */
+    double a;             /*!< Первый коэффициент */
+    double b;             /*!< Второй коэффициент */
+    double c;             /*!< Третий коэффициент */
+    double d;             /*!< Четвёртый коэффициент */
+    int certified;        /*!< Запросить гарантированные границы корней */
+    int stats;            /*!< Запросить статистику сервера */
+    char* inputFile;      /*!< Файл с уравнениями ("-" - stdin) */
+    char* grid;           /*!< Сетка коэффициентов "a b c [d]" (grid.h) */
+    int inFlight;         /*!< Наибольшее число запросов в полёте */
+    int retries;          /*!< Количество повторных отправок */
+    int attemptTimeoutMs; /*!< Ожидание ответа на одну попытку, мс */
+    char* hosts[MAX_SERVERS]; /*!< Адреса серверов ("узел[:порт]") */
+    int hostCount;        /*!< Количество серверов (0 - сервер
+                               по умолчанию) */
+    int port;             /*!< Порт серверов, для которых он не указан */
+} ClientOptions;
+
+/*!
+ * \brief Разбирает аргументы командной строки клиента
  * \param[in] argc Количество аргументов командной строки
  * \param[in] argv Массив указателей на строки, содержащие аргументы
- * \param[in] logFile Указатель на название log файла
- * \param[in] logFile Указатель на время ожидания
- * \param[in] a Указатель на первый коэффициент
- * \param[in] b Указатель на второй коэффициент
- * \param[in] c Указатель на третий коэффициент
- * \param[in] d Указатель на четвёртый коэффициент
+ * \param[in,out] options Параметры запуска (заполнены значениями
+ * по умолчанию)
  * \return Код ошибки
  */
-int
-ParseArgsClient(int argc, char* argv[], char** logFile, int* timeout, double* a,
-          double* b, double* c,
-          double* d);
+int ParseArgsClient(int argc, char* argv[], ClientOptions* options);
+
+/*!
+ * \brief Максимальное количество обработчиков сервера
+ */
+#define MAX_WORKERS 64
+
+/*!
+ * \brief Максимальное количество адресов, на которых слушает сервер
+ */
+#define MAX_LISTEN 8
+
+/*!
+ * \brief Параметры запуска сервера
+ */
+typedef struct
+{
+    char* logFile;          /*!< Имя файла журнала */
+    int timeout;            /*!< Время ожидания сообщений от клиента */
+    int hugePages;          /*!< Выделять пулы буферов в huge pages */
+    int workers;            /*!< Количество потоков-обработчиков */
+    int cpus[MAX_WORKERS];  /*!< Процессоры, к которым привязаны обработчики */
+    int cpuCount;           /*!< Длина списка процессоров (0 - без привязки) */
+    int numa;               /*!< Размещать сокет и буферы на узле NUMA
+                                 процессора обработчика */
+    OutputMode output;      /*!< Вывод запросов на экран и в журнал */
+    int rateLimit;          /*!< Запросов в секунду на клиента (0 - без
+                                 ограничения) */
+    int burst;              /*!< Запросов подряд сверх ограничения */
+    int dropShed;           /*!< Отбрасывать лишние запросы без ответа */
+    char* hosts[MAX_LISTEN]; /*!< Адреса, на которых слушает сервер
+                                 ("узел[:порт]") */
+    int hostCount;          /*!< Количество адресов (0 - адрес по умолчанию) */
+    int port;               /*!< Порт адресов, для которых он не указан */
+    char* rootCache;        /*!< Файл постоянного кэша корней (NULL - без
+                                 кэша) */
+    long rootCacheEntries;  /*!< Записей в новом файле кэша корней */
+    int processes;          /*!< Процессов-обработчиков (0 - обработчики -
+                                 потоки одного процесса) */
+} ServerOptions;
+
+/*!
+ * \brief Разбирает список процессоров вида "0,2,4-7"
+ * \param[in] list Строка со списком
+ * \param[out] cpus Массив номеров процессоров
+ * \param[in] max Размер массива
+ * \return Количество процессоров в списке или -1 при ошибке
+ */
+int parseCpuList(const char* list, int* cpus, int max);
 
 /*!
  * \brief Разбирает аргументы командной строки
  * \param[in] argc Количество аргументов командной строки
  * \param[in] argv Массив указателей на строки, содержащие аргументы
- * \param[in] logFile Указатель на название log файла
- * \param[in] logFile Указатель на время ожидания
+ * \param[out] options Параметры запуска сервера
  */
-void parseArgsServer(int argc, char* argv[], char** logFile, int* timeout);
+void parseArgsServer(int argc, char* argv[], ServerOptions* options);
 
 #endif //INC_5_LAB_INTERFACE_H
@@ -0,0 +1,329 @@
+/*! Генератор нагрузки */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+#include "loadgen.h"
+#include "protocol.h"
+#include "aclient.h"
+#include "address.h"
+
+#define ATTEMPT_TIMEOUT_MS 1000 // ожидание ответа на одну попытку
+#define RETRIES 2 // повторных отправок без ответа
+#define NOISY_BATCH 64 // наибольшая пачка запросов шумной группы за проход
+
+// Результаты прогона
+typedef struct
+{
+    double* latencies; // задержки ответов в микросекундах
+    int completed;     // получено ответов
+    int lost;          // запросов без ответа
+    int busy;          // запросов, отклонённых сервером
+} LoadResult;
+
+// Шумная группа: клиенты, которые шлют запросы с заданной частотой,
+// не дожидаясь ответов
+typedef struct
+{
+    int* sockets;           // подключённые сокеты (по адресу на клиента)
+    int count;              // количество клиентов
+    long rate;              // запросов в секунду на всю группу
+    uint64_t startUs;       // начало отправки
+    unsigned long sent;     // отправлено запросов
+    unsigned long answered; // получено ответов с решением
+    unsigned long busy;     // получено отказов "сервер занят"
+} NoisyGroup;
+
+// Случайный коэффициент, не равный нулю или единице
+static double randomCoef(unsigned int* seed)
+{
+    return 2 + rand_r(seed) % 98 + (rand_r(seed) % 100) / 100.0;
+}
+
+// Обработчик завершения запроса: запоминает задержку
+static void onReply(AsyncRequest* request, void* context)
+{
+    LoadResult* result = context;
+    if (request->status == ASYNC_BUSY)
+    {
+        result->busy++;
+        return;
+    }
+    if (request->status != ASYNC_OK)
+    {
+        result->lost++;
+        return;
+    }
+    result->latencies[result->completed++] =
+            (double) (request->finishedUs - request->startedUs);
+}
+
+// Сравнение задержек для qsort
+static int compareDouble(const void* x, const void* y)
+{
+    double a = *(const double*) x;
+    double b = *(const double*) y;
+    return (a > b) - (a < b);
+}
+
+// Перцентиль отсортированного массива
+static double percentile(const double* sorted, int count, double p)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    int index = (int) (p / 100 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+// Открывает сокеты шумной группы: у каждого свой порт, то есть для
+// сервера это разные клиенты
+static int noisyInit(NoisyGroup* noisy, const SocketAddress* server,
+                     int count, long rate)
+{
+    memset(noisy, 0, sizeof(*noisy));
+    if (rate == 0)
+    {
+        return 0;
+    }
+    noisy->sockets = malloc(sizeof(int) * count);
+    if (noisy->sockets == NULL)
+    {
+        perror("malloc");
+        return -1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        int sockfd = socket(server->any.sa_family,
+                            SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        if (sockfd == -1 || connect(sockfd, &server->any,
+                                    addressLength(server)) == -1)
+        {
+            perror("socket");
+            return -1;
+        }
+        noisy->sockets[i] = sockfd;
+        noisy->count++;
+    }
+    noisy->rate = rate;
+    noisy->startUs = monotonicUs();
+    return 0;
+}
+
+// Отправляет запросы шумной группы, накопившиеся к текущему моменту
+static void noisySend(NoisyGroup* noisy, unsigned int* seed)
+{
+    uint64_t elapsed = monotonicUs() - noisy->startUs;
+    unsigned long due = (unsigned long) (elapsed * noisy->rate / 1000000);
+    for (int i = 0; i < NOISY_BATCH && noisy->sent < due; i++)
+    {
+        Request request = {
+            .type = REQUEST_SOLVE, .a = randomCoef(seed),
+            .b = randomCoef(seed), .c = randomCoef(seed),
+            .d = randomCoef(seed)
+        };
+        char message[MAXBUF];
+        int length = encodeRequest(message, sizeof(message), &request);
+        int sockfd = noisy->sockets[noisy->sent % noisy->count];
+        // Переполненный буфер сокета - тоже потерянный запрос
+        send(sockfd, message, length, 0);
+        noisy->sent++;
+    }
+}
+
+// Читает ответы шумной группы
+static void noisyDrain(NoisyGroup* noisy)
+{
+    char reply[MAXBUF];
+    for (int i = 0; i < noisy->count; i++)
+    {
+        ssize_t length;
+        while ((length = recv(noisy->sockets[i], reply, sizeof(reply) - 1,
+                              0)) >= 0)
+        {
+            reply[length] = '\0';
+            if (strcmp(reply, BUSY_REPLY) == 0)
+            {
+                noisy->busy++;
+            }
+            else
+            {
+                noisy->answered++;
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int concurrency = 1; // запросов в полёте
+    int requests = 1000; // всего запросов
+    long rate = 0; // запросов в секунду (0 - без ограничения)
+    long noisyRate = 0; // запросов в секунду от шумной группы
+    int noisyClients = 1; // клиентов в шумной группе
+    char* hosts[RING_MAX_SERVERS] = {DEFAULT_HOST}; // адреса серверов
+    int hostCount = 0; // количество серверов (0 - сервер по умолчанию)
+    int port = DEFAULT_PORT; // порт серверов, для которых он не указан
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:n:r:N:S:H:p:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'H':
+                if (hostCount == RING_MAX_SERVERS)
+                {
+                    fprintf(stderr, "Слишком много серверов.\n");
+                    return 1;
+                }
+                hosts[hostCount++] = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'c':
+                concurrency = atoi(optarg);
+                break;
+            case 'n':
+                requests = atoi(optarg);
+                break;
+            case 'r':
+                rate = atol(optarg);
+                break;
+            case 'N':
+                noisyRate = atol(optarg);
+                break;
+            case 'S':
+                noisyClients = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Использование: %s [-H host[:port]]... "
+                                "[-p port] [-c concurrency] [-n requests] "
+                                "[-r rate] [-N noisyRate] "
+                                "[-S noisyClients]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (concurrency < 1 || requests < 1 || rate < 0 || noisyRate < 0 ||
+        noisyClients < 1)
+    {
+        fprintf(stderr, "Количество запросов должно быть положительным.\n");
+        return 1;
+    }
+
+    LoadResult result = {malloc(sizeof(double) * requests), 0, 0, 0};
+    if (result.latencies == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    SocketAddress servers[RING_MAX_SERVERS];
+    hostCount = hostCount > 0 ? hostCount : 1;
+    for (int i = 0; i < hostCount; i++)
+    {
+        if (addressParse(hosts[i], port, &servers[i]) == -1)
+        {
+            fprintf(stderr, "Неверный адрес сервера: %s\n", hosts[i]);
+            return 1;
+        }
+    }
+
+    // Все запросы держит в полёте один поток; с несколькими серверами
+    // запросы распределяются по кольцу согласованного хеширования
+    AsyncClient client;
+    if (asyncClientInit(&client, servers, hostCount, concurrency,
+                        ATTEMPT_TIMEOUT_MS, RETRIES, onReply) == -1)
+    {
+        return 1;
+    }
+    // Шумная группа работает в том же потоке и будит его каждую
+    // миллисекунду, чтобы держать заданную частоту. Она шлёт запросы
+    // первому серверу
+    NoisyGroup noisy;
+    if (noisyInit(&noisy, &servers[0], noisyClients, noisyRate) == -1)
+    {
+        return 1;
+    }
+
+    unsigned int seed = 12345u;
+    unsigned int noisySeed = 54321u;
+    uint64_t start = monotonicUs();
+    int submitted = 0;
+    // Без ограничения частоты ждать событий можно сколько угодно
+    int pollMs = rate > 0 || noisy.count > 0 ? 1 : -1;
+    while (submitted < requests || client.inFlight > 0)
+    {
+        // Заполняем окно новыми запросами, не обгоняя заданную частоту
+        long due = rate > 0 ? (long) ((monotonicUs() - start) * rate / 1000000)
+                            : requests;
+        while (submitted < requests && submitted <= due)
+        {
+            Request request = {
+                .type = REQUEST_SOLVE, .a = randomCoef(&seed),
+                .b = randomCoef(&seed), .c = randomCoef(&seed),
+                .d = randomCoef(&seed)
+            };
+            if (asyncClientSubmit(&client, &request, &result) == NULL)
+            {
+                break;
+            }
+            submitted++;
+        }
+        if (noisy.count > 0)
+        {
+            noisySend(&noisy, &noisySeed);
+            noisyDrain(&noisy);
+        }
+        if (asyncClientPoll(&client, pollMs) == -1)
+        {
+            return 1;
+        }
+    }
+    double elapsed = (monotonicUs() - start) / 1e6;
+
+    qsort(result.latencies, result.completed, sizeof(double), compareDouble);
+    printf("Запросов: %d, потеряно: %d, отклонено: %d, повторных "
+           "отправок: %lu, время: %.3f с, %.0f запросов/с\n",
+           result.completed + result.lost + result.busy, result.lost,
+           result.busy, client.retransmits, elapsed,
+           result.completed / elapsed);
+    printf("Задержка, мкс: p50 = %.1f, p90 = %.1f, p99 = %.1f, "
+           "p99.9 = %.1f, max = %.1f\n",
+           percentile(result.latencies, result.completed, 50),
+           percentile(result.latencies, result.completed, 90),
+           percentile(result.latencies, result.completed, 99),
+           percentile(result.latencies, result.completed, 99.9),
+           result.completed > 0 ? result.latencies[result.completed - 1] : 0);
+
+    for (int i = 0; hostCount > 1 && i < hostCount; i++)
+    {
+        printf("Сервер %s: отправлено %lu, ответов %lu, отказов %lu\n",
+               hosts[i], client.health[i].sent, client.health[i].answered,
+               client.health[i].failovers);
+    }
+
+    if (noisy.count > 0)
+    {
+        noisyDrain(&noisy);
+        printf("Шумная группа (%d клиентов): отправлено %lu, решено %lu, "
+               "отклонено %lu, без ответа %lu\n", noisy.count, noisy.sent,
+               noisy.answered, noisy.busy,
+               noisy.sent - noisy.answered - noisy.busy);
+        for (int i = 0; i < noisy.count; i++)
+        {
+            close(noisy.sockets[i]);
+        }
+        free(noisy.sockets);
+    }
+
+    asyncClientDestroy(&client);
+    free(result.latencies);
+    return 0;
+}
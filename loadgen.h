@@ -0,0 +1,20 @@
+/*!
+ * \file loadgen.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение основной функции генератора
+ * нагрузки, измеряющего задержку ответов сервера.
+*/
+
+#ifndef INC_6_LAB_LOADGEN_H
+#define INC_6_LAB_LOADGEN_H
+
+/*!
+ * \brief Отправляет серверу поток запросов и выводит распределение задержек
+ * \param[in] argc Количество аргументов командной строки
+ * \param[in] argv Массив указателей на строки, содержащие аргументы
+ * \return Код завершения
+ */
+int main(int argc, char* argv[]);
+
+#endif //INC_6_LAB_LOADGEN_H
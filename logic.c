@@ -2,84 +2,1798 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <float.h>
+#include <limits.h>
 
 #include "logic.h"
+#include "format.h"
+#include "fastmath.h"
 
-// Функция для решения квадратного уравнения и вывода разложения на множители
-void SolveQuadratic(double a, double b, double c)
+#define SEED_ITERATIONS 3 // итераций Галлея до отказа от тёплого старта
+#define SEED_CONVERGED 1e-8 // относительный шаг, после которого корень точен
+#define SEED_REACH 0.05 // относительный шаг, при котором приближение далеко
+#define SEED_SEPARATION 1e-4 // относительное расстояние между корнями,
+                             // ниже которого они считаются слившимися
+#define SWEEP_PRECISION 6 // знаков после точки в ответе на запрос пути
+#define BATCH_BLOCK 256 // уравнений в блоке пакетного решателя
+#define EVAL_LANES 8 // точек в группе векторного вычисления значений
+#define EVAL_SPLIT 134217729.0 // 2^27 + 1: множитель разбиения Вельткампа
+#define ADAPTIVE_TOLERANCE 1e-12 // относительная поправка корня, после
+                                 // которой решение повторяется в long double
+#define ADAPTIVE_CASE_MARGIN 16 // запас оценки ошибки дискриминанта
+#define ADAPTIVE_ROOT_STEPS 200 // шагов поиска корня на отрезке
+#define ADAPTIVE_SAFE_X 0x1p100 // граница |x| и 1/|x|, до которой
+                                // многочлен вычисляется без масштабирования
+#define ADAPTIVE_SAFE_SIZE 0x1p600 // то же для суммы модулей слагаемых
+#define ADAPTIVE_DOUBLE_MARGIN 256 // запас оценки значения многочлена
+                                   // в кратном корне, в DBL_EPSILON^2
+#define FAST_GROUP 64 // уравнений в группе быстрого решателя
+
+// Функция для вычисления корней квадратного уравнения
+void ComputeQuadratic(double a, double b, double c, EquationResult* result)
 {
-    printf("Коэффициенты квадратного уравнения: a = %.2f, b = %.2f, c = %.2f\n",
-           a, b, c); // выводим коэффициенты
     double d = b * b - 4 * a * c; // дискриминант
+    result->degree = 2;
     if (d < 0)
     {
-        printf("Уравнение не имеет действительных корней.\n");
+        result->rootCase = ROOTS_NONE;
+        result->count = 0;
     }
     else if (d == 0)
     {
-        double x = -b / (2 * a); // единственный корень
-        printf("Уравнение имеет один действительный корень: x = %.2f\n", x);
-        printf("Разложение на множители: (%.2f)x + %.2f = 0\n", a, b);
+        result->rootCase = ROOTS_SINGLE;
+        result->count = 1;
+        result->roots[0] = -b / (2 * a); // единственный корень
     }
     else
     {
-        double x1 = (-b + sqrt(d)) / (2 * a); // первый корень
-        double x2 = (-b - sqrt(d)) / (2 * a); // второй корень
-        printf("Уравнение имеет два действительных корня: x1 = %.2f, x2 = %.2f\n",
-               x1, x2);
-        printf("Разложение на множители: "
-               "(%.2f)x^2 + (%.2f)x + %.2f = (%.2f)(x - %.2f)(x - %.2f)\n",
-               a, b, c, a, x1, x2);
+        result->rootCase = ROOTS_TWO;
+        result->count = 2;
+        result->roots[0] = (-b + sqrt(d)) / (2 * a); // первый корень
+        result->roots[1] = (-b - sqrt(d)) / (2 * a); // второй корень
     }
 }
 
-// Функция для решения кубического уравнения и вывода разложения на множители
-void SolveCubic(double a, double b, double c, double d)
+// Приводит кубическое уравнение к виду t^3 + pt + q = 0, где
+// x = t - shift, и возвращает радикал формулы Кардано: его знак
+// определяет случай расположения корней
+static inline double reduceCubic(double a, double b, double c, double d,
+                                 double* shift, double* p, double* q)
 {
-    printf("Коэффициенты кубического уравнения: a = %.2f, b = %.2f, "
-           "c = %.2f, d = %.2f\n", a, b, c, d);
-    // Используем формулу Кардано
-    double p = (3 * a * c - b * b) / (3 * a * a); // Первый коэффициент
-    double q = (2 * b * b * b - 9 * a * b * c + 27 * a * a * d) /
-               (27 * a * a * a); // Второй коэффициент
-    double r = q * q / 4 + p * p * p / 27; // Радикал
+    *shift = b / (3 * a); // Сдвиг от приведённого уравнения
+    *p = (3 * a * c - b * b) / (3 * a * a); // Первый коэффициент
+    *q = (2 * b * b * b - 9 * a * b * c + 27 * a * a * d) /
+         (27 * a * a * a); // Второй коэффициент
+    return *q * *q / 4 + *p * *p * *p / 27;
+}
 
+// Функция для вычисления корней кубического уравнения по формуле Кардано
+void ComputeCubic(double a, double b, double c, double d,
+                  EquationResult* result)
+{
+    // Используем формулу Кардано для приведённого уравнения t^3 + pt + q = 0,
+    // где x = t - b / (3a)
+    double shift, p, q;
+    double r = reduceCubic(a, b, c, d, &shift, &p, &q); // Радикал
+
+    result->degree = 3;
     if (r > 0)
     {
         // Один действительный корень и два комплексных корня
         double s = sqrt(r); // Квадратный корень из радикала
         double u = cbrt(-q / 2 + s); // Первый кубический корень
         double v = cbrt(-q / 2 - s); // Второй кубический корень
-        double x = u + v; // Действительный корень
-        printf("Уравнение имеет один действительный корень: x = %.2f\n", x);
-        printf("Разложение на множители: (%.2f)x^3 + (%.2f)x^2 + (%.2f)x + %.2f = (%.2f)(x - %.2f)\n",
-               a, b, c, d, a, x);
-        printf("Два комплексных корня не выводятся.\n");
+        result->rootCase = ROOTS_ONE_REAL;
+        result->count = 1;
+        result->roots[0] = u + v - shift; // Действительный корень
     }
     else if (r == 0)
     {
         // Три действительных корня, из которых два равны
         double u = cbrt(-q / 2); // Кубический корень
-        double x1 = 2 * u; // Первый корень
-        double x2 = -u; // Второй и третий корень
-        printf("Уравнение имеет три действительных корня: x1 = %.2f, x2 = x3 = %.2f\n",
-               x1, x2);
-        printf("Разложение на множители: (%.2f)x^3 + (%.2f)x^2 + (%.2f)x + %.2f = (%.2f)(x - %.2f)(x - %.2f)^2\n",
-               a, b, c, d, a, x1, x2);
+        result->rootCase = ROOTS_DOUBLE;
+        result->count = 2;
+        result->roots[0] = 2 * u - shift; // Первый корень
+        result->roots[1] = -u - shift; // Второй и третий корень
+    }
+    else
+    {
+        // Три различных действительных корня
+        double m = 2 * sqrt(-p / 3); // Амплитуда
+        double arg = -q / 2 * sqrt(-27 / (p * p * p));
+        // Ошибки округления могут вывести аргумент за пределы [-1, 1]
+        if (arg > 1)
+        {
+            arg = 1;
+        }
+        else if (arg < -1)
+        {
+            arg = -1;
+        }
+        double phi = acos(arg); // Угол
+        result->rootCase = ROOTS_THREE;
+        result->count = 3;
+        result->roots[0] = m * cos(phi / 3) - shift; // Первый корень
+        result->roots[1] = m * cos((phi + 2 * M_PI) / 3) - shift; // Второй
+        result->roots[2] = m * cos((phi + 4 * M_PI) / 3) - shift; // Третий
+    }
+}
+
+// Уточняет корень кубического уравнения методом Галлея. Метод сходится
+// кубически: после шага меньше SEED_CONVERGED погрешность корня ниже
+// точности double. Возвращает 0, если шаг больше SEED_REACH (приближение
+// далеко от корня) или не стал малым за iterations итераций. Шаг Ньютона
+// проверяется отдельно: у точки, где производная равна 0, шаг Галлея
+// тоже мал, хотя корня рядом нет
+static int refineRoot(double a, double b, double c, double d, int iterations,
+                      double* x)
+{
+    double t = *x;
+    for (int i = 0; i < iterations; i++)
+    {
+        double f = ((a * t + b) * t + c) * t + d;
+        if (f == 0)
+        {
+            break;
+        }
+        double f1 = (3 * a * t + 2 * b) * t + c; // первая производная
+        double f2 = 6 * a * t + 2 * b; // вторая производная
+        double step = 2 * f * f1 / (2 * f1 * f1 - f * f2);
+        if (!(fabs(step) <= SEED_REACH * fabs(t)) ||
+            !(fabs(f) <= SEED_REACH * fabs(t) * fabs(f1)))
+        {
+            return 0; // в том числе деление на 0 и NaN
+        }
+        t -= step;
+        if (fabs(step) <= SEED_CONVERGED * fabs(t))
+        {
+            break;
+        }
+        if (i + 1 == iterations)
+        {
+            return 0;
+        }
+    }
+    *x = t;
+    return 1;
+}
+
+// Функция для решения кубического уравнения от корней соседнего уравнения
+int ComputeSeeded(double a, double b, double c, double d,
+                  const EquationResult* seed, EquationResult* result)
+{
+    if (d == 0)
+    {
+        ComputeQuadratic(a, b, c, result);
+        return 0;
+    }
+    double shift, p, q;
+    double r = reduceCubic(a, b, c, d, &shift, &p, &q);
+    RootCase expected = r > 0 ? ROOTS_ONE_REAL
+                              : r < 0 ? ROOTS_THREE : ROOTS_DOUBLE;
+
+    // Кратный корень и смена случая решаются заново по формуле Кардано
+    double roots[3];
+    int warm = seed != NULL && seed->degree == 3 &&
+               seed->rootCase == expected && expected != ROOTS_DOUBLE;
+    if (warm)
+    {
+        roots[0] = seed->roots[0];
+        warm = refineRoot(a, b, c, d, SEED_ITERATIONS, &roots[0]);
+    }
+    if (warm && expected == ROOTS_THREE)
+    {
+        // Третий корень - по теореме Виета (сумма корней равна -b/a),
+        // уточнённый одним шагом: если первые два приближения сошлись
+        // к одному корню, этот шаг не будет малым
+        roots[1] = seed->roots[1];
+        warm = refineRoot(a, b, c, d, SEED_ITERATIONS, &roots[1]);
+        roots[2] = -b / a - roots[0] - roots[1];
+        warm = warm && refineRoot(a, b, c, d, 1, &roots[2]);
+
+        // Слишком близкие корни точнее находит формула
+        double separation = SEED_SEPARATION *
+            (fabs(roots[0]) + fabs(roots[1]) + fabs(roots[2]));
+        warm = warm && fabs(roots[0] - roots[1]) > separation &&
+               fabs(roots[1] - roots[2]) > separation &&
+               fabs(roots[0] - roots[2]) > separation;
+    }
+    if (!warm)
+    {
+        ComputeCubic(a, b, c, d, result);
+        return 0;
+    }
+    result->degree = 3;
+    result->rootCase = expected;
+    result->count = expected == ROOTS_THREE ? 3 : 1;
+    for (int k = 0; k < result->count; k++)
+    {
+        result->roots[k] = roots[k];
+    }
+    return 1;
+}
+
+// Вычисляет коэффициенты точки пути: концы пути воспроизводятся точно
+static void sweepPoint(const double from[4], const double to[4], int index,
+                       int points, double coef[4])
+{
+    double t = points > 1 ? (double) index / (points - 1) : 0;
+    for (int k = 0; k < 4; k++)
+    {
+        coef[k] = (1 - t) * from[k] + t * to[k];
+    }
+}
+
+// Функция для решения уравнений вдоль пути
+int ComputeSweep(const double from[4], const double to[4], int points,
+                 EquationResult* results)
+{
+    int warm = 0;
+    const EquationResult* previous = NULL;
+    for (int i = 0; i < points; i++)
+    {
+        double coef[4];
+        sweepPoint(from, to, i, points, coef);
+        if (coef[0] == 0)
+        {
+            // Уравнение вырождается: следующая точка решается заново
+            results[i] = (EquationResult) {0, ROOTS_NONE, 0, {0, 0, 0}};
+            previous = NULL;
+            continue;
+        }
+        warm += ComputeSeeded(coef[0], coef[1], coef[2], coef[3], previous,
+                              &results[i]);
+        previous = &results[i];
+    }
+    return warm;
+}
+
+// Классы уравнений блока пакета: значения RootCase и неверные уравнения
+#define BATCH_INVALID (ROOTS_THREE + 1)
+#define BATCH_CLASSES (BATCH_INVALID + 1)
+
+// Блок пакета на этапах решения: копии коэффициентов, величины, от
+// которых зависит случай расположения корней, и номера уравнений блока,
+// разложенные по классам
+typedef struct
+{
+    double a[BATCH_BLOCK];
+    double b[BATCH_BLOCK];
+    double c[BATCH_BLOCK];
+    double d[BATCH_BLOCK];
+    double degree[BATCH_BLOCK];       // степень и класс хранятся в double,
+                                      // чтобы этап классификации шёл
+                                      // векторами одной ширины
+    double discriminant[BATCH_BLOCK]; // квадратного уравнения
+    double shift[BATCH_BLOCK];        // приведённого кубического уравнения
+    double p[BATCH_BLOCK];
+    double q[BATCH_BLOCK];
+    double radical[BATCH_BLOCK];
+    double cls[BATCH_BLOCK];
+    uint16_t lanes[BATCH_CLASSES][BATCH_BLOCK];
+    int laneCount[BATCH_CLASSES];
+} BatchBlock;
+
+// Этап 1: копирует уравнения [begin, begin + n) в блок. Недостающие до
+// BATCH_BLOCK места заполняются первым уравнением, чтобы следующий этап
+// шёл по всему блоку циклом постоянной длины
+static void loadBlock(const EquationBatch* batch, size_t begin, size_t n,
+                      BatchBlock* block)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        block->a[i] = batch->a[begin + i];
+        block->b[i] = batch->b[begin + i];
+        block->c[i] = batch->c[begin + i];
+        block->d[i] = batch->d[begin + i];
+        block->degree[i] = batch->degree[begin + i];
+    }
+    for (size_t i = n; i < BATCH_BLOCK; i++)
+    {
+        block->a[i] = block->a[0];
+        block->b[i] = block->b[0];
+        block->c[i] = block->c[0];
+        block->d[i] = block->d[0];
+        block->degree[i] = block->degree[0];
+    }
+}
+
+// Этап 2: дискриминанты и радикалы всех уравнений блока и их классы.
+// Цикл без переходов: обе величины вычисляются для каждого уравнения,
+// а класс выбирается по результатам сравнений, поэтому компилятор
+// выполняет этап векторными командами. Сравнения те же, что в
+// ComputeQuadratic и ComputeCubic, в том числе для NaN
+static void classifyBlock(BatchBlock* block)
+{
+    for (int i = 0; i < BATCH_BLOCK; i++)
+    {
+        double a = block->a[i];
+        double b = block->b[i];
+        double disc = b * b - 4 * a * block->c[i];
+        double r = reduceCubic(a, b, block->c[i], block->d[i],
+                               &block->shift[i], &block->p[i],
+                               &block->q[i]);
+        block->discriminant[i] = disc;
+        block->radical[i] = r;
+        double quadratic = disc < 0 ? ROOTS_NONE
+                                    : disc == 0 ? ROOTS_SINGLE : ROOTS_TWO;
+        double cubic = r > 0 ? ROOTS_ONE_REAL
+                             : r == 0 ? ROOTS_DOUBLE : ROOTS_THREE;
+        block->cls[i] = block->degree[i] == 3 ? cubic
+                        : block->degree[i] == 2 ? quadratic : BATCH_INVALID;
+    }
+}
+
+// Этап 3: раскладывает номера первых n уравнений блока по классам.
+// Номер записывается в конец списка своего класса без сравнений
+static void partitionBlock(BatchBlock* block, size_t n)
+{
+    for (int k = 0; k < BATCH_CLASSES; k++)
+    {
+        block->laneCount[k] = 0;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        int k = (int) block->cls[i];
+        block->lanes[k][block->laneCount[k]++] = (uint16_t) i;
+    }
+}
+
+// Функция для записи результата уравнения блока на его место в пакете
+static inline void storeRoots(EquationBatch* batch, size_t i, int cls,
+                              int count, double x0, double x1, double x2)
+{
+    batch->roots[0][i] = x0;
+    batch->roots[1][i] = x1;
+    batch->roots[2][i] = x2;
+    batch->rootCase[i] = (int8_t) (cls == BATCH_INVALID ? ROOTS_NONE : cls);
+    batch->rootCount[i] = (int8_t) count;
+}
+
+// Этап 4: решает уравнения одного класса. Внутри класса случай
+// расположения корней известен, и формулы вычисляются без ветвлений;
+// результаты записываются на места уравнений в пакете
+static void solveLane(EquationBatch* batch, size_t begin,
+                      const BatchBlock* block, int cls)
+{
+    const uint16_t* lane = block->lanes[cls];
+    int n = block->laneCount[cls];
+    switch (cls)
+    {
+        case ROOTS_NONE:
+            for (int j = 0; j < n; j++)
+            {
+                storeRoots(batch, begin + lane[j], cls, 0, 0, 0, 0);
+            }
+            break;
+        case ROOTS_SINGLE:
+            for (int j = 0; j < n; j++)
+            {
+                int i = lane[j];
+                double x = -block->b[i] / (2 * block->a[i]);
+                storeRoots(batch, begin + i, cls, 1, x, 0, 0);
+            }
+            break;
+        case ROOTS_TWO:
+            for (int j = 0; j < n; j++)
+            {
+                int i = lane[j];
+                double s = sqrt(block->discriminant[i]);
+                double x0 = (-block->b[i] + s) / (2 * block->a[i]);
+                double x1 = (-block->b[i] - s) / (2 * block->a[i]);
+                storeRoots(batch, begin + i, cls, 2, x0, x1, 0);
+            }
+            break;
+        case ROOTS_ONE_REAL:
+            for (int j = 0; j < n; j++)
+            {
+                int i = lane[j];
+                double s = sqrt(block->radical[i]);
+                double u = cbrt(-block->q[i] / 2 + s);
+                double v = cbrt(-block->q[i] / 2 - s);
+                storeRoots(batch, begin + i, cls, 1,
+                           u + v - block->shift[i], 0, 0);
+            }
+            break;
+        case ROOTS_DOUBLE:
+            for (int j = 0; j < n; j++)
+            {
+                int i = lane[j];
+                double u = cbrt(-block->q[i] / 2);
+                storeRoots(batch, begin + i, cls, 2, 2 * u - block->shift[i],
+                           -u - block->shift[i], 0);
+            }
+            break;
+        case ROOTS_THREE:
+            for (int j = 0; j < n; j++)
+            {
+                int i = lane[j];
+                double p = block->p[i];
+                double m = 2 * sqrt(-p / 3);
+                double arg = -block->q[i] / 2 * sqrt(-27 / (p * p * p));
+                arg = arg > 1 ? 1 : arg < -1 ? -1 : arg;
+                double phi = acos(arg);
+                double shift = block->shift[i];
+                storeRoots(batch, begin + i, cls, 3,
+                           m * cos(phi / 3) - shift,
+                           m * cos((phi + 2 * M_PI) / 3) - shift,
+                           m * cos((phi + 4 * M_PI) / 3) - shift);
+            }
+            break;
+        default:
+            for (int j = 0; j < n; j++)
+            {
+                storeRoots(batch, begin + lane[j], cls, -1, 0, 0, 0);
+            }
+            break;
+    }
+}
+
+// Функция для решения части пакета уравнений
+void ComputeBatch(EquationBatch* batch, size_t begin, size_t end)
+{
+    BatchBlock block;
+    for (size_t first = begin; first < end; first += BATCH_BLOCK)
+    {
+        size_t n = end - first < BATCH_BLOCK ? end - first : BATCH_BLOCK;
+        loadBlock(batch, first, n, &block);
+        classifyBlock(&block);
+        partitionBlock(&block, n);
+        for (int cls = 0; cls < BATCH_CLASSES; cls++)
+        {
+            solveLane(batch, first, &block, cls);
+        }
+    }
+}
+
+// Действительный корень приведённого уравнения при положительном
+// радикале. Слагаемое u выбирается так, чтобы под кубическим корнем не
+// вычитались близкие числа, второе находится из uv = -p / 3 без второго
+// кубического корня, а сумма u + v = -q / (u^2 - uv + v^2) вычисляется
+// без вычитания: знаменатель не меньше (u^2 + v^2) / 2
+static inline double fastOneReal(double p, double q, double r)
+{
+    double u = fastCbrt(-q / 2 + copysign(sqrt(r), -q));
+    double v = -p / (3 * u);
+    return -q / (u * u + p / 3 + v * v);
+}
+
+// Амплитуда и треть угла тригонометрической формулы трёх различных
+// корней приведённого уравнения
+static inline void fastThreeAngle(double p, double q, double* m,
+                                  double* theta)
+{
+    double t = sqrt(-p / 3);
+    double arg = -q / 2 / (t * t * t);
+    arg = arg > 1 ? 1 : arg < -1 ? -1 : arg;
+    *m = 2 * t;
+    *theta = fastAcos(arg) / 3;
+}
+
+// Три различных корня приведённого уравнения: все три вычисляются по
+// косинусу и синусу трети угла,
+// cos(theta + 2pi/3) = -cos(theta) / 2 - sqrt(3) / 2 sin(theta) и
+// cos(theta + 4pi/3) = -cos(theta) / 2 + sqrt(3) / 2 sin(theta)
+static inline void fastThreeRoots(double m, double theta, double* x0,
+                                  double* x1, double* x2)
+{
+    double c, s;
+    fastCosSin(theta, &c, &s);
+    *x0 = m * c;
+    *x1 = m * (-c / 2 - FAST_SQRT3_2 * s);
+    *x2 = m * (-c / 2 + FAST_SQRT3_2 * s);
+}
+
+// Функция для вычисления корней кубического уравнения по приближённым
+// функциям
+void ComputeCubicFast(double a, double b, double c, double d,
+                      EquationResult* result)
+{
+    double shift, p, q;
+    double r = reduceCubic(a, b, c, d, &shift, &p, &q); // Радикал
+
+    result->degree = 3;
+    if (r > 0)
+    {
+        result->rootCase = ROOTS_ONE_REAL;
+        result->count = 1;
+        result->roots[0] = fastOneReal(p, q, r) - shift;
+    }
+    else if (r == 0)
+    {
+        double u = fastCbrt(-q / 2);
+        result->rootCase = ROOTS_DOUBLE;
+        result->count = 2;
+        result->roots[0] = 2 * u - shift;
+        result->roots[1] = -u - shift;
+    }
+    else
+    {
+        double m, theta, x0, x1, x2;
+        fastThreeAngle(p, q, &m, &theta);
+        fastThreeRoots(m, theta, &x0, &x1, &x2);
+        result->rootCase = ROOTS_THREE;
+        result->count = 3;
+        result->roots[0] = x0 - shift;
+        result->roots[1] = x1 - shift;
+        result->roots[2] = x2 - shift;
+    }
+}
+
+// Функции для вычисления корней группы уравнений одного класса циклом
+// постоянной длины без переходов: компилятор выполняет его векторными
+// командами
+static void fastGroupOneReal(const double* restrict p,
+                             const double* restrict q,
+                             const double* restrict r, double* restrict x)
+{
+    for (int j = 0; j < FAST_GROUP; j++)
+    {
+        x[j] = fastOneReal(p[j], q[j], r[j]);
+    }
+}
+
+static void fastGroupDouble(const double* restrict q, double* restrict x)
+{
+    for (int j = 0; j < FAST_GROUP; j++)
+    {
+        x[j] = fastCbrt(-q[j] / 2);
+    }
+}
+
+static void fastGroupThree(const double* restrict p, const double* restrict q,
+                           double* restrict x0, double* restrict x1,
+                           double* restrict x2)
+{
+    for (int j = 0; j < FAST_GROUP; j++)
+    {
+        double m, theta;
+        fastThreeAngle(p[j], q[j], &m, &theta);
+        fastThreeRoots(m, theta, &x0[j], &x1[j], &x2[j]);
+    }
+}
+
+// Этап 4 быстрого решателя для кубического класса: уравнения класса
+// собираются группами по FAST_GROUP в плотные массивы (недостающие места
+// группы - копии её первого уравнения), корни группы вычисляются
+// векторными командами и записываются на места уравнений в пакете
+static void solveLaneFast(EquationBatch* batch, size_t begin,
+                          const BatchBlock* block, int cls)
+{
+    const uint16_t* lane = block->lanes[cls];
+    int n = block->laneCount[cls];
+    double p[FAST_GROUP];
+    double q[FAST_GROUP];
+    double r[FAST_GROUP];
+    double x[3][FAST_GROUP];
+    for (int first = 0; first < n; first += FAST_GROUP)
+    {
+        int count = n - first < FAST_GROUP ? n - first : FAST_GROUP;
+        for (int j = 0; j < FAST_GROUP; j++)
+        {
+            int i = lane[first + (j < count ? j : 0)];
+            p[j] = block->p[i];
+            q[j] = block->q[i];
+            r[j] = block->radical[i];
+        }
+        if (cls == ROOTS_ONE_REAL)
+        {
+            fastGroupOneReal(p, q, r, x[0]);
+        }
+        else if (cls == ROOTS_DOUBLE)
+        {
+            fastGroupDouble(q, x[0]);
+        }
+        else
+        {
+            fastGroupThree(p, q, x[0], x[1], x[2]);
+        }
+        for (int j = 0; j < count; j++)
+        {
+            int i = lane[first + j];
+            double shift = block->shift[i];
+            if (cls == ROOTS_ONE_REAL)
+            {
+                storeRoots(batch, begin + i, cls, 1, x[0][j] - shift, 0, 0);
+            }
+            else if (cls == ROOTS_DOUBLE)
+            {
+                storeRoots(batch, begin + i, cls, 2, 2 * x[0][j] - shift,
+                           -x[0][j] - shift, 0);
+            }
+            else
+            {
+                storeRoots(batch, begin + i, cls, 3, x[0][j] - shift,
+                           x[1][j] - shift, x[2][j] - shift);
+            }
+        }
+    }
+}
+
+// Функция для быстрого решения части пакета уравнений
+void ComputeBatchFast(EquationBatch* batch, size_t begin, size_t end)
+{
+    BatchBlock block;
+    for (size_t first = begin; first < end; first += BATCH_BLOCK)
+    {
+        size_t n = end - first < BATCH_BLOCK ? end - first : BATCH_BLOCK;
+        loadBlock(batch, first, n, &block);
+        classifyBlock(&block);
+        partitionBlock(&block, n);
+        solveLane(batch, first, &block, ROOTS_NONE);
+        solveLane(batch, first, &block, ROOTS_SINGLE);
+        solveLane(batch, first, &block, ROOTS_TWO);
+        solveLaneFast(batch, first, &block, ROOTS_ONE_REAL);
+        solveLaneFast(batch, first, &block, ROOTS_DOUBLE);
+        solveLaneFast(batch, first, &block, ROOTS_THREE);
+        solveLane(batch, first, &block, BATCH_INVALID);
+    }
+}
+
+// Функция для вычисления произведения и его ошибки округления:
+// a * b = *product + *error точно
+static inline void twoProduct(double a, double b, double* product,
+                              double* error)
+{
+    *product = a * b;
+#ifdef FP_FAST_FMA
+    *error = fma(a, b, -*product);
+#else
+    // Без аппаратного fma - разбиение Вельткампа и произведение Деккера
+    double t = EVAL_SPLIT * a;
+    double aHigh = t - (t - a);
+    double aLow = a - aHigh;
+    t = EVAL_SPLIT * b;
+    double bHigh = t - (t - b);
+    double bLow = b - bHigh;
+    *error = aLow * bLow - (((*product - aHigh * bHigh) - aLow * bHigh) -
+                            aHigh * bLow);
+#endif
+}
+
+// Функция для вычисления суммы и её ошибки округления (алгоритм Кнута):
+// a + b = *sum + *error точно
+static inline void twoSum(double a, double b, double* sum, double* error)
+{
+    *sum = a + b;
+    double z = *sum - a;
+    *error = (a - (*sum - z)) + (b - z);
+}
+
+// Функция для одного шага компенсированной схемы Горнера: ошибки
+// округления произведения и суммы собираются отдельной схемой Горнера
+static inline void compensatedStep(double* p, double* error, double x,
+                                   double coefficient)
+{
+    double product, productError, sumError;
+    twoProduct(*p, x, &product, &productError);
+    twoSum(product, coefficient, p, &sumError);
+    *error = *error * x + (productError + sumError);
+}
+
+// Функция для вычисления значения кубического многочлена компенсированной
+// схемой Горнера: ошибки всех шагов добавляются к значению в конце
+static inline double compensatedHorner(const double c[4], double x)
+{
+    double p = c[0];
+    double error = 0;
+    compensatedStep(&p, &error, x, c[1]);
+    compensatedStep(&p, &error, x, c[2]);
+    compensatedStep(&p, &error, x, c[3]);
+    return p + error;
+}
+
+// Функции для вычисления значений и производных в groups группах по
+// EVAL_LANES точек, по одной на режим. Многочлен дополнен старшими нулями
+// до кубического, поэтому шаги схемы Горнера записаны без цикла по
+// коэффициентам. Циклы по точкам группы имеют постоянную длину и не
+// ветвятся, и компилятор выполняет их векторными командами
+static void evaluatePlain(const double* c, size_t groups,
+                          const double* restrict x, int derivatives,
+                          double* restrict values, double* restrict first,
+                          double* restrict second)
+{
+    for (size_t g = 0; g < groups; g++, x += EVAL_LANES)
+    {
+        for (int l = 0; l < EVAL_LANES; l++)
+        {
+            values[l] = ((c[0] * x[l] + c[1]) * x[l] + c[2]) * x[l] + c[3];
+        }
+        values += EVAL_LANES;
+        if (derivatives > 0)
+        {
+            for (int l = 0; l < EVAL_LANES; l++)
+            {
+                first[l] = (3 * c[0] * x[l] + 2 * c[1]) * x[l] + c[2];
+            }
+            first += EVAL_LANES;
+        }
+        if (derivatives > 1)
+        {
+            for (int l = 0; l < EVAL_LANES; l++)
+            {
+                second[l] = 6 * c[0] * x[l] + 2 * c[1];
+            }
+            second += EVAL_LANES;
+        }
+    }
+}
+
+static void evaluateFused(const double* c, size_t groups,
+                          const double* restrict x, int derivatives,
+                          double* restrict values, double* restrict first,
+                          double* restrict second)
+{
+    for (size_t g = 0; g < groups; g++, x += EVAL_LANES)
+    {
+        for (int l = 0; l < EVAL_LANES; l++)
+        {
+            values[l] = fma(fma(fma(c[0], x[l], c[1]), x[l], c[2]), x[l],
+                            c[3]);
+        }
+        values += EVAL_LANES;
+        if (derivatives > 0)
+        {
+            for (int l = 0; l < EVAL_LANES; l++)
+            {
+                first[l] = fma(fma(3 * c[0], x[l], 2 * c[1]), x[l], c[2]);
+            }
+            first += EVAL_LANES;
+        }
+        if (derivatives > 1)
+        {
+            for (int l = 0; l < EVAL_LANES; l++)
+            {
+                second[l] = fma(6 * c[0], x[l], 2 * c[1]);
+            }
+            second += EVAL_LANES;
+        }
+    }
+}
+
+// Компенсированная схема: производные вычисляются обычной схемой
+static void evaluateCompensated(const double* c, size_t groups,
+                                const double* restrict x, int derivatives,
+                                double* restrict values,
+                                double* restrict first,
+                                double* restrict second)
+{
+    // Копия коэффициентов не может совпасть с массивами результатов, и
+    // компилятору не нужно это проверять
+    const double local[4] = {c[0], c[1], c[2], c[3]};
+    for (size_t g = 0; g < groups; g++, x += EVAL_LANES)
+    {
+        for (int l = 0; l < EVAL_LANES; l++)
+        {
+            values[l] = compensatedHorner(local, x[l]);
+        }
+        values += EVAL_LANES;
+        if (derivatives > 0)
+        {
+            for (int l = 0; l < EVAL_LANES; l++)
+            {
+                first[l] = (3 * c[0] * x[l] + 2 * c[1]) * x[l] + c[2];
+            }
+            first += EVAL_LANES;
+        }
+        if (derivatives > 1)
+        {
+            for (int l = 0; l < EVAL_LANES; l++)
+            {
+                second[l] = 6 * c[0] * x[l] + 2 * c[1];
+            }
+            second += EVAL_LANES;
+        }
+    }
+}
+
+// Функция для вычисления групп точек в выбранном режиме
+static void evaluateGroups(const double* c, size_t groups, const double* x,
+                           unsigned flags, int derivatives, double* values,
+                           double* first, double* second)
+{
+    if (flags & EVAL_COMPENSATED)
+    {
+        evaluateCompensated(c, groups, x, derivatives, values, first,
+                            second);
+    }
+    else if (flags & EVAL_FMA)
+    {
+        evaluateFused(c, groups, x, derivatives, values, first, second);
+    }
+    else
+    {
+        evaluatePlain(c, groups, x, derivatives, values, first, second);
+    }
+}
+
+// Функция для вычисления значений многочлена и производных во многих
+// точках
+void EvaluatePolynomial(const double* coef, int degree, const double* x,
+                        size_t count, unsigned flags, double* values,
+                        double* first, double* second)
+{
+    // Многочлен меньшей степени - кубический со старшими нулями
+    double c[4] = {0, 0, 0, 0};
+    for (int k = 0; k <= degree; k++)
+    {
+        c[3 - degree + k] = coef[k];
+    }
+    int derivatives = first == NULL ? 0 : second == NULL ? 1 : 2;
+    size_t groups = count / EVAL_LANES;
+    evaluateGroups(c, groups, x, flags, derivatives, values, first, second);
+
+    // Последняя неполная группа считается в дополненных нулями массивах
+    size_t whole = groups * EVAL_LANES;
+    size_t rest = count - whole;
+    if (rest > 0)
+    {
+        double tail[4][EVAL_LANES];
+        for (size_t l = 0; l < EVAL_LANES; l++)
+        {
+            tail[0][l] = l < rest ? x[whole + l] : 0;
+        }
+        evaluateGroups(c, 1, tail[0], flags, derivatives, tail[1], tail[2],
+                       tail[3]);
+        for (size_t l = 0; l < rest; l++)
+        {
+            values[whole + l] = tail[1][l];
+            if (derivatives > 0)
+            {
+                first[whole + l] = tail[2][l];
+            }
+            if (derivatives > 1)
+            {
+                second[whole + l] = tail[3][l];
+            }
+        }
+    }
+}
+
+// Решает уравнение степени degree в long double по тем же формулам, что
+// ComputeQuadratic и ComputeCubic. Меньший корень квадратного уравнения
+// находится через произведение корней, а второй кубический корень формулы
+// Кардано - через произведение uv = -p/3: оба без вычитания близких чисел
+static void solveExtended(int degree, double a, double b, double c, double d,
+                          EquationResult* result)
+{
+    long double la = a, lb = b, lc = c, ld = d;
+    if (degree == 2)
+    {
+        long double disc = lb * lb - 4 * la * lc;
+        result->degree = 2;
+        if (disc < 0)
+        {
+            result->rootCase = ROOTS_NONE;
+            result->count = 0;
+            return;
+        }
+        if (disc == 0)
+        {
+            result->rootCase = ROOTS_SINGLE;
+            result->count = 1;
+            result->roots[0] = (double) (-lb / (2 * la));
+            return;
+        }
+        long double s = sqrtl(disc);
+        long double t = lb >= 0 ? -lb - s : -lb + s; // без сокращения
+        result->rootCase = ROOTS_TWO;
+        result->count = 2;
+        result->roots[lb >= 0] = (double) (t / (2 * la));
+        result->roots[lb < 0] = (double) (2 * lc / t) + 0.0; // без -0
+        return;
+    }
+
+    long double shift = lb / (3 * la);
+    long double p = (3 * la * lc - lb * lb) / (3 * la * la);
+    long double q = (2 * lb * lb * lb - 9 * la * lb * lc + 27 * la * la * ld) /
+                    (27 * la * la * la);
+    long double r = q * q / 4 + p * p * p / 27;
+    result->degree = 3;
+    if (r > 0)
+    {
+        long double s = sqrtl(r);
+        long double u = cbrtl(q >= 0 ? -q / 2 - s : -q / 2 + s); // u != 0
+        long double v = -p / (3 * u);
+        result->rootCase = ROOTS_ONE_REAL;
+        result->count = 1;
+        result->roots[0] = (double) (u + v - shift);
+    }
+    else if (r == 0)
+    {
+        long double u = cbrtl(-q / 2);
+        result->rootCase = ROOTS_DOUBLE;
+        result->count = 2;
+        result->roots[0] = (double) (2 * u - shift);
+        result->roots[1] = (double) (-u - shift);
+    }
+    else
+    {
+        long double m = 2 * sqrtl(-p / 3);
+        long double arg = -q / 2 * sqrtl(-27 / (p * p * p));
+        arg = arg > 1 ? 1 : arg < -1 ? -1 : arg;
+        long double phi = acosl(arg);
+        long double pi = 3.141592653589793238462643383279502884L;
+        result->rootCase = ROOTS_THREE;
+        result->count = 3;
+        result->roots[0] = (double) (m * cosl(phi / 3) - shift);
+        result->roots[1] = (double) (m * cosl((phi + 2 * pi) / 3) - shift);
+        result->roots[2] = (double) (m * cosl((phi + 4 * pi) / 3) - shift);
+    }
+}
+
+// Выбирает точку деления отрезка [lo, hi]: 0, если отрезок его содержит,
+// середину, если концы одного порядка, иначе среднее геометрическое
+// концов, чтобы корень, намного меньший длины отрезка, находился за
+// десятки шагов
+static double splitInterval(double lo, double hi)
+{
+    if (lo < 0 && hi > 0)
+    {
+        return 0;
+    }
+    double small = lo >= 0 ? lo : -hi;
+    double large = lo >= 0 ? hi : -lo;
+    if (large <= 4 * small)
+    {
+        return lo / 2 + hi / 2;
+    }
+    small = small > DBL_MIN ? small : DBL_MIN;
+    double middle = sqrt(small) * sqrt(large);
+    return lo >= 0 ? middle : -middle;
+}
+
+// Вычисляет значение кубического многочлена компенсированной схемой
+// Горнера. Если слагаемые или их ошибки округления могут выйти за
+// пределы нормализованных чисел, значение умножается на степень двойки,
+// при которой наибольшее слагаемое порядка 1. В size записывается сумма
+// модулей слагаемых с тем же множителем, в step - поправка Ньютона
+// f(x)/f'(x)
+static double scaledHorner(const double coef[4], double x, double* size,
+                           double* step)
+{
+    *size = ((fabs(coef[0]) * fabs(x) + fabs(coef[1])) * fabs(x) +
+             fabs(coef[2])) * fabs(x) + fabs(coef[3]);
+    if ((x == 0 || (fabs(x) <= ADAPTIVE_SAFE_X &&
+                    fabs(x) >= 1 / ADAPTIVE_SAFE_X)) &&
+        *size <= ADAPTIVE_SAFE_SIZE && *size >= 1 / ADAPTIVE_SAFE_SIZE)
+    {
+        double value = compensatedHorner(coef, x);
+        *step = value / ((3 * coef[0] * x + 2 * coef[1]) * x + coef[2]);
+        return value;
+    }
+    int e = x != 0 ? ilogb(x) : 0;
+    double m = scalbn(x, -e);
+    int top = INT_MIN;
+    for (int i = 0; i < 4; i++)
+    {
+        int order = coef[i] != 0 ? ilogb(coef[i]) + (3 - i) * e : INT_MIN;
+        top = order > top ? order : top;
+    }
+    if (top == INT_MIN)
+    {
+        *size = 0;
+        *step = 0;
+        return 0; // нулевой многочлен
+    }
+    double scaled[4];
+    for (int i = 0; i < 4; i++)
+    {
+        scaled[i] = scalbn(coef[i], (3 - i) * e - top);
+    }
+    double value = compensatedHorner(scaled, m);
+    *size = ((fabs(scaled[0]) * fabs(m) + fabs(scaled[1])) * fabs(m) +
+             fabs(scaled[2])) * fabs(m) + fabs(scaled[3]);
+    double slope = (3 * scaled[0] * m + 2 * scaled[1]) * m + scaled[2];
+    *step = scalbn(value / slope, e);
+    return value;
+}
+
+// Находит корень кубического многочлена на отрезке [lo, hi], на котором
+// многочлен монотонен (rising - возрастает) и меняет знак. Шаги Ньютона
+// начинаются с guess, невязка вычисляется scaledHorner, поэтому её знак
+// верен и у почти кратного корня. Шаг,
+// выходящий за отрезок или уменьшающийся меньше чем вчетверо,
+// заменяется делением отрезка splitInterval
+static double bracketRoot(const double coef[4], double lo, double hi,
+                          int rising, double guess)
+{
+    double x = guess > lo && guess < hi ? guess : splitInterval(lo, hi);
+    double previous = INFINITY;
+    for (int i = 0; i < ADAPTIVE_ROOT_STEPS; i++)
+    {
+        double size, step;
+        double value = scaledHorner(coef, x, &size, &step);
+        if (value == 0)
+        {
+            break;
+        }
+        if ((value < 0) == rising)
+        {
+            lo = x;
+        }
+        else
+        {
+            hi = x;
+        }
+        double next = x - step;
+        if (next == x)
+        {
+            break; // поправка меньше половины единицы последнего разряда
+        }
+        if (!(next > lo && next < hi) ||
+            !(fabs(next - x) <= previous / 4))
+        {
+            next = splitInterval(lo, hi);
+        }
+        if (!(next > lo && next < hi))
+        {
+            break; // между lo и hi нет других чисел double
+        }
+        previous = fabs(next - x);
+        x = next;
+    }
+    return x;
+}
+
+// Выбирает начальное приближение для bracketRoot: корень решения
+// в double, лежащий на отрезке (lo, hi), или NaN
+static double pickGuess(const EquationResult* result, double lo, double hi)
+{
+    for (int k = 0; k < result->count; k++)
+    {
+        if (result->roots[k] > lo && result->roots[k] < hi)
+        {
+            return result->roots[k];
+        }
+    }
+    return NAN;
+}
+
+// Вычисляет знак многочлена в точке x (-1, 0 или 1). 0 означает, что
+// значение не больше того, что дают округление точного кратного корня
+// до double и ошибка компенсированной схемы Горнера: порядка
+// DBL_EPSILON^2 от суммы модулей слагаемых
+static int criticalSign(const double coef[4], double x)
+{
+    double size, step;
+    double value = scaledHorner(coef, x, &size, &step);
+    if (fabs(value) <= ADAPTIVE_DOUBLE_MARGIN * DBL_EPSILON * DBL_EPSILON *
+                       size)
+    {
+        return 0;
+    }
+    return value > 0 ? 1 : -1;
+}
+
+// Решает заново уравнение, решение которого в double не прошло проверку.
+// Квадратное уравнение решается в long double. У кубического формулы
+// Кардано и тригонометрическая и в long double теряют точность и даже
+// случай расположения корней, если корни почти кратные или сдвиг
+// b/(3a) велик по сравнению с ними. Поэтому случай определяется знаками
+// многочлена в точках, где производная равна 0 (criticalSign), а каждый
+// корень находится bracketRoot на своём отрезке монотонности; решение
+// в double, не прошедшее проверку, служит начальным приближением.
+// Порядок корней тот же, что у ComputeCubic
+static void escalateSolution(int degree, double a, double b, double c,
+                             double d, EquationResult* result)
+{
+    if (degree != 3)
+    {
+        solveExtended(degree, a, b, c, d, result);
+        return;
+    }
+    EquationResult guess = *result;
+    const double coef[4] = {a, b, c, d};
+
+    // Все корни по модулю меньше границы Фудзивары
+    double limit = 2 * fmax(fmax(fabs(b / a), sqrt(fabs(c / a))),
+                            cbrt(fabs(d / (2 * a))));
+    limit = fmin(2 * limit, DBL_MAX);
+
+    // Точки, где производная 3ax^2 + 2bx + c равна 0
+    long double a3 = 3 * (long double) a;
+    long double disc = (long double) b * b - a3 * c;
+    int rising = a > 0;
+    if (!(disc >= 0))
+    {
+        result->rootCase = ROOTS_ONE_REAL;
+        result->count = 1;
+        result->roots[0] = bracketRoot(coef, -limit, limit, rising,
+                                       pickGuess(&guess, -limit, limit));
+        return;
+    }
+    long double t = b >= 0 ? -b - sqrtl(disc) : -b + sqrtl(disc);
+    double x1 = (double) (t / a3);
+    double x2 = t != 0 ? (double) (c / t) : x1;
+    double low = x1 < x2 ? x1 : x2;
+    double high = x1 < x2 ? x2 : x1;
+    int lowSign = criticalSign(coef, low);
+    int highSign = criticalSign(coef, high);
+
+    if (lowSign == 0 || highSign == 0)
+    {
+        // Простой корень лежит по другую сторону от второй точки, а если
+        // точки совпадают, корень тройной
+        int first = lowSign == 0;
+        double twice = first ? low : high;
+        result->rootCase = ROOTS_DOUBLE;
+        result->count = 2;
+        result->roots[0] =
+            low == high ? twice
+            : first ? bracketRoot(coef, high, limit, rising,
+                                  pickGuess(&guess, high, limit))
+                    : bracketRoot(coef, -limit, low, rising,
+                                  pickGuess(&guess, -limit, low));
+        result->roots[1] = twice;
+    }
+    else if (lowSign != highSign)
+    {
+        // Наибольший, наименьший, средний
+        result->rootCase = ROOTS_THREE;
+        result->count = 3;
+        result->roots[0] = bracketRoot(coef, high, limit, rising,
+                                       pickGuess(&guess, high, limit));
+        result->roots[1] = bracketRoot(coef, -limit, low, rising,
+                                       pickGuess(&guess, -limit, low));
+        result->roots[2] = bracketRoot(coef, low, high, !rising,
+                                       pickGuess(&guess, low, high));
+    }
+    else
+    {
+        // Корень слева от точек, если многочлен в них уже прошёл через 0
+        result->rootCase = ROOTS_ONE_REAL;
+        result->count = 1;
+        result->roots[0] =
+            (lowSign > 0) == rising
+                ? bracketRoot(coef, -limit, low, rising,
+                              pickGuess(&guess, -limit, low))
+                : bracketRoot(coef, high, limit, rising,
+                              pickGuess(&guess, high, limit));
+    }
+}
+
+// Функция для решения уравнения в long double
+void ComputeExtended(double a, double b, double c, double d,
+                     EquationResult* result)
+{
+    solveExtended(d == 0 ? 2 : 3, a, b, c, d, result);
+}
+
+// Проверяет решение, найденное в double. Возвращает 1, если знак
+// дискриминанта (радикала) по модулю не больше его возможной ошибки
+// округления, то есть случай расположения корней мог быть определён
+// неверно, или хотя бы один корень найден с относительной ошибкой больше
+// ADAPTIVE_TOLERANCE. Для корня квадратного уравнения ошибка оценивается
+// по обусловленности числителя -b ± sqrt(D): она велика при сокращении и
+// при малом D. Для корня кубического - поправкой Ньютона по невязке,
+// вычисленной компенсированной схемой Горнера (в том числе у кратного
+// корня, где производная близка к 0)
+static int needsEscalation(double a, double b, double c, double d,
+                           const EquationResult* result)
+{
+    if (result->degree == 2)
+    {
+        double scale = b * b + fabs(4 * a * c); // порядок ошибки D
+        double disc = b * b - 4 * a * c;
+        if (fabs(disc) <= ADAPTIVE_CASE_MARGIN * DBL_EPSILON * scale)
+        {
+            return 1;
+        }
+        // При c = 0 корни 0 и -b/a вычисляются без ошибки сокращения
+        if (result->count < 2 || c == 0)
+        {
+            return 0;
+        }
+        // sqrt(D) = |a (x1 - x2)|; ошибка числителя - от ошибок b,
+        // sqrt(D) и самого D
+        double root = fabs(a * (result->roots[0] - result->roots[1]));
+        double error = ADAPTIVE_CASE_MARGIN * DBL_EPSILON *
+                       (fabs(b) + root + scale / (2 * root));
+        for (int k = 0; k < 2; k++)
+        {
+            double numerator = fabs(2 * a * result->roots[k]);
+            if (!(error <= ADAPTIVE_TOLERANCE * numerator))
+            {
+                return 1; // в том числе NaN и бесконечности
+            }
+        }
+        return 0;
+    }
+
+    // Оценка ошибки радикала: ошибки p и q пропорциональны суммам
+    // модулей слагаемых их числителей
+    double shift, p, q;
+    double r = reduceCubic(a, b, c, d, &shift, &p, &q);
+    double pSum = fabs(3 * a * c) + b * b;
+    double qSum = fabs(2 * b * b * b) + fabs(9 * a * b * c) +
+                  fabs(27 * a * a * d);
+    // Оценка не учитывает потерю точности в числах меньше DBL_MIN
+    // (например, при очень малом a знаменатель q не нормализован)
+    if (fabs(27 * a * a * a) < DBL_MIN || (pSum > 0 && pSum < DBL_MIN) ||
+        (qSum > 0 && qSum < DBL_MIN))
+    {
+        return 1;
+    }
+    double pError = pSum / (3 * a * a);
+    double qError = qSum / fabs(27 * a * a * a);
+    if (fabs(r) <= ADAPTIVE_CASE_MARGIN * DBL_EPSILON *
+                   (fabs(q) * qError / 2 + p * p * pError / 9))
+    {
+        return 1;
+    }
+    double coef[4] = {a, b, c, d};
+    for (int k = 0; k < result->count; k++)
+    {
+        double x = result->roots[k];
+        double value = compensatedHorner(coef, x);
+        double slope = (3 * a * x + 2 * b) * x + c;
+        if (!(fabs(value) <= ADAPTIVE_TOLERANCE * fabs(x * slope)))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Функция для решения уравнения в double с повышением точности
+int ComputeAdaptive(double a, double b, double c, double d,
+                    EquationResult* result)
+{
+    if (d == 0)
+    {
+        ComputeQuadratic(a, b, c, result);
+    }
+    else
+    {
+        ComputeCubic(a, b, c, d, result);
+    }
+    if (!needsEscalation(a, b, c, d, result))
+    {
+        return 0;
+    }
+    escalateSolution(d == 0 ? 2 : 3, a, b, c, d, result);
+    return 1;
+}
+
+// Функция для решения части пакета с повышением точности
+size_t ComputeBatchAdaptive(EquationBatch* batch, size_t begin, size_t end)
+{
+    ComputeBatch(batch, begin, end);
+    size_t escalated = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (batch->rootCount[i] < 0)
+        {
+            continue;
+        }
+        double d = batch->degree[i] == 3 ? batch->d[i] : 0;
+        EquationResult result = {batch->degree[i],
+                                 (RootCase) batch->rootCase[i],
+                                 batch->rootCount[i],
+                                 {batch->roots[0][i], batch->roots[1][i],
+                                  batch->roots[2][i]}};
+        if (!needsEscalation(batch->a[i], batch->b[i], batch->c[i], d,
+                             &result))
+        {
+            continue;
+        }
+        // Степень берётся из пакета: кубическое уравнение с d = 0 остаётся
+        // кубическим
+        escalateSolution(batch->degree[i], batch->a[i], batch->b[i],
+                         batch->c[i], d, &result);
+        for (int k = 0; k < 3; k++)
+        {
+            batch->roots[k][i] = k < result.count ? result.roots[k] : 0;
+        }
+        batch->rootCase[i] = (int8_t) result.rootCase;
+        batch->rootCount[i] = (int8_t) result.count;
+        escalated++;
+    }
+    return escalated;
+}
+
+/*
+ * Интервальная арифметика. Каждая операция выполняется в режиме округления
+ * к ближайшему, после чего границы сдвигаются на одно представимое число
+ * наружу. Ошибка округления к ближайшему не превосходит половины единицы
+ * последнего разряда, поэтому такой сдвиг даёт строгое включение точного
+ * результата и не зависит от того, сохранит ли компилятор режим округления
+ * FPU между операциями.
+ */
+
+// Округление вниз
+static double roundDown(double x)
+{
+    return nextafter(x, -INFINITY);
+}
+
+// Округление вверх
+static double roundUp(double x)
+{
+    return nextafter(x, INFINITY);
+}
+
+// Точечный интервал
+static Interval point(double x)
+{
+    Interval r = {x, x};
+    return r;
+}
+
+// Сложение интервалов
+static Interval iadd(Interval x, Interval y)
+{
+    Interval r = {roundDown(x.lo + y.lo), roundUp(x.hi + y.hi)};
+    return r;
+}
+
+// Вычитание интервалов
+static Interval isub(Interval x, Interval y)
+{
+    Interval r = {roundDown(x.lo - y.hi), roundUp(x.hi - y.lo)};
+    return r;
+}
+
+// Умножение интервалов
+static Interval imul(Interval x, Interval y)
+{
+    double p[4] = {x.lo * y.lo, x.lo * y.hi, x.hi * y.lo, x.hi * y.hi};
+    double lo = p[0];
+    double hi = p[0];
+    for (int i = 1; i < 4; i++)
+    {
+        lo = fmin(lo, p[i]);
+        hi = fmax(hi, p[i]);
+    }
+    Interval r = {roundDown(lo), roundUp(hi)};
+    return r;
+}
+
+// Значение многочлена и его производной на интервале (схема Горнера)
+static void ihorner(const double* coef, int degree, Interval x,
+                    Interval* value, Interval* deriv)
+{
+    Interval p = point(coef[0]);
+    Interval dp = point(0);
+    for (int i = 1; i <= degree; i++)
+    {
+        dp = iadd(imul(dp, x), p);
+        p = iadd(imul(p, x), point(coef[i]));
+    }
+    *value = p;
+    *deriv = dp;
+}
+
+// Значение многочлена и его производной в точке (без гарантий)
+static void horner(const double* coef, int degree, double x,
+                   double* value, double* deriv)
+{
+    double p = coef[0];
+    double dp = 0;
+    for (int i = 1; i <= degree; i++)
+    {
+        dp = dp * x + p;
+        p = p * x + coef[i];
+    }
+    *value = p;
+    *deriv = dp;
+}
+
+// Оператор Кравчика K(X) = m - y f(m) + (1 - y f'(X)) (X - m)
+static Interval krawczykStep(const double* coef, int degree, Interval x)
+{
+    double m = x.lo + (x.hi - x.lo) / 2; // Середина интервала
+    double fm;
+    double dfm;
+    horner(coef, degree, m, &fm, &dfm);
+    double y = 1 / dfm; // Приближённая обратная производная
+
+    Interval value;
+    Interval unused;
+    Interval slope;
+    Interval deriv;
+    ihorner(coef, degree, point(m), &value, &unused);
+    ihorner(coef, degree, x, &unused, &deriv);
+
+    slope = isub(point(1), imul(point(y), deriv));
+    return iadd(isub(point(m), imul(point(y), value)),
+                imul(slope, isub(x, point(m))));
+}
+
+// Уточняет оценку корня и строит интервал, в котором он доказан
+static int certifyRoot(const double* coef, int degree, double estimate,
+                       Interval* root)
+{
+    double x = estimate;
+    double fx;
+    double dfx;
+
+    // Несколько шагов Ньютона в обычной арифметике улучшают середину
+    for (int i = 0; i < 3; i++)
+    {
+        horner(coef, degree, x, &fx, &dfx);
+        if (dfx == 0 || !isfinite(fx / dfx))
+        {
+            break;
+        }
+        x -= fx / dfx;
+    }
+    horner(coef, degree, x, &fx, &dfx);
+
+    // Начальный радиус: поправка Ньютона с запасом плюс несколько ulp
+    double radius = 4 * fabs(x) * DBL_EPSILON + DBL_MIN;
+    if (dfx != 0 && isfinite(fx / dfx))
+    {
+        radius += 2 * fabs(fx / dfx);
+    }
+
+    // Расширяем интервал, пока оператор Кравчика не отобразит его внутрь
+    for (int attempt = 0; attempt < 8; attempt++, radius *= 16)
+    {
+        Interval xi = {roundDown(x - radius), roundUp(x + radius)};
+        Interval k = krawczykStep(coef, degree, xi);
+        if (!(k.lo > xi.lo && k.hi < xi.hi))
+        {
+            continue;
+        }
+
+        // Корень доказан; все корни из X лежат в K(X), поэтому
+        // пересечение можно сужать, пока ширина уменьшается
+        for (int i = 0; i < 8; i++)
+        {
+            Interval next = {fmax(k.lo, xi.lo), fmin(k.hi, xi.hi)};
+            if (next.hi - next.lo >= xi.hi - xi.lo)
+            {
+                break;
+            }
+            xi = next;
+            k = krawczykStep(coef, degree, xi);
+        }
+        *root = xi;
+        return 1;
+    }
+
+    root->lo = x;
+    root->hi = x;
+    return 0;
+}
+
+// Функция для вычисления гарантированных границ корней
+int CertifyRoots(double a, double b, double c, double d,
+                 CertifiedResult* result)
+{
+    EquationResult estimate;
+    double coef[4];
+    int degree;
+
+    if (d == 0)
+    {
+        ComputeQuadratic(a, b, c, &estimate);
+        coef[0] = a;
+        coef[1] = b;
+        coef[2] = c;
+        degree = 2;
+    }
+    else
+    {
+        ComputeCubic(a, b, c, d, &estimate);
+        coef[0] = a;
+        coef[1] = b;
+        coef[2] = c;
+        coef[3] = d;
+        degree = 3;
+    }
+
+    result->degree = estimate.degree;
+    result->rootCase = estimate.rootCase;
+    result->count = estimate.count;
+
+    int verified = 0;
+    for (int i = 0; i < estimate.count; i++)
+    {
+        // Кратные корни: производная обращается в ноль, метод неприменим
+        int multiple = estimate.rootCase == ROOTS_SINGLE ||
+                       (estimate.rootCase == ROOTS_DOUBLE && i == 1);
+        if (multiple)
+        {
+            result->roots[i] = point(estimate.roots[i]);
+            result->verified[i] = 0;
+            continue;
+        }
+        result->verified[i] = certifyRoot(coef, degree, estimate.roots[i],
+                                          &result->roots[i]);
+        verified += result->verified[i];
+    }
+    return verified;
+}
+
+// Дописывает коэффициент или корень с двумя знаками после запятой
+static void appendValue(TextBuffer* text, double value)
+{
+    textAppendFixed(text, value, 2);
+}
+
+// Дописывает множитель (x - root)
+static void appendFactor(TextBuffer* text, double root)
+{
+    textAppendLiteral(text, "(x - ");
+    appendValue(text, root);
+    textAppendLiteral(text, ")");
+}
+
+// Дописывает начало разложения кубического уравнения до множителей
+// с корнями: (a)x^3 + (b)x^2 + (c)x + d = (a)
+static void appendCubicPolynomial(TextBuffer* text, double a, double b,
+                                  double c, double d)
+{
+    textAppendLiteral(text, "Разложение на множители: (");
+    appendValue(text, a);
+    textAppendLiteral(text, ")x^3 + (");
+    appendValue(text, b);
+    textAppendLiteral(text, ")x^2 + (");
+    appendValue(text, c);
+    textAppendLiteral(text, ")x + ");
+    appendValue(text, d);
+    textAppendLiteral(text, " = (");
+    appendValue(text, a);
+    textAppendLiteral(text, ")");
+}
+
+// Функция для записи найденного решения квадратного уравнения в буфер
+int FormatQuadraticRoots(char* out, size_t size, double a, double b,
+                         double c, const EquationResult* found)
+{
+    TextBuffer text;
+    textInit(&text, out, size);
+    // выводим коэффициенты
+    textAppendLiteral(&text, "Коэффициенты квадратного уравнения: a = ");
+    appendValue(&text, a);
+    textAppendLiteral(&text, ", b = ");
+    appendValue(&text, b);
+    textAppendLiteral(&text, ", c = ");
+    appendValue(&text, c);
+    textAppendLiteral(&text, "\n");
+    if (found->rootCase == ROOTS_NONE)
+    {
+        textAppendLiteral(&text, "Уравнение не имеет действительных корней.\n");
+    }
+    else if (found->rootCase == ROOTS_SINGLE)
+    {
+        double x = found->roots[0]; // единственный корень
+        textAppendLiteral(&text,
+                          "Уравнение имеет один действительный корень: x = ");
+        appendValue(&text, x);
+        textAppendLiteral(&text, "\nРазложение на множители: (");
+        appendValue(&text, a);
+        textAppendLiteral(&text, ")x + ");
+        appendValue(&text, b);
+        textAppendLiteral(&text, " = 0\n");
+    }
+    else
+    {
+        double x1 = found->roots[0]; // первый корень
+        double x2 = found->roots[1]; // второй корень
+        textAppendLiteral(&text,
+                          "Уравнение имеет два действительных корня: x1 = ");
+        appendValue(&text, x1);
+        textAppendLiteral(&text, ", x2 = ");
+        appendValue(&text, x2);
+        textAppendLiteral(&text, "\nРазложение на множители: (");
+        appendValue(&text, a);
+        textAppendLiteral(&text, ")x^2 + (");
+        appendValue(&text, b);
+        textAppendLiteral(&text, ")x + ");
+        appendValue(&text, c);
+        textAppendLiteral(&text, " = (");
+        appendValue(&text, a);
+        textAppendLiteral(&text, ")");
+        appendFactor(&text, x1);
+        appendFactor(&text, x2);
+        textAppendLiteral(&text, "\n");
+    }
+    return (int) text.length;
+}
+
+// Функция для записи решения квадратного уравнения в буфер
+int FormatQuadratic(char* out, size_t size, double a, double b, double c)
+{
+    EquationResult result;
+    ComputeQuadratic(a, b, c, &result);
+    return FormatQuadraticRoots(out, size, a, b, c, &result);
+}
+
+// Функция для записи найденного решения кубического уравнения в буфер
+int FormatCubicRoots(char* out, size_t size, double a, double b, double c,
+                     double d, const EquationResult* found)
+{
+    TextBuffer text;
+    textInit(&text, out, size);
+    textAppendLiteral(&text, "Коэффициенты кубического уравнения: a = ");
+    appendValue(&text, a);
+    textAppendLiteral(&text, ", b = ");
+    appendValue(&text, b);
+    textAppendLiteral(&text, ", c = ");
+    appendValue(&text, c);
+    textAppendLiteral(&text, ", d = ");
+    appendValue(&text, d);
+    textAppendLiteral(&text, "\n");
+    if (found->rootCase == ROOTS_ONE_REAL)
+    {
+        // Один действительный корень и два комплексных корня
+        double x = found->roots[0]; // Действительный корень
+        textAppendLiteral(&text,
+                          "Уравнение имеет один действительный корень: x = ");
+        appendValue(&text, x);
+        textAppendLiteral(&text, "\n");
+        appendCubicPolynomial(&text, a, b, c, d);
+        appendFactor(&text, x);
+        textAppendLiteral(&text, "\nДва комплексных корня не выводятся.\n");
+    }
+    else if (found->rootCase == ROOTS_DOUBLE)
+    {
+        // Три действительных корня, из которых два равны
+        double x1 = found->roots[0]; // Первый корень
+        double x2 = found->roots[1]; // Второй и третий корень
+        textAppendLiteral(&text,
+                          "Уравнение имеет три действительных корня: x1 = ");
+        appendValue(&text, x1);
+        textAppendLiteral(&text, ", x2 = x3 = ");
+        appendValue(&text, x2);
+        textAppendLiteral(&text, "\n");
+        appendCubicPolynomial(&text, a, b, c, d);
+        appendFactor(&text, x1);
+        appendFactor(&text, x2);
+        textAppendLiteral(&text, "^2\n");
     }
     else
     {
         // Три различных действительных корня
-        double phi = acos(-q / 2 * sqrt(-27 / (p * p * p))); // Угол
-        double x1 = 2 * sqrt(-p / 3) * cos(phi / 3); // Первый корень
-        double x2 =
-                2 * sqrt(-p / 3) * cos((phi + 2 * M_PI) / 3); // Второй корень
-        double x3 =
-                2 * sqrt(-p / 3) * cos((phi + 4 * M_PI) / 3); // Третий корень
-        printf("Уравнение имеет три различных действительных корня: x1 = %.2f, x2 = %.2f, x3 = %.2f\n",
-               x1, x2, x3);
-        printf("Разложение на множители: (%.2f)x^3 + (%.2f)x^2 + (%.2f)x + %.2f = (%.2f)(x - %.2f)(x - %.2f)(x - %.2f)\n",
-               a, b, c, d, a, x1, x2, x3);
+        double x1 = found->roots[0]; // Первый корень
+        double x2 = found->roots[1]; // Второй корень
+        double x3 = found->roots[2]; // Третий корень
+        textAppendLiteral(&text, "Уравнение имеет три различных "
+                                 "действительных корня: x1 = ");
+        appendValue(&text, x1);
+        textAppendLiteral(&text, ", x2 = ");
+        appendValue(&text, x2);
+        textAppendLiteral(&text, ", x3 = ");
+        appendValue(&text, x3);
+        textAppendLiteral(&text, "\n");
+        appendCubicPolynomial(&text, a, b, c, d);
+        appendFactor(&text, x1);
+        appendFactor(&text, x2);
+        appendFactor(&text, x3);
+        textAppendLiteral(&text, "\n");
+    }
+    return (int) text.length;
+}
+
+// Функция для записи решения кубического уравнения в буфер
+int FormatCubic(char* out, size_t size, double a, double b, double c,
+                double d)
+{
+    EquationResult result;
+    ComputeCubic(a, b, c, d, &result);
+    return FormatCubicRoots(out, size, a, b, c, d, &result);
+}
+
+// Функция для записи решений вдоль пути в буфер
+int FormatSweep(char* out, size_t size, const double from[4],
+                const double to[4], int points)
+{
+    TextBuffer text;
+    textInit(&text, out, size);
+    EquationResult results[2];
+    const EquationResult* previous = NULL;
+    for (int i = 0; i < points; i++)
+    {
+        double coef[4];
+        sweepPoint(from, to, i, points, coef);
+        if (coef[0] == 0)
+        {
+            textAppendLiteral(&text, "-\n");
+            previous = NULL;
+            continue;
+        }
+        // Результат точки - начальное приближение для следующей
+        EquationResult* result = &results[i % 2];
+        ComputeSeeded(coef[0], coef[1], coef[2], coef[3], previous, result);
+        previous = result;
+        textAppendInt(&text, result->count);
+        for (int k = 0; k < result->count; k++)
+        {
+            textAppendLiteral(&text, " ");
+            textAppendFixed(&text, result->roots[k], SWEEP_PRECISION);
+        }
+        textAppendLiteral(&text, "\n");
     }
+    return (int) text.length;
 }
 
+// Функция для записи значений многочлена и производных в точках в буфер
+int FormatEvaluation(char* out, size_t size, const double coef[4],
+                     const double* x, int points, int derivatives,
+                     unsigned flags)
+{
+    TextBuffer text;
+    textInit(&text, out, size);
+    for (int i = 0; i < points; i += EVAL_LANES)
+    {
+        int group = points - i < EVAL_LANES ? points - i : EVAL_LANES;
+        double values[3][EVAL_LANES];
+        EvaluatePolynomial(coef, 3, x + i, (size_t) group, flags, values[0],
+                           derivatives > 0 ? values[1] : NULL,
+                           derivatives > 1 ? values[2] : NULL);
+        for (int l = 0; l < group; l++)
+        {
+            for (int k = 0; k <= derivatives; k++)
+            {
+                if (k > 0)
+                {
+                    textAppendLiteral(&text, " ");
+                }
+                textAppendExact(&text, values[k][l]);
+            }
+            textAppendLiteral(&text, "\n");
+        }
+    }
+    return (int) text.length;
+}
+
+// Функция для записи гарантированных границ корней в буфер
+int FormatCertified(char* out, size_t size, double a, double b, double c,
+                    double d)
+{
+    TextBuffer text;
+    textInit(&text, out, size);
+    textAppendLiteral(&text, "Коэффициенты уравнения: a = ");
+    appendValue(&text, a);
+    textAppendLiteral(&text, ", b = ");
+    appendValue(&text, b);
+    textAppendLiteral(&text, ", c = ");
+    appendValue(&text, c);
+    textAppendLiteral(&text, ", d = ");
+    appendValue(&text, d);
+    textAppendLiteral(&text, "\n");
+    CertifiedResult result;
+    CertifyRoots(a, b, c, d, &result);
+    if (result.count == 0)
+    {
+        textAppendLiteral(&text, "Уравнение не имеет действительных корней.\n");
+    }
+    // Границы интервалов выводятся со всеми значащими цифрами через
+    // printf: этот запрос редкий, и его время определяет метод Кравчика
+    for (int i = 0; i < result.count; i++)
+    {
+        textAppendFormat(&text, "x%d ∈ [%.17g, %.17g]: %s\n", i + 1,
+                         result.roots[i].lo, result.roots[i].hi,
+                         result.verified[i] ? "корень подтверждён"
+                                            : "корень не подтверждён");
+    }
+    return (int) text.length;
+}
+
+// Функция для решения квадратного уравнения и вывода разложения на множители
+void SolveQuadratic(double a, double b, double c)
+{
+    char text[SOLUTION_TEXT_SIZE];
+    FormatQuadratic(text, sizeof(text), a, b, c);
+    fputs(text, stdout);
+}
+
+// Функция для решения кубического уравнения и вывода разложения на множители
+void SolveCubic(double a, double b, double c, double d)
+{
+    char text[SOLUTION_TEXT_SIZE];
+    FormatCubic(text, sizeof(text), a, b, c, d);
+    fputs(text, stdout);
+}
+
+// Функция для вывода гарантированных границ корней
+void SolveCertified(double a, double b, double c, double d)
+{
+    char text[SOLUTION_TEXT_SIZE];
+    FormatCertified(text, sizeof(text), a, b, c, d);
+    fputs(text, stdout);
+}
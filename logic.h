@@ -9,10 +9,400 @@
 #ifndef INC_5_LAB_LOGIC_H
 #define INC_5_LAB_LOGIC_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * \brief Достаточный размер буфера для текста решения одного уравнения
+ */
+#define SOLUTION_TEXT_SIZE 1024
+
+/*!
+ * \brief Случай расположения корней уравнения
+ */
+typedef enum
+{
+    ROOTS_NONE,      /*!< Квадратное: нет действительных корней */
+    ROOTS_SINGLE,    /*!< Квадратное: один действительный корень */
+    ROOTS_TWO,       /*!< Квадратное: два действительных корня */
+    ROOTS_ONE_REAL,  /*!< Кубическое: один действительный и два комплексных */
+    ROOTS_DOUBLE,    /*!< Кубическое: три действительных, два из них равны */
+    ROOTS_THREE      /*!< Кубическое: три различных действительных корня */
+} RootCase;
+
+/*!
+ * \brief Результат решения уравнения без вывода на экран
+ */
+typedef struct
+{
+    int degree;        /*!< Степень уравнения (2 или 3) */
+    RootCase rootCase; /*!< Случай расположения корней */
+    int count;         /*!< Количество найденных действительных корней */
+    double roots[3];   /*!< Действительные корни */
+} EquationResult;
+
+/*!
+ * \brief Пакет уравнений в виде отдельных массивов коэффициентов
+ * и результатов
+ *
+ * Каждый коэффициент и каждый результат хранится своим массивом, поэтому
+ * пакетный решатель читает и пишет их подряд, а файл пакета (eqfile.h)
+ * отображается в память прямо в таком виде, без разбора.
+ */
+typedef struct
+{
+    size_t count;      /*!< Количество уравнений */
+    double* a;         /*!< Первые коэффициенты */
+    double* b;         /*!< Вторые коэффициенты */
+    double* c;         /*!< Третьи коэффициенты */
+    double* d;         /*!< Четвёртые коэффициенты (0 у квадратных) */
+    uint8_t* degree;   /*!< Степени уравнений (0 - неверное уравнение) */
+    double* roots[3];  /*!< Корни: roots[k][i] - k-й корень i-го уравнения */
+    int8_t* rootCase;  /*!< Случаи расположения корней (RootCase) */
+    int8_t* rootCount; /*!< Количества корней (-1 - уравнение не решено) */
+} EquationBatch;
+
+/*!
+ * \brief Замкнутый интервал [lo, hi]
+ */
+typedef struct
+{
+    double lo; /*!< Нижняя граница */
+    double hi; /*!< Верхняя граница */
+} Interval;
+
+/*!
+ * \brief Результат решения с гарантированными границами корней
+ */
+typedef struct
+{
+    int degree;           /*!< Степень уравнения (2 или 3) */
+    RootCase rootCase;    /*!< Случай расположения корней */
+    int count;            /*!< Количество действительных корней */
+    Interval roots[3];    /*!< Интервалы, содержащие корни */
+    int verified[3];      /*!< 1, если корень в интервале доказан */
+} CertifiedResult;
+
+/*!
+ * \brief Вычисляет корни квадратного уравнения без вывода на экран
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[out] result Найденные корни
+ */
+void ComputeQuadratic(double a, double b, double c, EquationResult* result);
+
+/*!
+ * \brief Вычисляет действительные корни кубического уравнения по формуле
+ * Кардано без вывода на экран
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент
+ * \param[out] result Найденные корни
+ */
+void ComputeCubic(double a, double b, double c, double d,
+                  EquationResult* result);
+
+/*!
+ * \brief Решает уравнение, уточняя корни соседнего уравнения
+ *
+ * Для последовательности медленно меняющихся уравнений корни предыдущего
+ * уравнения - хорошее начальное приближение: несколько итераций метода
+ * Галлея дешевле acos, cos и cbrt формулы Кардано. Уравнение решается
+ * по формуле Кардано, если приближения нет, изменился случай
+ * расположения корней, корни сливаются или итерации не сошлись.
+ * Корни, найденные уточнением, идут в том же порядке, что и корни seed.
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент (0 для квадратного уравнения,
+ * которое всегда решается по формуле)
+ * \param[in] seed Решение соседнего уравнения или NULL
+ * \param[out] result Найденные корни (может совпадать с seed)
+ * \return 1, если корни найдены уточнением, 0 - если по формуле
+ */
+int ComputeSeeded(double a, double b, double c, double d,
+                  const EquationResult* seed, EquationResult* result);
+
+/*!
+ * \brief Решает уравнения в точках отрезка между двумя уравнениями
+ *
+ * Коэффициенты точки i равны (1 - t) * from + t * to, t = i / (points - 1).
+ * Каждая точка решается ComputeSeeded от решения предыдущей. У точек
+ * с нулевым старшим коэффициентом степень в результате равна 0.
+ * \param[in] from Коэффициенты a, b, c, d начала пути
+ * \param[in] to Коэффициенты a, b, c, d конца пути
+ * \param[in] points Количество точек
+ * \param[out] results Решения в точках (points элементов)
+ * \return Количество точек, решённых уточнением
+ */
+int ComputeSweep(const double from[4], const double to[4], int points,
+                 EquationResult* results);
+
+/*!
+ * \brief Решает уравнения пакета с номерами [begin, end)
+ *
+ * Уравнения решаются по тем же формулам, что в ComputeQuadratic и
+ * ComputeCubic, у неверных уравнений количество корней равно -1.
+ * Неиспользуемые корни обнуляются. Пакет решается блоками: сначала для
+ * всего блока векторными командами вычисляются дискриминанты, затем
+ * номера уравнений раскладываются по степени и случаю расположения корней,
+ * и уравнения каждого случая решаются подряд без ветвлений, которые
+ * процессор не угадал бы на перемешанных уравнениях. Разные потоки могут
+ * решать непересекающиеся части пакета.
+ * \param[in,out] batch Пакет уравнений
+ * \param[in] begin Номер первого уравнения
+ * \param[in] end Номер за последним уравнением
+ */
+void ComputeBatch(EquationBatch* batch, size_t begin, size_t end);
+
+/*!
+ * \brief Решает кубическое уравнение по приближённым функциям fastmath.h
+ *
+ * Случай расположения корней определяется так же, как в ComputeCubic, но
+ * вместо cbrt, acos и cos из libm используются приближения без переходов
+ * (ошибка каждого не больше 2 ulp), три различных корня вычисляются по
+ * одной паре косинус-синус трети угла, а единственный действительный
+ * корень - по одному кубическому корню без вычитания близких чисел.
+ * Медиана ошибки корней на наборах bench_logic не больше, чем у
+ * ComputeCubic, а 99-й перцентиль на случайных уравнениях - около 10 ulp
+ * вместо сотен; почти кратные корни так же неточны, как в ComputeCubic.
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент
+ * \param[out] result Найденные корни
+ */
+void ComputeCubicFast(double a, double b, double c, double d,
+                      EquationResult* result);
+
+/*!
+ * \brief Решает уравнения пакета с номерами [begin, end), как
+ * ComputeBatch, но кубические уравнения - формулами ComputeCubicFast:
+ * уравнения одного случая собираются в группы, и корни группы
+ * вычисляются векторными командами
+ * \param[in,out] batch Пакет уравнений
+ * \param[in] begin Номер первого уравнения
+ * \param[in] end Номер за последним уравнением
+ */
+void ComputeBatchFast(EquationBatch* batch, size_t begin, size_t end);
+
+/*!
+ * \brief Решает уравнение в long double
+ *
+ * Формулы те же, что в ComputeQuadratic и ComputeCubic, но вычисления
+ * идут в расширенной точности, а меньший по модулю корень квадратного
+ * уравнения и второй кубический корень формулы Кардано находятся без
+ * вычитания близких чисел. В несколько раз медленнее решения в double.
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент (0 для квадратного уравнения)
+ * \param[out] result Найденные корни
+ */
+void ComputeExtended(double a, double b, double c, double d,
+                     EquationResult* result);
+
+/*!
+ * \brief Решает уравнение в double и решает заново с повышенной
+ * точностью, только если решение в double ненадёжно
+ *
+ * Решение в double проверяется: случай расположения корней ненадёжен,
+ * если дискриминант (радикал формулы Кардано) по модулю не больше оценки
+ * его ошибки округления, а корень - если оценка его относительной ошибки
+ * больше 1e-12. Ошибка корня квадратного уравнения оценивается по
+ * обусловленности формулы, кубического - поправкой Ньютона по невязке,
+ * вычисленной компенсированной схемой Горнера. Такие уравнения (почти
+ * кратные корни, сильно различающиеся по величине корни) решаются заново,
+ * остальные остаются в double. Квадратное уравнение решается заново
+ * в long double. У кубического случай расположения корней определяют
+ * знаки многочлена в точках, где производная равна 0, вычисленные
+ * компенсированной схемой Горнера; значение, не больше ошибки округления
+ * кратного корня до double, означает кратный корень. Каждый корень
+ * находится методом Ньютона по той же невязке на своём отрезке
+ * монотонности, начиная с корня решения в double; шаги, выходящие
+ * за отрезок, заменяются делением отрезка.
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент (0 для квадратного уравнения)
+ * \param[out] result Найденные корни
+ * \return 1, если уравнение решено заново
+ */
+int ComputeAdaptive(double a, double b, double c, double d,
+                    EquationResult* result);
+
+/*!
+ * \brief Решает уравнения пакета с номерами [begin, end), как
+ * ComputeBatch, и повторяет решения, не прошедшие проверку
+ * ComputeAdaptive, так же, как ComputeAdaptive
+ * \param[in,out] batch Пакет уравнений
+ * \param[in] begin Номер первого уравнения
+ * \param[in] end Номер за последним уравнением
+ * \return Количество уравнений, решённых заново
+ */
+size_t ComputeBatchAdaptive(EquationBatch* batch, size_t begin, size_t end);
+
+/*!
+ * \brief Флаг EvaluatePolynomial: каждый шаг схемы Горнера - одна
+ * операция fma (быстрая, если процессор сборки умеет fma, см. FP_FAST_FMA)
+ */
+#define EVAL_FMA 1u
+
+/*!
+ * \brief Флаг EvaluatePolynomial: компенсированная схема Горнера
+ *
+ * Ошибки округления каждого шага собираются отдельно и добавляются
+ * к значению в конце: значение получается таким, как если бы оно
+ * вычислялось с удвоенной точностью, в том числе около корней, где
+ * обычная схема теряет все верные знаки. Производные вычисляются
+ * обычной схемой.
+ */
+#define EVAL_COMPENSATED 2u
+
+/*!
+ * \brief Вычисляет значения многочлена и его производных во многих точках
+ *
+ * Точки обрабатываются группами постоянной длины, поэтому шаги схемы
+ * Горнера выполняются векторными командами процессора сразу для всей
+ * группы.
+ * \param[in] coef Коэффициенты от старшего к свободному члену
+ * (degree + 1 элементов)
+ * \param[in] degree Степень многочлена (от 0 до 3)
+ * \param[in] x Точки
+ * \param[in] count Количество точек
+ * \param[in] flags EVAL_FMA и EVAL_COMPENSATED
+ * \param[out] values Значения многочлена
+ * \param[out] first Значения первой производной или NULL
+ * \param[out] second Значения второй производной или NULL (вычисляется
+ * только вместе с первой)
+ */
+void EvaluatePolynomial(const double* coef, int degree, const double* x,
+                        size_t count, unsigned flags, double* values,
+                        double* first, double* second);
+
+/*!
+ * \brief Вычисляет интервалы, гарантированно содержащие корни уравнения
+ *
+ * Оценка корня по формуле Кардано (или формуле для квадратного уравнения)
+ * уточняется методом Кравчика в интервальной арифметике с направленным
+ * округлением. Если оператор Кравчика отображает интервал строго внутрь
+ * себя, то в интервале доказано существование единственного корня.
+ * Кратные корни так подтвердить нельзя, для них verified равно 0.
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент (0 для квадратного уравнения)
+ * \param[out] result Интервалы корней
+ * \return Количество подтверждённых корней
+ */
+int CertifyRoots(double a, double b, double c, double d,
+                 CertifiedResult* result);
+
+/*!
+ * \brief Записывает решение квадратного уравнения и разложение на множители
+ * в буфер
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \return Длина записанного текста без нулевого символа
+ */
+int FormatQuadratic(char* out, size_t size, double a, double b, double c);
+
+/*!
+ * \brief Записывает решение кубического уравнения и разложение на множители
+ * в буфер
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент
+ * \return Длина записанного текста без нулевого символа
+ */
+int FormatCubic(char* out, size_t size, double a, double b, double c,
+                double d);
+
+/*!
+ * \brief Записывает уже найденное решение квадратного уравнения (например,
+ * взятое из кэша корней) и разложение на множители в буфер
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] found Решение, полученное ComputeQuadratic
+ * \return Длина записанного текста без нулевого символа
+ */
+int FormatQuadraticRoots(char* out, size_t size, double a, double b,
+                         double c, const EquationResult* found);
+
+/*!
+ * \brief Записывает уже найденное решение кубического уравнения и
+ * разложение на множители в буфер
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент
+ * \param[in] found Решение, полученное ComputeCubic
+ * \return Длина записанного текста без нулевого символа
+ */
+int FormatCubicRoots(char* out, size_t size, double a, double b, double c,
+                     double d, const EquationResult* found);
+
+/*!
+ * \brief Записывает решения в точках пути (см. ComputeSweep) в буфер
+ *
+ * На каждую точку - строка "n x1 ... xn" или "-", если старший
+ * коэффициент точки равен 0.
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \param[in] from Коэффициенты a, b, c, d начала пути
+ * \param[in] to Коэффициенты a, b, c, d конца пути
+ * \param[in] points Количество точек
+ * \return Длина записанного текста без нулевого символа
+ */
+int FormatSweep(char* out, size_t size, const double from[4],
+                const double to[4], int points);
+
+/*!
+ * \brief Записывает значения многочлена и производных в точках в буфер
+ *
+ * На каждую точку - строка "f" (или "f f'", "f f' f''") с 17 значащими
+ * цифрами.
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \param[in] coef Коэффициенты a, b, c, d многочлена a x^3 + b x^2 + c x + d
+ * \param[in] x Точки
+ * \param[in] points Количество точек
+ * \param[in] derivatives Количество производных (от 0 до 2)
+ * \param[in] flags EVAL_FMA и EVAL_COMPENSATED
+ * \return Длина записанного текста без нулевого символа
+ */
+int FormatEvaluation(char* out, size_t size, const double coef[4],
+                     const double* x, int points, int derivatives,
+                     unsigned flags);
+
+/*!
+ * \brief Записывает гарантированные границы корней в буфер
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент (0 для квадратного уравнения)
+ * \return Длина записанного текста без нулевого символа
+ */
+int FormatCertified(char* out, size_t size, double a, double b, double c,
+                    double d);
+
 /*!
  * \brief Решает квадратное уравнение и раскладывает на множители
- * \param[in] argc Количество аргументов командной строки
- * \param[in] argv Массив указателей на строки, содержащие аргументы
  * \param[in] a Первый коэффициент
  * \param[in] b Второй коэффициент
  * \param[in] c Третий коэффициент
@@ -28,4 +418,14 @@ void SolveQuadratic(double a, double b, double c);
  */
 void SolveCubic(double a, double b, double c, double d);
 
+/*!
+ * \brief Решает уравнение и выводит интервалы, гарантированно содержащие
+ * корни
+ * \param[in] a Первый коэффициент
+ * \param[in] b Второй коэффициент
+ * \param[in] c Третий коэффициент
+ * \param[in] d Четвёртый коэффициент (0 для квадратного уравнения)
+ */
+void SolveCertified(double a, double b, double c, double d);
+
 #endif //INC_5_LAB_LOGIC_H
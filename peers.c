@@ -0,0 +1,178 @@
+/*! Функции таблицы клиентов */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "peers.h"
+
+#define TOKEN_SCALE 1000 // маркеров на один запрос
+#define EVICT_SAMPLES 8 // записей, среди которых выбирается вытесняемая
+
+// Функция для вычисления номера цепочки по адресу клиента
+static size_t peerHash(const PeerTable* table, const SocketAddress* address)
+{
+    return (size_t) addressHostHash(address) & table->mask;
+}
+
+// Функция для удаления записи из цепочки
+static void peerUnlink(PeerTable* table, Peer* peer)
+{
+    Peer** link = &table->buckets[peerHash(table, &peer->address)];
+    while (*link != peer)
+    {
+        link = &(*link)->next;
+    }
+    *link = peer->next;
+}
+
+// Обработчик срабатывания срока удаления клиента
+static void peerIdle(Timer* timer)
+{
+    Peer* peer = (Peer*) ((char*) timer - offsetof(Peer, idle));
+    PeerTable* table = peer->table;
+
+    // Клиент присылал запросы после запуска таймера: переносим срок
+    uint64_t deadline = peer->lastSeen + table->idleMs;
+    if (deadline > table->wheel->current)
+    {
+        timerAdd(table->wheel, &peer->idle, deadline);
+        return;
+    }
+
+    // Удаляем запись из цепочки и возвращаем в список свободных
+    peerUnlink(table, peer);
+    peer->next = table->freeList;
+    table->freeList = peer;
+    table->count--;
+    table->evicted++;
+}
+
+// Функция для выделения записей таблицы
+int peerTableInit(PeerTable* table, size_t capacity, TimerWheel* wheel,
+                  uint64_t idleMs)
+{
+    memset(table, 0, sizeof(*table));
+    // Цепочек - степень двойки не меньше ёмкости
+    size_t buckets = 1;
+    while (buckets < capacity)
+    {
+        buckets <<= 1;
+    }
+    table->entries = calloc(capacity, sizeof(Peer));
+    table->buckets = calloc(buckets, sizeof(Peer*));
+    if (table->entries == NULL || table->buckets == NULL)
+    {
+        free(table->entries);
+        free(table->buckets);
+        return -1;
+    }
+    for (size_t i = capacity; i > 0; i--)
+    {
+        Peer* peer = &table->entries[i - 1];
+        peer->table = table;
+        peer->idle.callback = peerIdle;
+        peer->next = table->freeList;
+        table->freeList = peer;
+    }
+    table->mask = buckets - 1;
+    table->capacity = capacity;
+    table->wheel = wheel;
+    table->idleMs = idleMs;
+    return 0;
+}
+
+// Функция для учёта запроса клиента
+Peer* peerTouch(PeerTable* table, const SocketAddress* address,
+                uint64_t now)
+{
+    Peer** bucket = &table->buckets[peerHash(table, address)];
+    for (Peer* peer = *bucket; peer != NULL; peer = peer->next)
+    {
+        if (addressHostEqual(&peer->address, address))
+        {
+            peer->lastSeen = now;
+            peer->requests++;
+            return peer;
+        }
+    }
+
+    // Новый клиент
+    Peer* peer = table->freeList;
+    if (peer != NULL)
+    {
+        table->freeList = peer->next;
+        table->count++;
+    }
+    else
+    {
+        // Вытесняем клиента, дольше всех не присылавшего запросов среди
+        // EVICT_SAMPLES записей; следующая выборка начнётся дальше
+        for (int i = 0; i < EVICT_SAMPLES; i++)
+        {
+            Peer* candidate = &table->entries[table->cursor];
+            table->cursor = (table->cursor + 1) % table->capacity;
+            if (peer == NULL || candidate->lastSeen < peer->lastSeen)
+            {
+                peer = candidate;
+            }
+        }
+        peerUnlink(table, peer);
+        timerCancel(table->wheel, &peer->idle);
+        table->displaced++;
+    }
+    peer->address = *address;
+    peer->lastSeen = now;
+    peer->requests = 1;
+    // Новый клиент начинает с полной корзиной
+    peer->tokens = (int64_t) table->burst * TOKEN_SCALE;
+    peer->refilled = now;
+    peer->next = *bucket;
+    *bucket = peer;
+    timerAdd(table->wheel, &peer->idle, now + table->idleMs);
+    return peer;
+}
+
+// Функция для ограничения частоты запросов клиентов
+void peerTableLimit(PeerTable* table, uint64_t rate, uint64_t burst)
+{
+    table->rate = rate;
+    table->burst = burst > 0 ? burst : 1;
+}
+
+// Функция для проверки корзины маркеров клиента
+int peerAdmit(PeerTable* table, Peer* peer, unsigned long cost,
+              uint64_t now)
+{
+    if (table->rate == 0)
+    {
+        return 1;
+    }
+    // За миллисекунду добавляется rate тысячных долей запроса; после
+    // долгого простоя корзина просто полна
+    int64_t limit = (int64_t) table->burst * TOKEN_SCALE;
+    uint64_t elapsed = now - peer->refilled;
+    peer->tokens = elapsed * table->rate >= (uint64_t) (limit - peer->tokens)
+                   ? limit : peer->tokens + (int64_t) (elapsed * table->rate);
+    peer->refilled = now;
+    if (peer->tokens < TOKEN_SCALE)
+    {
+        table->shed++;
+        return 0;
+    }
+    peer->tokens -= (int64_t) cost * TOKEN_SCALE;
+    return 1;
+}
+
+// Функция для освобождения записей таблицы
+void peerTableDestroy(PeerTable* table)
+{
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        timerCancel(table->wheel, &table->entries[i].idle);
+    }
+    free(table->entries);
+    free(table->buckets);
+    table->entries = NULL;
+    table->buckets = NULL;
+}
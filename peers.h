@@ -0,0 +1,124 @@
+/*!
+ * \file peers.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение таблицы клиентов обработчика.
+ * Клиент - адрес узла без порта: запросы со всех сокетов одного узла
+ * (асинхронный клиент открывает сокет на каждый запрос в полёте) учитываются
+ * вместе. Для каждого клиента хранится время последнего запроса; клиент,
+ * от которого долго нет запросов, удаляется по таймеру. Все записи
+ * выделяются при создании таблицы; когда они заняты, новый клиент
+ * вытесняет давно не присылавшего запросы.
+ *
+ * Запись хранит и корзину маркеров клиента: если частота запросов
+ * ограничена, запрос без маркера отклоняется ещё до разбора.
+*/
+
+#ifndef INC_6_LAB_PEERS_H
+#define INC_6_LAB_PEERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "address.h"
+#include "timerwheel.h"
+
+/*!
+ * \brief Запись о клиенте
+ */
+typedef struct Peer
+{
+    SocketAddress address;   /*!< Адрес клиента (порт первого запроса) */
+    uint64_t lastSeen;       /*!< Время последнего запроса, мс */
+    unsigned long requests;  /*!< Количество запросов */
+    int64_t tokens;          /*!< Маркеры в тысячных долях запроса
+                                  (меньше 0 - долг за большой ответ) */
+    uint64_t refilled;       /*!< Время пополнения корзины, мс */
+    Timer idle;              /*!< Срок удаления при простое */
+    struct Peer* next;       /*!< Следующая запись цепочки или списка */
+    struct PeerTable* table; /*!< Таблица, которой принадлежит запись */
+} Peer;
+
+/*!
+ * \brief Хеш-таблица клиентов фиксированной ёмкости
+ */
+typedef struct PeerTable
+{
+    Peer* entries;          /*!< Все записи */
+    Peer** buckets;         /*!< Цепочки записей */
+    size_t mask;            /*!< Количество цепочек минус один */
+    Peer* freeList;         /*!< Свободные записи */
+    size_t count;           /*!< Количество клиентов */
+    size_t capacity;        /*!< Наибольшее количество клиентов */
+    TimerWheel* wheel;      /*!< Колесо, на котором стоят сроки удаления */
+    uint64_t idleMs;        /*!< Время простоя до удаления, мс */
+    unsigned long evicted;  /*!< Удалено клиентов по простою */
+    unsigned long displaced; /*!< Клиентов, вытесненных новыми при
+                                  заполненной таблице */
+    size_t cursor;          /*!< Начало следующей выборки вытесняемых */
+    uint64_t rate;          /*!< Запросов в секунду на клиента (0 - без
+                                 ограничения) */
+    uint64_t burst;         /*!< Ёмкость корзины в запросах */
+    unsigned long shed;     /*!< Отклонено запросов сверх ограничения */
+} PeerTable;
+
+/*!
+ * \brief Выделяет записи таблицы
+ * \param[out] table Таблица
+ * \param[in] capacity Наибольшее количество клиентов
+ * \param[in] wheel Колесо таймеров владельца таблицы
+ * \param[in] idleMs Время простоя до удаления, мс
+ * \return 0 при успехе, -1 при ошибке
+ */
+int peerTableInit(PeerTable* table, size_t capacity, TimerWheel* wheel,
+                  uint64_t idleMs);
+
+/*!
+ * \brief Отмечает запрос клиента, добавляя его в таблицу при необходимости
+ *
+ * Таймер удаления при этом не переставляется: при срабатывании он
+ * сверяется с временем последнего запроса и при необходимости
+ * запускается заново, поэтому частые запросы не трогают колесо.
+ * Если таблица заполнена, новый клиент занимает запись того, кто дольше
+ * всех не присылал запросов среди нескольких записей, просматриваемых
+ * по кругу: иначе клиенты, не попавшие в таблицу, обходили бы
+ * ограничение частоты.
+ * \param[in] table Таблица
+ * \param[in] address Адрес клиента
+ * \param[in] now Текущее время, мс
+ * \return Запись клиента
+ */
+Peer* peerTouch(PeerTable* table, const SocketAddress* address,
+                uint64_t now);
+
+/*!
+ * \brief Ограничивает частоту запросов каждого клиента
+ * \param[in] table Таблица
+ * \param[in] rate Запросов в секунду (0 - без ограничения)
+ * \param[in] burst Сколько запросов клиент может прислать подряд
+ * после простоя
+ */
+void peerTableLimit(PeerTable* table, uint64_t rate, uint64_t burst);
+
+/*!
+ * \brief Пополняет корзину клиента и берёт из неё маркеры запроса
+ *
+ * Запрос выполняется, если в корзине есть маркер хотя бы на один
+ * запрос; запрос дороже оставшихся маркеров оставляет клиента в долгу,
+ * и следующие его запросы ждут, пока корзина не пополнится.
+ * \param[in] table Таблица
+ * \param[in] peer Запись клиента
+ * \param[in] cost Стоимость запроса в запросах (ответ на запрос сетки
+ * стоит по запросу на каждую датаграмму)
+ * \param[in] now Текущее время, мс
+ * \return 1, если запрос можно выполнить, 0, если его надо отклонить
+ */
+int peerAdmit(PeerTable* table, Peer* peer, unsigned long cost,
+              uint64_t now);
+
+/*!
+ * \brief Освобождает записи таблицы и отменяет их таймеры
+ * \param[in] table Таблица
+ */
+void peerTableDestroy(PeerTable* table);
+
+#endif //INC_6_LAB_PEERS_H
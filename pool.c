@@ -0,0 +1,128 @@
+/*! Функции пула буферов */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "pool.h"
+
+// Размер huge page, под который округляется область
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Функция для выделения памяти пула
+int poolInit(BufferPool* pool, size_t slots, size_t size, int hugePages)
+{
+    memset(pool, 0, sizeof(*pool));
+    // Округляем размер буфера до строки кэша, чтобы соседние буферы
+    // не делили одну строку
+    pool->slotSize = (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    pool->slots = slots;
+
+    // Стеки свободных номеров хранятся в той же области после буферов
+    size_t bytes = pool->slotSize * slots + 2 * sizeof(size_t) * slots;
+    void* memory = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (hugePages)
+    {
+        size_t rounded = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+                         HUGE_PAGE_SIZE;
+        memory = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+            bytes = rounded;
+            pool->hugePages = 1;
+        }
+    }
+#endif
+
+    if (memory == MAP_FAILED)
+    {
+        // Huge pages не зарезервированы: используем обычные страницы
+        memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            perror("mmap");
+            return -1;
+        }
+#ifdef MADV_HUGEPAGE
+        if (hugePages)
+        {
+            // Просим ядро собрать область в прозрачные huge pages
+            madvise(memory, bytes, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    pool->memory = memory;
+    pool->mapped = bytes;
+    pool->freeList = (size_t*) (pool->memory + pool->slotSize * slots);
+    pool->remoteNext = pool->freeList + slots;
+    atomic_init(&pool->remoteHead, 0);
+    // Заполняем стек так, чтобы первым выдавался буфер с номером 0
+    for (size_t i = 0; i < slots; i++)
+    {
+        pool->freeList[i] = slots - 1 - i;
+    }
+    pool->freeCount = slots;
+    return 0;
+}
+
+// Функция для получения свободного буфера
+char* poolAcquire(BufferPool* pool)
+{
+    if (pool->freeCount == 0)
+    {
+        // Забираем сразу весь стек буферов, возвращённых другими потоками.
+        // Извлечение всего стека одной операцией исключает проблему ABA
+        size_t head = atomic_exchange_explicit(&pool->remoteHead, 0,
+                                               memory_order_acquire);
+        while (head != 0)
+        {
+            pool->freeList[pool->freeCount++] = head - 1;
+            head = pool->remoteNext[head - 1];
+        }
+    }
+    if (pool->freeCount == 0)
+    {
+        pool->exhausted++;
+        return NULL;
+    }
+    size_t index = pool->freeList[--pool->freeCount];
+    return pool->memory + index * pool->slotSize;
+}
+
+// Функция для возврата буфера в пул
+void poolRelease(BufferPool* pool, char* buffer)
+{
+    size_t index = (size_t) (buffer - pool->memory) / pool->slotSize;
+    pool->freeList[pool->freeCount++] = index;
+}
+
+// Функция для возврата буфера в пул из другого потока
+void poolReleaseRemote(BufferPool* pool, char* buffer)
+{
+    size_t index = (size_t) (buffer - pool->memory) / pool->slotSize;
+    size_t head = atomic_load_explicit(&pool->remoteHead,
+                                       memory_order_relaxed);
+    do
+    {
+        pool->remoteNext[index] = head;
+    }
+    while (!atomic_compare_exchange_weak_explicit(&pool->remoteHead, &head,
+                                                  index + 1,
+                                                  memory_order_release,
+                                                  memory_order_relaxed));
+}
+
+// Функция для освобождения памяти пула
+void poolDestroy(BufferPool* pool)
+{
+    if (pool->memory != NULL)
+    {
+        munmap(pool->memory, pool->mapped);
+    }
+    memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,79 @@
+/*!
+ * \file pool.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение пула буферов приёма и отправки.
+ * Вся память пула выделяется одним отображением при запуске, поэтому
+ * в установившемся режиме работы сервера вызовы malloc не требуются.
+ *
+ * Брать буферы может только поток-владелец пула. Вернуть буфер может любой
+ * поток: чужие буферы складываются в отдельный стек без блокировок,
+ * который владелец забирает целиком, когда его собственный стек пуст.
+*/
+
+#ifndef INC_6_LAB_POOL_H
+#define INC_6_LAB_POOL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*!
+ * \brief Размер строки кэша, по которой выравниваются буферы
+ */
+#define CACHE_LINE 64
+
+/*!
+ * \brief Пул буферов фиксированного размера
+ */
+typedef struct
+{
+    char* memory;           /*!< Отображённая область с буферами */
+    size_t mapped;          /*!< Размер отображённой области в байтах */
+    size_t slotSize;        /*!< Размер одного буфера, кратный CACHE_LINE */
+    size_t slots;           /*!< Количество буферов */
+    size_t* freeList;       /*!< Стек номеров свободных буферов */
+    size_t freeCount;       /*!< Количество свободных буферов */
+    size_t* remoteNext;     /*!< Ссылки стека буферов из других потоков */
+    atomic_size_t remoteHead; /*!< Вершина этого стека (номер + 1) */
+    int hugePages;          /*!< 1, если область выделена в huge pages */
+    unsigned long exhausted; /*!< Сколько раз пул оказался пуст */
+} BufferPool;
+
+/*!
+ * \brief Выделяет память пула и заполняет стек свободных буферов
+ * \param[out] pool Пул
+ * \param[in] slots Количество буферов
+ * \param[in] size Минимальный размер одного буфера в байтах
+ * \param[in] hugePages 1, чтобы попытаться выделить память в huge pages
+ * \return 0 при успехе, -1 при ошибке
+ */
+int poolInit(BufferPool* pool, size_t slots, size_t size, int hugePages);
+
+/*!
+ * \brief Берёт свободный буфер из пула
+ * \param[in] pool Пул
+ * \return Указатель на буфер или NULL, если свободных буферов нет
+ */
+char* poolAcquire(BufferPool* pool);
+
+/*!
+ * \brief Возвращает буфер в пул
+ * \param[in] pool Пул
+ * \param[in] buffer Буфер, полученный из poolAcquire
+ */
+void poolRelease(BufferPool* pool, char* buffer);
+
+/*!
+ * \brief Возвращает буфер в пул из потока, не владеющего пулом
+ * \param[in] pool Пул
+ * \param[in] buffer Буфер, полученный из poolAcquire
+ */
+void poolReleaseRemote(BufferPool* pool, char* buffer);
+
+/*!
+ * \brief Освобождает память пула
+ * \param[in] pool Пул
+ */
+void poolDestroy(BufferPool* pool);
+
+#endif //INC_6_LAB_POOL_H
@@ -0,0 +1,425 @@
+/*! Функции разбора и формирования сообщений */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "protocol.h"
+#include "logic.h"
+
+#define GRID_ROUNDING 1e-9 // доля шага, на которую граница диапазона может
+                           // не дотягивать из-за округления
+
+// Пропускает пробельные символы
+static const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+    {
+        p++;
+    }
+    return p;
+}
+
+// Функция для разбора номера запроса
+size_t decodeRequestId(const char* buffer, size_t length, uint64_t* id)
+{
+    *id = 0;
+    if (length < 3 || buffer[0] != ID_PREFIX[0])
+    {
+        return 0;
+    }
+    // Номер - не больше 19 десятичных цифр (помещается в 64 бита),
+    // за которыми идёт пробел
+    uint64_t value = 0;
+    size_t i = 1;
+    while (i < length && i <= 19 && buffer[i] >= '0' &&
+           buffer[i] <= '9')
+    {
+        value = value * 10 + (uint64_t) (buffer[i] - '0');
+        i++;
+    }
+    if (i == 1 || i >= length || buffer[i] != ' ' || value == 0)
+    {
+        return 0;
+    }
+    *id = value;
+    return i + 1;
+}
+
+// Функция для вычисления размеров сетки
+long gridPoints(const Request* request, long counts[4])
+{
+    const double from[4] = {request->a, request->b, request->c, request->d};
+    double total = 1;
+    for (int k = 0; k < 4; k++)
+    {
+        double span = request->to[k] - from[k];
+        counts[k] = 1;
+        if (span != 0)
+        {
+            double steps = span / request->step[k];
+            // Шаг должен вести от начала диапазона к концу
+            if (!(steps > 0 && steps < GRID_MAX_POINTS))
+            {
+                return -1;
+            }
+            counts[k] = (long) floor(steps + GRID_ROUNDING) + 1;
+        }
+        total *= counts[k];
+    }
+    return total <= GRID_MAX_POINTS ? (long) total : -1;
+}
+
+// Функция для разбора запроса сетки: коэффициенты - числа или диапазоны
+// "от:до:шаг", за ними может идти диапазон блоков "chunks first-last"
+static int decodeGrid(const char* p, const char* end, Request* request)
+{
+    double from[4] = {0, 0, 0, 0};
+    int axes = 0;
+    while (axes < 4)
+    {
+        p = skipSpaces(p, end);
+        if (p == end || *p == GRID_CHUNKS[0])
+        {
+            break;
+        }
+        char* next;
+        from[axes] = strtod(p, &next);
+        if (next == p)
+        {
+            return -1;
+        }
+        request->to[axes] = from[axes];
+        request->step[axes] = 0;
+        if (*next == ':')
+        {
+            p = next + 1;
+            request->to[axes] = strtod(p, &next);
+            if (next == p || *next != ':')
+            {
+                return -1;
+            }
+            p = next + 1;
+            request->step[axes] = strtod(p, &next);
+            if (next == p)
+            {
+                return -1;
+            }
+        }
+        p = next;
+        axes++;
+    }
+    for (int k = axes; k < 4; k++)
+    {
+        request->to[k] = 0;
+        request->step[k] = 0;
+    }
+    p = skipSpaces(p, end);
+    request->a = from[0];
+    request->b = from[1];
+    request->c = from[2];
+    request->d = from[3];
+
+    long counts[4];
+    long points = gridPoints(request, counts);
+    if (axes < 3 || points < 1)
+    {
+        return -1;
+    }
+    // Запрос без диапазона получает первые GRID_MAX_CHUNKS блоков
+    long lastChunk = (points - 1) / GRID_CHUNK_POINTS;
+    request->firstChunk = 0;
+    request->lastChunk = lastChunk < GRID_MAX_CHUNKS - 1
+                         ? lastChunk : GRID_MAX_CHUNKS - 1;
+
+    // Следующие блоки и повторы пропавших просятся диапазоном
+    if ((size_t) (end - p) > strlen(GRID_CHUNKS) &&
+        memcmp(p, GRID_CHUNKS, strlen(GRID_CHUNKS)) == 0)
+    {
+        char* next;
+        long first = strtol(p + strlen(GRID_CHUNKS), &next, 10);
+        if (*next != '-')
+        {
+            return -1;
+        }
+        long last = strtol(next + 1, &next, 10);
+        if (first < 0 || first > last || last > lastChunk ||
+            last - first >= GRID_MAX_CHUNKS)
+        {
+            return -1;
+        }
+        request->firstChunk = first;
+        request->lastChunk = last;
+        p = next;
+    }
+    return skipSpaces(p, end) == end ? 0 : -1;
+}
+
+// Функция для разбора запроса значений многочлена: количество производных
+// с буквами режимов, коэффициенты до ":" и точки после него
+static int decodeEval(const char* p, const char* end, Request* request)
+{
+    if (p == end || *p < '0' || *p > '2')
+    {
+        return -1;
+    }
+    request->derivatives = *p++ - '0';
+    request->evalFlags = 0;
+    for (; p < end && *p != ' '; p++)
+    {
+        if (*p == 'c')
+        {
+            request->evalFlags |= EVAL_COMPENSATED;
+        }
+        else if (*p == 'f')
+        {
+            request->evalFlags |= EVAL_FMA;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+
+    double coef[4];
+    int count = 0;
+    while (1)
+    {
+        p = skipSpaces(p, end);
+        if (p < end && *p == ':')
+        {
+            p++;
+            break;
+        }
+        char* next;
+        if (count == 4 || (coef[count] = strtod(p, &next), next == p))
+        {
+            return -1;
+        }
+        p = next;
+        count++;
+    }
+    if (count < 3)
+    {
+        return -1;
+    }
+    // Квадратный многочлен - кубический со старшим коэффициентом 0
+    double* target[4] = {&request->a, &request->b, &request->c, &request->d};
+    for (int k = 0; k < 4; k++)
+    {
+        *target[k] = k < 4 - count ? 0 : coef[k - (4 - count)];
+    }
+
+    // Точек не больше, чем помещается значений в ответ
+    int limit = EVAL_MAX_VALUES / (request->derivatives + 1);
+    request->points = 0;
+    while ((p = skipSpaces(p, end)) < end)
+    {
+        char* next;
+        if (request->points == limit)
+        {
+            return -1;
+        }
+        request->x[request->points] = strtod(p, &next);
+        if (next == p)
+        {
+            return -1;
+        }
+        request->points++;
+        p = next;
+    }
+    return request->points > 0 ? 0 : -1;
+}
+
+// Функция для разбора запроса в приёмном буфере
+int decodeRequest(const char* buffer, size_t length, Request* request)
+{
+    // Номер запроса нужен только для ответа и отсеивания повторов
+    size_t prefix = decodeRequestId(buffer, length, &request->id);
+    buffer += prefix;
+    length -= prefix;
+
+    const char* p = buffer;
+    const char* end = buffer + length;
+    double coef[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    int count = 0;
+    int limit = 4; // наибольшее количество чисел после префикса
+
+    request->type = REQUEST_SOLVE;
+    if (length >= strlen(STATS_REQUEST) &&
+        memcmp(p, STATS_REQUEST, strlen(STATS_REQUEST)) == 0 &&
+        skipSpaces(p + strlen(STATS_REQUEST), end) == end)
+    {
+        request->type = REQUEST_STATS;
+        return 0;
+    }
+    if (length >= strlen(PING_REQUEST) &&
+        memcmp(p, PING_REQUEST, strlen(PING_REQUEST)) == 0 &&
+        skipSpaces(p + strlen(PING_REQUEST), end) == end)
+    {
+        request->type = REQUEST_PING;
+        return 0;
+    }
+    if (length >= strlen(CERT_PREFIX) &&
+        memcmp(p, CERT_PREFIX, strlen(CERT_PREFIX)) == 0)
+    {
+        request->type = REQUEST_CERT;
+        p += strlen(CERT_PREFIX);
+    }
+    else if (length >= strlen(SWEEP_PREFIX) &&
+             memcmp(p, SWEEP_PREFIX, strlen(SWEEP_PREFIX)) == 0)
+    {
+        // Количество точек и коэффициенты обоих концов пути
+        char* next;
+        long points = strtol(p + strlen(SWEEP_PREFIX), &next, 10);
+        if (next == p + strlen(SWEEP_PREFIX) || points < 1 ||
+            points > SWEEP_MAX_POINTS || (next < end && *next != ' '))
+        {
+            return -1;
+        }
+        request->type = REQUEST_SWEEP;
+        request->points = (int) points;
+        p = next;
+        limit = 8;
+    }
+    else if (length >= strlen(GRID_PREFIX) &&
+             memcmp(p, GRID_PREFIX, strlen(GRID_PREFIX)) == 0)
+    {
+        request->type = REQUEST_GRID;
+        return decodeGrid(p + strlen(GRID_PREFIX), end, request);
+    }
+    else if (length >= strlen(EVAL_PREFIX) &&
+             memcmp(p, EVAL_PREFIX, strlen(EVAL_PREFIX)) == 0)
+    {
+        request->type = REQUEST_EVAL;
+        return decodeEval(p + strlen(EVAL_PREFIX), end, request);
+    }
+
+    // strtod читает число прямо из буфера; нулевой символ после сообщения
+    // не даёт ему выйти за границу
+    while (count < limit)
+    {
+        p = skipSpaces(p, end);
+        if (p == end)
+        {
+            break;
+        }
+        char* next;
+        coef[count] = strtod(p, &next);
+        if (next == p)
+        {
+            return -1;
+        }
+        p = next;
+        count++;
+    }
+
+    // Должно быть три или четыре коэффициента (у пути - восемь) и ничего
+    // после них
+    if (count < 3 || (limit == 8 && count != 8) || skipSpaces(p, end) != end)
+    {
+        return -1;
+    }
+
+    request->a = coef[0];
+    request->b = coef[1];
+    request->c = coef[2];
+    request->d = coef[3];
+    for (int k = 0; k < 4; k++)
+    {
+        request->to[k] = coef[4 + k];
+    }
+    return 0;
+}
+
+// Функция для записи запроса в буфер отправки
+int encodeRequest(char* buffer, size_t size, const Request* request)
+{
+    const char* prefix = request->type == REQUEST_CERT ? CERT_PREFIX : "";
+    int idLength = 0;
+    int length;
+
+    if (request->id != 0)
+    {
+        idLength = snprintf(buffer, size, "%s%llu ", ID_PREFIX,
+                            (unsigned long long) request->id);
+        if (idLength < 0 || (size_t) idLength >= size)
+        {
+            return -1;
+        }
+        buffer += idLength;
+        size -= idLength;
+    }
+    if (request->type == REQUEST_STATS)
+    {
+        length = snprintf(buffer, size, "%s", STATS_REQUEST);
+    }
+    else if (request->type == REQUEST_PING)
+    {
+        length = snprintf(buffer, size, "%s", PING_REQUEST);
+    }
+    else if (request->type == REQUEST_SWEEP)
+    {
+        // Концы пути передаются точно: по ним сервер строит все точки
+        length = snprintf(buffer, size, "%s%d %.17g %.17g %.17g %.17g "
+                          "%.17g %.17g %.17g %.17g", SWEEP_PREFIX,
+                          request->points, request->a, request->b,
+                          request->c, request->d, request->to[0],
+                          request->to[1], request->to[2], request->to[3]);
+    }
+    else if (request->type == REQUEST_GRID)
+    {
+        const double from[4] = {request->a, request->b, request->c,
+                                request->d};
+        length = snprintf(buffer, size, "%s", GRID_PREFIX);
+        for (int k = 0; k < 4 && length >= 0 && (size_t) length < size; k++)
+        {
+            int axis = request->step[k] == 0
+                ? snprintf(buffer + length, size - length, "%.17g ", from[k])
+                : snprintf(buffer + length, size - length,
+                           "%.17g:%.17g:%.17g ", from[k], request->to[k],
+                           request->step[k]);
+            length = axis < 0 ? axis : length + axis;
+        }
+        if (length >= 0 && (size_t) length < size)
+        {
+            int chunks = snprintf(buffer + length, size - length, "%s%ld-%ld",
+                                  GRID_CHUNKS, request->firstChunk,
+                                  request->lastChunk);
+            length = chunks < 0 ? chunks : length + chunks;
+        }
+    }
+    else if (request->type == REQUEST_EVAL)
+    {
+        length = snprintf(buffer, size, "%s%d%s%s %.17g %.17g %.17g %.17g :",
+                          EVAL_PREFIX, request->derivatives,
+                          request->evalFlags & EVAL_COMPENSATED ? "c" : "",
+                          request->evalFlags & EVAL_FMA ? "f" : "",
+                          request->a, request->b, request->c, request->d);
+        for (int i = 0; i < request->points && length >= 0 &&
+                        (size_t) length < size; i++)
+        {
+            int point = snprintf(buffer + length, size - length, " %.17g",
+                                 request->x[i]);
+            length = point < 0 ? point : length + point;
+        }
+    }
+    else if (request->d == 0)
+    {
+        // Формируем строку с коэффициентами квадратного уравнения
+        length = snprintf(buffer, size, "%s%lf %lf %lf", prefix,
+                          request->a, request->b, request->c);
+    }
+    else
+    {
+        // Формируем строку с коэффициентами кубического уравнения
+        length = snprintf(buffer, size, "%s%lf %lf %lf %lf", prefix,
+                          request->a, request->b, request->c, request->d);
+    }
+    if (length < 0 || (size_t) length >= size)
+    {
+        return -1;
+    }
+    return idLength + length;
+}
@@ -0,0 +1,194 @@
+/*!
+ * \file protocol.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение функций разбора запросов клиента
+ * и формирования сообщений. Запрос имеет вид "[cert ]a b c [d]", "stats"
+ * (запрос статистики сервера), "ping" (проверка того, что сервер
+ * отвечает: ответ "pong"), "sweep n a0 b0 c0 d0 a1 b1 c1 d1" (решение
+ * n уравнений на отрезке между двумя уравнениями), "grid a b c [d]
+ * [chunks first-last]", где каждый коэффициент - число или диапазон
+ * "от:до:шаг" (решение всех уравнений сетки, ответ - блоками, grid.h),
+ * или "eval k[c][f] a b c [d] : x1 ... xn" (значения многочлена и k его
+ * производных в точках; c - компенсированная схема Горнера, f - fma).
+ * Перед запросом может стоять его номер "@id ": тогда ответ начинается
+ * с того же номера, а повторная отправка запроса с тем же номером
+ * не решает уравнение заново.
+*/
+
+#ifndef INC_6_LAB_PROTOCOL_H
+#define INC_6_LAB_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * \brief Максимальный размер сообщения в байтах
+ */
+#define MAXBUF 1024
+
+/*!
+ * \brief Префикс запроса гарантированных границ корней
+ */
+#define CERT_PREFIX "cert "
+
+/*!
+ * \brief Префикс запроса решения уравнений вдоль пути
+ */
+#define SWEEP_PREFIX "sweep "
+
+/*!
+ * \brief Наибольшее количество точек пути: ответ должен поместиться
+ * в один пакет
+ */
+#define SWEEP_MAX_POINTS 20
+
+/*!
+ * \brief Префикс запроса решения уравнений на сетке коэффициентов
+ */
+#define GRID_PREFIX "grid "
+
+/*!
+ * \brief Префикс диапазона блоков в запросе сетки
+ */
+#define GRID_CHUNKS "chunks "
+
+/*!
+ * \brief Уравнений в блоке ответа на запрос сетки
+ */
+#define GRID_CHUNK_POINTS 256
+
+/*!
+ * \brief Наибольшее количество уравнений сетки
+ */
+#define GRID_MAX_POINTS 100000000L
+
+/*!
+ * \brief Наибольшее количество блоков в ответе на один запрос сетки:
+ * большую сетку клиент получает частями "chunks first-last", поэтому
+ * короткий запрос с чужого адреса не вызывает поток датаграмм
+ */
+#define GRID_MAX_CHUNKS 32
+
+/*!
+ * \brief Префикс запроса значений многочлена в точках
+ */
+#define EVAL_PREFIX "eval "
+
+/*!
+ * \brief Наибольшее количество значений в ответе на запрос eval (точек,
+ * умноженных на количество производных плюс 1): ответ помещается
+ * в датаграмму
+ */
+#define EVAL_MAX_VALUES 36
+
+/*!
+ * \brief Признак номера запроса в начале сообщения
+ */
+#define ID_PREFIX "@"
+
+/*!
+ * \brief Наибольшая длина префикса "@id "
+ */
+#define ID_PREFIX_SIZE 22
+
+/*!
+ * \brief Запрос статистики сервера
+ */
+#define STATS_REQUEST "stats"
+
+/*!
+ * \brief Запрос проверки сервера
+ */
+#define PING_REQUEST "ping"
+
+/*!
+ * \brief Ответ на запрос проверки сервера
+ */
+#define PONG_REPLY "pong\n"
+
+/*!
+ * \brief Ответ на запрос, отклонённый ограничением частоты запросов
+ */
+#define BUSY_REPLY "Сервер занят.\n"
+
+/*!
+ * \brief Тип запроса
+ */
+typedef enum
+{
+    REQUEST_SOLVE, /*!< Решение и разложение на множители */
+    REQUEST_CERT,  /*!< Гарантированные границы корней */
+    REQUEST_STATS, /*!< Статистика сервера */
+    REQUEST_PING,  /*!< Проверка сервера */
+    REQUEST_SWEEP, /*!< Решение уравнений вдоль пути */
+    REQUEST_GRID,  /*!< Решение уравнений на сетке коэффициентов */
+    REQUEST_EVAL   /*!< Значения многочлена в точках */
+} RequestType;
+
+/*!
+ * \brief Разобранный запрос клиента
+ */
+typedef struct
+{
+    RequestType type; /*!< Тип запроса */
+    double a;         /*!< Первый коэффициент */
+    double b;         /*!< Второй коэффициент */
+    double c;         /*!< Третий коэффициент */
+    double d;         /*!< Четвёртый коэффициент (0 для квадратного) */
+    uint64_t id;      /*!< Номер запроса (0 - без номера) */
+    double to[4];     /*!< Коэффициенты конца пути (REQUEST_SWEEP,
+                           REQUEST_GRID; начало - a, b, c, d) */
+    int points;       /*!< Количество точек пути (REQUEST_SWEEP) или точек
+                           вычисления (REQUEST_EVAL) */
+    double step[4];   /*!< Шаги сетки по коэффициентам (REQUEST_GRID) */
+    long firstChunk;  /*!< Первый запрошенный блок сетки */
+    long lastChunk;   /*!< Последний запрошенный блок сетки */
+    double x[EVAL_MAX_VALUES]; /*!< Точки вычисления (REQUEST_EVAL;
+                                    многочлен - a x^3 + b x^2 + c x + d) */
+    int derivatives;  /*!< Количество производных (REQUEST_EVAL) */
+    unsigned evalFlags; /*!< EVAL_COMPENSATED и EVAL_FMA (REQUEST_EVAL) */
+} Request;
+
+/*!
+ * \brief Разбирает префикс "@id " запроса или ответа
+ * \param[in] buffer Сообщение, завершённое нулевым символом
+ * \param[in] length Длина сообщения без нулевого символа
+ * \param[out] id Номер (0, если префикса нет)
+ * \return Длина префикса вместе с пробелом или 0, если префикса нет
+ */
+size_t decodeRequestId(const char* buffer, size_t length, uint64_t* id);
+
+/*!
+ * \brief Разбирает запрос прямо в приёмном буфере без копирования строки
+ * \param[in] buffer Приёмный буфер, завершённый нулевым символом
+ * \param[in] length Длина сообщения без нулевого символа
+ * \param[out] request Разобранный запрос
+ * \return 0 при успехе, -1 при неверном формате
+ */
+int decodeRequest(const char* buffer, size_t length, Request* request);
+
+/*!
+ * \brief Вычисляет размеры сетки запроса REQUEST_GRID
+ *
+ * Точки сетки по коэффициенту k - from + i * step[k], i = 0, ..., n - 1,
+ * не дальше to[k]. Номер уравнения сетки ((ia * nb + ib) * nc + ic) * nd
+ * + id: быстрее всего меняется d.
+ * \param[in] request Запрос
+ * \param[out] counts Количество точек по каждому коэффициенту
+ * \return Количество уравнений сетки или -1, если шаги не соответствуют
+ * диапазонам или уравнений больше GRID_MAX_POINTS
+ */
+long gridPoints(const Request* request, long counts[4]);
+
+/*!
+ * \brief Записывает запрос в буфер отправки (с префиксом "@id ", если
+ * номер не равен 0)
+ * \param[out] buffer Буфер отправки
+ * \param[in] size Размер буфера
+ * \param[in] request Запрос
+ * \return Длина сообщения или -1, если буфер слишком мал
+ */
+int encodeRequest(char* buffer, size_t size, const Request* request);
+
+#endif //INC_6_LAB_PROTOCOL_H
@@ -0,0 +1,141 @@
+/*! Функции кэша ответов */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "replycache.h"
+
+#define REPLY_WAYS 4 // записей в наборе, среди которых ищется ответ
+
+// Функция для вычисления номера набора по адресу клиента и номеру запроса
+static size_t replyHash(const ReplyCache* cache,
+                        const SocketAddress* address, uint64_t id)
+{
+    uint64_t h = id * 0x9E3779B97F4A7C15ull;
+    h ^= addressHash(address);
+    h *= 0xBF58476D1CE4E5B9ull;
+    return (size_t) (h ^ (h >> 31)) & cache->mask;
+}
+
+// Функция для поиска записи запроса в наборе
+static CachedReply* findEntry(ReplyCache* cache,
+                              const SocketAddress* address, uint64_t id)
+{
+    CachedReply* set = &cache->entries[replyHash(cache, address, id) *
+                                       REPLY_WAYS];
+    for (int i = 0; i < REPLY_WAYS; i++)
+    {
+        if (set[i].id == id && addressEqual(&set[i].address, address))
+        {
+            return &set[i];
+        }
+    }
+    return NULL;
+}
+
+// Функция для выбора вытесняемой записи набора: свободная или самая
+// старая, причём выполненные запросы вытесняются раньше ожидающих
+static CachedReply* victimEntry(ReplyCache* cache,
+                                const SocketAddress* address,
+                                uint64_t id, uint64_t now)
+{
+    CachedReply* set = &cache->entries[replyHash(cache, address, id) *
+                                       REPLY_WAYS];
+    CachedReply* victim = &set[0];
+    for (int i = 0; i < REPLY_WAYS; i++)
+    {
+        CachedReply* entry = &set[i];
+        if (entry->id == 0 || entry->stored + cache->ttlMs <= now)
+        {
+            return entry;
+        }
+        int pending = entry->length == -1;
+        int victimPending = victim->length == -1;
+        if (pending < victimPending ||
+            (pending == victimPending && entry->stored < victim->stored))
+        {
+            victim = entry;
+        }
+    }
+    return victim;
+}
+
+// Функция для выделения записей кэша
+int replyCacheInit(ReplyCache* cache, size_t slots, uint64_t ttlMs)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->entries = calloc(slots, sizeof(CachedReply));
+    if (cache->entries == NULL || slots < REPLY_WAYS)
+    {
+        free(cache->entries);
+        return -1;
+    }
+    cache->mask = slots / REPLY_WAYS - 1;
+    cache->ttlMs = ttlMs;
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+// Функция для поиска ответа на запрос
+ReplyLookup replyCacheLookup(ReplyCache* cache,
+                             const SocketAddress* address, uint64_t id,
+                             uint64_t now, char* out, int* length)
+{
+    ReplyLookup result = REPLY_NEW;
+
+    pthread_mutex_lock(&cache->lock);
+    CachedReply* entry = findEntry(cache, address, id);
+    // Ответ может быть сохранён позже момента now, взятого при приёме,
+    // поэтому время не вычитается
+    if (entry != NULL && entry->stored + cache->ttlMs > now)
+    {
+        if (entry->length == -1)
+        {
+            result = REPLY_PENDING;
+        }
+        else
+        {
+            memcpy(out, entry->data, entry->length);
+            *length = entry->length;
+            result = REPLY_CACHED;
+        }
+    }
+    else
+    {
+        // Новый запрос занимает запись, вытесняя прежнюю
+        if (entry == NULL)
+        {
+            entry = victimEntry(cache, address, id, now);
+        }
+        entry->address = *address;
+        entry->id = id;
+        entry->stored = now;
+        entry->length = -1;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return result;
+}
+
+// Функция для сохранения ответа
+void replyCacheStore(ReplyCache* cache, const SocketAddress* address,
+                     uint64_t id, uint64_t now, const char* reply,
+                     int length)
+{
+    pthread_mutex_lock(&cache->lock);
+    CachedReply* entry = findEntry(cache, address, id);
+    if (entry != NULL && length <= MAXBUF)
+    {
+        memcpy(entry->data, reply, length);
+        entry->length = length;
+        entry->stored = now;
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Функция для освобождения записей кэша
+void replyCacheDestroy(ReplyCache* cache)
+{
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->entries);
+    cache->entries = NULL;
+}
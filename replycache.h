@@ -0,0 +1,107 @@
+/*!
+ * \file replycache.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение кэша ответов обработчика.
+ * Ответ на запрос с номером хранится недолго под ключом (адрес клиента,
+ * номер): повторная отправка того же запроса получает сохранённый ответ
+ * сразу после приёма, без разбора и решения. Пока запрос выполняется,
+ * его запись отмечена как ожидающая, и повторы просто отбрасываются.
+ *
+ * Кэш наборно-ассоциативный: новый запрос вытесняет самую старую запись
+ * своего набора, причём выполненные запросы вытесняются раньше
+ * ожидающих. Все записи выделяются при создании кэша.
+*/
+
+#ifndef INC_6_LAB_REPLYCACHE_H
+#define INC_6_LAB_REPLYCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "address.h"
+#include "protocol.h"
+
+/*!
+ * \brief Итог поиска в кэше ответов
+ */
+typedef enum
+{
+    REPLY_NEW,     /*!< Запрос новый: для него заведена ожидающая запись */
+    REPLY_PENDING, /*!< Запрос ещё выполняется: повтор можно отбросить */
+    REPLY_CACHED   /*!< Ответ скопирован из кэша */
+} ReplyLookup;
+
+/*!
+ * \brief Запись кэша ответов
+ */
+typedef struct
+{
+    SocketAddress address; /*!< Адрес клиента */
+    uint64_t id;           /*!< Номер запроса (0 - запись свободна) */
+    uint64_t stored;       /*!< Время создания записи, мс */
+    int length;            /*!< Длина ответа (-1 - запрос выполняется) */
+    char data[MAXBUF];     /*!< Ответ */
+} CachedReply;
+
+/*!
+ * \brief Кэш ответов обработчика
+ *
+ * Ищет записи обработчик-владелец при приёме, а сохраняет ответ тот
+ * обработчик, который выполнил задачу (он мог перехватить её у владельца),
+ * поэтому обращения защищены мьютексом.
+ */
+typedef struct
+{
+    CachedReply* entries;   /*!< Записи */
+    size_t mask;            /*!< Количество наборов минус один */
+    uint64_t ttlMs;         /*!< Время жизни ответа, мс */
+    pthread_mutex_t lock;   /*!< Защита записей */
+} ReplyCache;
+
+/*!
+ * \brief Выделяет записи кэша
+ * \param[out] cache Кэш
+ * \param[in] slots Количество записей (степень двойки)
+ * \param[in] ttlMs Время жизни ответа, мс
+ * \return 0 при успехе, -1 при ошибке
+ */
+int replyCacheInit(ReplyCache* cache, size_t slots, uint64_t ttlMs);
+
+/*!
+ * \brief Ищет ответ на запрос; для нового запроса заводит ожидающую
+ * запись
+ * \param[in] cache Кэш
+ * \param[in] address Адрес клиента
+ * \param[in] id Номер запроса (не 0)
+ * \param[in] now Текущее время, мс
+ * \param[out] out Буфер для ответа размером не меньше MAXBUF
+ * \param[out] length Длина скопированного ответа
+ * \return REPLY_NEW, REPLY_PENDING или REPLY_CACHED
+ */
+ReplyLookup replyCacheLookup(ReplyCache* cache,
+                             const SocketAddress* address, uint64_t id,
+                             uint64_t now, char* out, int* length);
+
+/*!
+ * \brief Сохраняет ответ в ожидающую запись запроса
+ *
+ * Если запись уже вытеснена другим запросом, ответ не сохраняется.
+ * \param[in] cache Кэш
+ * \param[in] address Адрес клиента
+ * \param[in] id Номер запроса
+ * \param[in] now Текущее время, мс
+ * \param[in] reply Ответ
+ * \param[in] length Длина ответа
+ */
+void replyCacheStore(ReplyCache* cache, const SocketAddress* address,
+                     uint64_t id, uint64_t now, const char* reply,
+                     int length);
+
+/*!
+ * \brief Освобождает записи кэша
+ * \param[in] cache Кэш
+ */
+void replyCacheDestroy(ReplyCache* cache);
+
+#endif //INC_6_LAB_REPLYCACHE_H
@@ -0,0 +1,189 @@
+/*! Функции перезапуска сервера с передачей сокетов */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "restart.h"
+#include "interface.h"
+
+#define READY_TIMEOUT_MS 10000 // ожидание готовности нового сервера
+
+// Канал к предыдущему серверу в новом процессе
+static int handoffFd = -1;
+
+// Функция для отправки дескрипторов по сокету домена UNIX
+static int sendFds(int channel, const int* fds, int count)
+{
+    char control[CMSG_SPACE(sizeof(int) * MAX_WORKERS)];
+    memset(control, 0, sizeof(control));
+    // Вместе с дескрипторами передаём их количество
+    struct iovec iov = {&count, sizeof(count)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+
+    if (sendmsg(channel, &msg, 0) == -1)
+    {
+        perror("sendmsg");
+        return -1;
+    }
+    return 0;
+}
+
+// Функция для запуска нового сервера
+int restartSpawn(char* argv[], const int* fds, int count)
+{
+    if (count < 1 || count > MAX_WORKERS)
+    {
+        return -1;
+    }
+    int pair[2];
+    // Путь к исполняемому файлу: при запуске через /proc/self/exe
+    // процесс получил бы имя "exe"
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length == -1)
+    {
+        perror("readlink");
+        return -1;
+    }
+    path[length] = '\0';
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) == -1)
+    {
+        perror("socketpair");
+        return -1;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+        perror("fork");
+        close(pair[0]);
+        close(pair[1]);
+        return -1;
+    }
+    if (pid == 0)
+    {
+        // Новый процесс: оставляем ему только свой конец канала и
+        // снимаем блокировку сигналов, унаследованную от старого
+        char value[16];
+        snprintf(value, sizeof(value), "%d", pair[1]);
+        fcntl(pair[1], F_SETFD, 0);
+        setenv(HANDOFF_ENV, value, 1);
+        sigset_t set;
+        sigemptyset(&set);
+        sigprocmask(SIG_SETMASK, &set, NULL);
+        execv(path, argv);
+        perror("execv");
+        _exit(127);
+    }
+
+    close(pair[1]);
+    int result = -1;
+    if (sendFds(pair[0], fds, count) == 0)
+    {
+        // Ждём от нового сервера байт готовности; закрытие канала
+        // означает, что он не запустился
+        struct pollfd pfd = {pair[0], POLLIN, 0};
+        char ready;
+        int polled;
+        while ((polled = poll(&pfd, 1, READY_TIMEOUT_MS)) == -1 &&
+               errno == EINTR)
+        {
+        }
+        if (polled == 1 && read(pair[0], &ready, 1) == 1)
+        {
+            result = 0;
+        }
+    }
+    close(pair[0]);
+
+    if (result == -1)
+    {
+        fprintf(stderr, "Новый сервер не сообщил о готовности.\n");
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    return result;
+}
+
+// Функция для приёма сокетов от предыдущего сервера
+int restartReceive(int* fds, int max)
+{
+    const char* value = getenv(HANDOFF_ENV);
+    if (value == NULL)
+    {
+        return 0;
+    }
+    handoffFd = atoi(value);
+    unsetenv(HANDOFF_ENV);
+    fcntl(handoffFd, F_SETFD, FD_CLOEXEC);
+
+    int count = 0;
+    char control[CMSG_SPACE(sizeof(int) * MAX_WORKERS)];
+    struct iovec iov = {&count, sizeof(count)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(handoffFd, &msg, MSG_CMSG_CLOEXEC) <= 0)
+    {
+        perror("recvmsg");
+        return -1;
+    }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS)
+    {
+        fprintf(stderr, "Предыдущий сервер не передал сокеты.\n");
+        return -1;
+    }
+    int received = (int) ((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+    if (received != count || count > max)
+    {
+        fprintf(stderr, "Передано неверное количество сокетов.\n");
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * count);
+    return count;
+}
+
+// Функция для уведомления предыдущего сервера о готовности
+void restartReady(void)
+{
+    if (handoffFd == -1)
+    {
+        return;
+    }
+    char ready = 1;
+    if (write(handoffFd, &ready, 1) == -1)
+    {
+        perror("write");
+    }
+    close(handoffFd);
+    handoffFd = -1;
+}
@@ -0,0 +1,48 @@
+/*!
+ * \file restart.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение функций перезапуска сервера
+ * без потери запросов. Работающий сервер запускает новую версию своей
+ * программы и передаёт ей привязанные сокеты обработчиков через сокет
+ * домена UNIX (SCM_RIGHTS). Датаграммы, ещё не прочитанные из этих
+ * сокетов, достаются новому серверу, а старый отвечает на уже принятые
+ * запросы и завершается.
+*/
+
+#ifndef INC_6_LAB_RESTART_H
+#define INC_6_LAB_RESTART_H
+
+/*!
+ * \brief Имя переменной окружения с дескриптором канала передачи сокетов
+ */
+#define HANDOFF_ENV "SERVER_HANDOFF_FD"
+
+/*!
+ * \brief Запускает новый сервер и передаёт ему сокеты
+ *
+ * Новый процесс запускается из того же исполняемого файла с теми же
+ * аргументами. Функция возвращает управление, когда новый сервер
+ * сообщил о готовности принимать запросы, либо при ошибке.
+ * \param[in] argv Аргументы командной строки сервера
+ * \param[in] fds Дескрипторы сокетов обработчиков
+ * \param[in] count Количество дескрипторов
+ * \return 0, если новый сервер готов, -1 при ошибке
+ */
+int restartSpawn(char* argv[], const int* fds, int count);
+
+/*!
+ * \brief Принимает сокеты от предыдущего сервера
+ * \param[out] fds Массив для дескрипторов сокетов
+ * \param[in] max Размер массива
+ * \return Количество принятых сокетов; 0, если сервер запущен не
+ * перезапуском; -1 при ошибке
+ */
+int restartReceive(int* fds, int max);
+
+/*!
+ * \brief Сообщает предыдущему серверу, что новый готов принимать запросы
+ */
+void restartReady(void);
+
+#endif //INC_6_LAB_RESTART_H
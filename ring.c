@@ -0,0 +1,117 @@
+/*! Функции кольца согласованного хеширования */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ring.h"
+
+#define KEY_MANTISSA_BITS 30 // значащих бит коэффициента в ключе
+
+// Функция для перемешивания битов (финализатор splitmix64)
+static uint64_t mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+// Функция для сравнения точек кольца по положению
+static int comparePoints(const void* x, const void* y)
+{
+    const RingPoint* p = x;
+    const RingPoint* q = y;
+    if (p->hash != q->hash)
+    {
+        return p->hash < q->hash ? -1 : 1;
+    }
+    return p->server - q->server;
+}
+
+// Функция для добавления сервера на кольцо
+int ringAdd(HashRing* ring, const SocketAddress* server)
+{
+    if (ring->count == RING_MAX_SERVERS)
+    {
+        return -1;
+    }
+    int index = ring->count++;
+    ring->servers[index] = *server;
+    ring->healthy[index] = 1;
+
+    // Точки сервера - хеши его адреса с номерами точек
+    uint64_t base = addressHash(server);
+    for (int i = 0; i < RING_REPLICAS; i++)
+    {
+        RingPoint* point = &ring->points[ring->pointCount++];
+        point->hash = mix(base + (uint64_t) i * 0x9E3779B97F4A7C15ull);
+        point->server = index;
+    }
+    qsort(ring->points, ring->pointCount, sizeof(RingPoint), comparePoints);
+    return index;
+}
+
+// Функция для выбора сервера для ключа
+int ringLookup(const HashRing* ring, uint64_t key)
+{
+    if (ring->count == 0)
+    {
+        return -1;
+    }
+    // Первая точка не меньше ключа (за последней - снова первая)
+    int low = 0;
+    int high = ring->pointCount;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (ring->points[middle].hash < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    int start = low == ring->pointCount ? 0 : low;
+
+    // Отказавший сервер пропускаем: его запросы достаются следующим
+    // по кольцу серверам
+    for (int i = 0; i < ring->pointCount; i++)
+    {
+        int server = ring->points[(start + i) % ring->pointCount].server;
+        if (ring->healthy[server])
+        {
+            return server;
+        }
+    }
+    return ring->points[start].server;
+}
+
+// Функция для огрубления коэффициента: близкие после деления значения
+// (например, 1/3 и 0.333333333) дают одно и то же число
+static uint64_t quantize(double value)
+{
+    if (value == 0 || !isfinite(value))
+    {
+        // -0 и 0 совпадают, бесконечности и NaN сводятся к одному ключу
+        return value == 0 ? 0 : 1;
+    }
+    int exponent;
+    double mantissa = frexp(value, &exponent);
+    long long bits = llrint(ldexp(mantissa, KEY_MANTISSA_BITS));
+    return ((uint64_t) bits << 16) ^ (uint64_t) (exponent & 0xFFFF);
+}
+
+// Функция для вычисления ключа запроса
+uint64_t ringKey(const Request* request)
+{
+    double scale = request->a != 0 ? request->a : 1;
+    uint64_t h = mix((uint64_t) request->type + 1);
+    h = mix(h ^ quantize(request->b / scale));
+    h = mix(h ^ quantize(request->c / scale));
+    h = mix(h ^ quantize(request->d / scale));
+    return h;
+}
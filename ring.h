@@ -0,0 +1,84 @@
+/*!
+ * \file ring.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение кольца согласованного
+ * хеширования, по которому клиент распределяет запросы между серверами.
+ * Каждый сервер занимает на кольце несколько точек; запрос достаётся
+ * первому работающему серверу по часовой стрелке от хеша его уравнения.
+ * Поэтому одно и то же уравнение всегда решает один сервер, а при отказе
+ * сервера на другие переходят только его запросы.
+*/
+
+#ifndef INC_6_LAB_RING_H
+#define INC_6_LAB_RING_H
+
+#include <stdint.h>
+
+#include "address.h"
+#include "protocol.h"
+
+/*!
+ * \brief Наибольшее количество серверов на кольце
+ */
+#define RING_MAX_SERVERS 16
+
+/*!
+ * \brief Точек кольца на один сервер
+ */
+#define RING_REPLICAS 64
+
+/*!
+ * \brief Точка кольца
+ */
+typedef struct
+{
+    uint64_t hash; /*!< Положение точки на кольце */
+    int server;    /*!< Номер сервера */
+} RingPoint;
+
+/*!
+ * \brief Кольцо согласованного хеширования
+ */
+typedef struct
+{
+    SocketAddress servers[RING_MAX_SERVERS]; /*!< Адреса серверов */
+    int healthy[RING_MAX_SERVERS];  /*!< 1, если сервер отвечает */
+    int count;                      /*!< Количество серверов */
+    RingPoint points[RING_MAX_SERVERS * RING_REPLICAS]; /*!< Точки кольца
+                                         в порядке возрастания хеша */
+    int pointCount;                 /*!< Количество точек */
+} HashRing;
+
+/*!
+ * \brief Добавляет сервер на кольцо
+ *
+ * Положение точек зависит только от адреса сервера, поэтому клиенты
+ * с одним списком серверов, заданным в любом порядке, распределяют
+ * запросы одинаково.
+ * \param[in,out] ring Кольцо
+ * \param[in] server Адрес сервера
+ * \return Номер сервера или -1, если кольцо заполнено
+ */
+int ringAdd(HashRing* ring, const SocketAddress* server);
+
+/*!
+ * \brief Выбирает сервер для ключа
+ * \param[in] ring Кольцо
+ * \param[in] key Ключ запроса
+ * \return Первый работающий сервер от ключа по часовой стрелке; если
+ * не работает ни один, - сервер, которому ключ принадлежит
+ */
+int ringLookup(const HashRing* ring, uint64_t key);
+
+/*!
+ * \brief Вычисляет ключ запроса по нормированным коэффициентам
+ *
+ * Коэффициенты делятся на старший, поэтому пропорциональные уравнения
+ * (x^2 - 3x + 2 и 2x^2 - 6x + 4) получают один ключ.
+ * \param[in] request Запрос
+ * \return Ключ
+ */
+uint64_t ringKey(const Request* request);
+
+#endif //INC_6_LAB_RING_H
@@ -0,0 +1,341 @@
+/*! Функции постоянного кэша корней */
+
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rootcache.h"
+
+#define KEY_LIMIT 0x1p240 // наибольший модуль коэффициента: произведения
+                          // трёх коэффициентов в ComputeCubic остаются
+                          // нормализованными числами и после умножения
+                          // на степень двойки
+
+// Функция для проверки заголовка файла размером size
+static int checkHeader(const RootCacheHeader* header, size_t size)
+{
+    uint64_t sets = header->sets;
+    if (memcmp(header->magic, ROOTCACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ROOTCACHE_VERSION ||
+        header->entrySize != sizeof(RootCacheEntry) || sets == 0 ||
+        (sets & (sets - 1)) != 0 || size < ROOTCACHE_HEADER_SIZE ||
+        (size - ROOTCACHE_HEADER_SIZE) / sizeof(RootCacheEntry) /
+            ROOTCACHE_WAYS != sets ||
+        (size - ROOTCACHE_HEADER_SIZE) % (sizeof(RootCacheEntry) *
+                                          ROOTCACHE_WAYS) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+// Функция для приведения коэффициентов к ключу: умножение на 2^k, после
+// которого 1 <= |a| < 2. Возвращает -1, если уравнение не кэшируется
+static int makeKey(const double coef[4], double key[4])
+{
+    if (coef[0] == 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        double magnitude = fabs(coef[i]);
+        if (!isfinite(coef[i]) || (magnitude != 0 &&
+            (magnitude < 1 / KEY_LIMIT || magnitude > KEY_LIMIT)))
+        {
+            return -1;
+        }
+    }
+    // Множитель 2^(1023 - e), где e - смещённый показатель a, собирается
+    // из битов: умножение на него точное, так как все коэффициенты и
+    // множитель не выходят за KEY_LIMIT
+    uint64_t bits;
+    memcpy(&bits, &coef[0], sizeof(bits));
+    uint64_t exponent = (bits >> 52) & 0x7FF;
+    bits = (2046 - exponent) << 52;
+    double scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    for (int i = 0; i < 4; i++)
+    {
+        key[i] = coef[i] * scale;
+    }
+    return 0;
+}
+
+// Функция для вычисления набора по ключу
+static RootCacheEntry* findSet(const RootCache* cache, const double key[4])
+{
+    uint64_t h = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t bits;
+        memcpy(&bits, &key[i], sizeof(bits));
+        h = (h ^ bits) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 32;
+    }
+    h *= 0xBF58476D1CE4E5B9ull;
+    size_t set = (size_t) (h ^ (h >> 31)) & cache->mask;
+    return &cache->entries[set * ROOTCACHE_WAYS];
+}
+
+// Функция для чтения часов вытеснения: за один такт в кэш сохраняется
+// примерно по одной записи на набор
+static uint16_t clockNow(const RootCache* cache)
+{
+    uint64_t insertions = atomic_load_explicit(&cache->header->insertions,
+                                               memory_order_relaxed);
+    return (uint16_t) (insertions / (cache->mask + 1));
+}
+
+// Функция для отметки обращения к записи. Запись меняется, только если
+// показание часов другое, чтобы частые попадания не гоняли строку кэша
+// процессора между ядрами
+static void touchEntry(RootCacheEntry* entry, uint16_t now)
+{
+    if (atomic_load_explicit(&entry->stamp, memory_order_relaxed) != now)
+    {
+        atomic_store_explicit(&entry->stamp, now, memory_order_relaxed);
+    }
+}
+
+// Функция для открытия файла кэша
+int rootCacheOpen(RootCache* cache, const char* path, size_t entries)
+{
+    size_t sets = 1;
+    while (sets * 2 * ROOTCACHE_WAYS <= entries)
+    {
+        sets *= 2;
+    }
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        return -1;
+    }
+
+    // Исключительную блокировку получает только первый процесс: он один
+    // может пересоздать файл и очистить недописанные записи
+    int alone = flock(fd, LOCK_EX | LOCK_NB) == 0;
+    if (!alone && (errno != EWOULDBLOCK || flock(fd, LOCK_SH) == -1))
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    struct stat st;
+    RootCacheHeader header;
+    if (fstat(fd, &st) == -1 ||
+        pread(fd, &header, sizeof(header), 0) == -1)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    size_t size = (size_t) st.st_size;
+    int valid = size >= sizeof(header) && checkHeader(&header, size) == 0;
+    if (!valid && !alone)
+    {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    if (!valid)
+    {
+        // Файл нового размера заполнен нулями: все записи пусты
+        size = ROOTCACHE_HEADER_SIZE +
+               sets * ROOTCACHE_WAYS * sizeof(RootCacheEntry);
+        if (ftruncate(fd, 0) == -1 || ftruncate(fd, (off_t) size) == -1)
+        {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return -1;
+        }
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    cache->header = base;
+    cache->entries = (RootCacheEntry*) ((char*) base + ROOTCACHE_HEADER_SIZE);
+    cache->size = size;
+    cache->fd = fd;
+    if (!valid)
+    {
+        memcpy(cache->header->magic, ROOTCACHE_MAGIC,
+               sizeof(cache->header->magic));
+        cache->header->version = ROOTCACHE_VERSION;
+        cache->header->entrySize = sizeof(RootCacheEntry);
+        cache->header->sets = sets;
+    }
+    cache->mask = cache->header->sets - 1;
+
+    if (alone)
+    {
+        // Нечётная версия осталась от процесса, завершившегося посреди
+        // записи: такая запись считается пустой
+        size_t count = (cache->mask + 1) * ROOTCACHE_WAYS;
+        for (size_t i = 0; i < count; i++)
+        {
+            RootCacheEntry* entry = &cache->entries[i];
+            if (atomic_load_explicit(&entry->sequence,
+                                     memory_order_relaxed) & 1)
+            {
+                atomic_store_explicit(&entry->sequence, 0,
+                                      memory_order_relaxed);
+            }
+        }
+        if (flock(fd, LOCK_SH) == -1)
+        {
+            int error = errno;
+            rootCacheClose(cache);
+            errno = error;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Функция для поиска решения уравнения в кэше
+int rootCacheLookup(RootCache* cache, const double coef[4],
+                    EquationResult* result)
+{
+    double key[4];
+    if (makeKey(coef, key) == -1)
+    {
+        return -1;
+    }
+    RootCacheEntry* set = findSet(cache, key);
+    for (int i = 0; i < ROOTCACHE_WAYS; i++)
+    {
+        RootCacheEntry* entry = &set[i];
+        uint32_t sequence = atomic_load_explicit(&entry->sequence,
+                                                 memory_order_acquire);
+        if (sequence == 0 || (sequence & 1) != 0)
+        {
+            continue;
+        }
+        // Поля копируются, а затем версия проверяется снова: если запись
+        // за это время изменилась, копия может быть смесью двух записей
+        double stored[4];
+        double roots[3];
+        memcpy(stored, entry->key, sizeof(stored));
+        memcpy(roots, entry->roots, sizeof(roots));
+        int rootCase = entry->rootCase;
+        int count = entry->count;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&entry->sequence,
+                                 memory_order_relaxed) != sequence ||
+            memcmp(stored, key, sizeof(key)) != 0)
+        {
+            continue;
+        }
+        // Запись из повреждённого файла не должна выводить лишние корни
+        int degree = key[3] == 0 ? 2 : 3;
+        if (rootCase < ROOTS_NONE || rootCase > ROOTS_THREE || count < 0 ||
+            count > 3 || (degree == 2) != (rootCase <= ROOTS_TWO))
+        {
+            return 0;
+        }
+        result->degree = degree;
+        result->rootCase = (RootCase) rootCase;
+        result->count = count;
+        memcpy(result->roots, roots, sizeof(roots));
+        touchEntry(entry, clockNow(cache));
+        return 1;
+    }
+    return 0;
+}
+
+// Функция для сохранения решения уравнения
+void rootCacheStore(RootCache* cache, const double coef[4],
+                    const EquationResult* result)
+{
+    double key[4];
+    if (makeKey(coef, key) == -1)
+    {
+        return;
+    }
+    RootCacheEntry* set = findSet(cache, key);
+    uint16_t now = clockNow(cache);
+
+    // Вытесняется пустая запись или та, к которой дольше всего не
+    // обращались; записи, которые сейчас пишут, пропускаются
+    RootCacheEntry* victim = NULL;
+    uint32_t victimSequence = 0;
+    int victimAge = -1;
+    for (int i = 0; i < ROOTCACHE_WAYS; i++)
+    {
+        RootCacheEntry* entry = &set[i];
+        uint32_t sequence = atomic_load_explicit(&entry->sequence,
+                                                 memory_order_acquire);
+        if ((sequence & 1) != 0)
+        {
+            continue;
+        }
+        if (sequence == 0)
+        {
+            victim = entry;
+            victimSequence = 0;
+            break;
+        }
+        // Уравнение уже сохранил другой обработчик
+        if (memcmp(entry->key, key, sizeof(key)) == 0)
+        {
+            touchEntry(entry, now);
+            return;
+        }
+        int age = (uint16_t) (now - atomic_load_explicit(
+                                  &entry->stamp, memory_order_relaxed));
+        if (age > victimAge)
+        {
+            victim = entry;
+            victimSequence = sequence;
+            victimAge = age;
+        }
+    }
+    // Запись занимает тот, кто первым сделал её версию нечётной
+    if (victim == NULL ||
+        !atomic_compare_exchange_strong_explicit(
+            &victim->sequence, &victimSequence, victimSequence + 1,
+            memory_order_relaxed, memory_order_relaxed))
+    {
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+    memcpy(victim->key, key, sizeof(key));
+    memcpy(victim->roots, result->roots, sizeof(victim->roots));
+    victim->rootCase = (int8_t) result->rootCase;
+    victim->count = (int8_t) result->count;
+    atomic_store_explicit(&victim->stamp, now, memory_order_relaxed);
+    // Версия 0 означает пустую запись, поэтому при переполнении
+    // счётчик начинается заново с 2
+    uint32_t next = victimSequence + 2;
+    atomic_store_explicit(&victim->sequence, next != 0 ? next : 2,
+                          memory_order_release);
+    atomic_fetch_add_explicit(&cache->header->insertions, 1,
+                              memory_order_relaxed);
+}
+
+// Функция для закрытия файла кэша
+int rootCacheClose(RootCache* cache)
+{
+    int result = munmap(cache->header, cache->size);
+    if (close(cache->fd) == -1)
+    {
+        result = -1;
+    }
+    cache->header = NULL;
+    cache->entries = NULL;
+    return result;
+}
@@ -0,0 +1,145 @@
+/*!
+ * \file rootcache.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение постоянного кэша корней.
+ * Кэш - хеш-таблица в файле, отображённом в память (MAP_SHARED): её
+ * используют одновременно все обработчики сервера (потоки и процессы),
+ * а после перезапуска новый сервер открывает тот же файл и сразу
+ * отвечает на частые уравнения без решения.
+ *
+ * Ключ - коэффициенты, умноженные на степень двойки так, чтобы
+ * 1 <= |a| < 2: такое умножение не меняет ни корней, ни результата
+ * ComputeQuadratic и ComputeCubic (все промежуточные значения делятся
+ * на ту же степень двойки без округления), поэтому уравнения, которые
+ * отличаются общим множителем 2^k, делят одну запись, а ответ из кэша
+ * совпадает с решённым заново до бита. Уравнения, для которых это не
+ * гарантируется (a = 0, не конечные или слишком большие и малые по
+ * модулю коэффициенты), кэш не хранит.
+ *
+ * Таблица наборно-ассоциативная с приближённым вытеснением давно не
+ * использованных записей. Записи читаются без блокировок: у каждой есть
+ * счётчик версии (seqlock), нечётный на время записи; читатель, который
+ * застал запись или увидел, что версия изменилась, считает это промахом.
+*/
+
+#ifndef INC_6_LAB_ROOTCACHE_H
+#define INC_6_LAB_ROOTCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "logic.h"
+
+/*!
+ * \brief Подпись файла кэша корней
+ */
+#define ROOTCACHE_MAGIC "ROOTCACH"
+
+/*!
+ * \brief Версия формата файла
+ */
+#define ROOTCACHE_VERSION 1
+
+/*!
+ * \brief Размер заголовка файла: записи начинаются с новой страницы
+ */
+#define ROOTCACHE_HEADER_SIZE 4096
+
+/*!
+ * \brief Записей в наборе, среди которых ищется уравнение
+ */
+#define ROOTCACHE_WAYS 8
+
+/*!
+ * \brief Заголовок файла кэша
+ */
+typedef struct
+{
+    char magic[8];                  /*!< ROOTCACHE_MAGIC */
+    uint32_t version;               /*!< ROOTCACHE_VERSION */
+    uint32_t entrySize;             /*!< sizeof(RootCacheEntry) */
+    uint64_t sets;                  /*!< Количество наборов (степень
+                                         двойки) */
+    _Atomic uint64_t insertions;    /*!< Записей, сохранённых за всё время
+                                         (по ним идут часы вытеснения) */
+} RootCacheHeader;
+
+/*!
+ * \brief Запись кэша: ровно одна строка кэша процессора
+ */
+typedef struct
+{
+    _Atomic uint32_t sequence; /*!< Версия: нечётная во время записи,
+                                    0 - запись пуста */
+    _Atomic uint16_t stamp;    /*!< Показание часов при последнем
+                                    обращении */
+    int8_t rootCase;           /*!< Случай расположения корней */
+    int8_t count;              /*!< Количество действительных корней */
+    double key[4];             /*!< Приведённые коэффициенты a, b, c, d */
+    double roots[3];           /*!< Действительные корни */
+} RootCacheEntry;
+
+/*!
+ * \brief Кэш корней, отображённый в память
+ */
+typedef struct
+{
+    RootCacheHeader* header; /*!< Начало отображения */
+    RootCacheEntry* entries; /*!< Записи */
+    size_t mask;             /*!< Количество наборов минус один */
+    size_t size;             /*!< Размер отображения */
+    int fd;                  /*!< Открытый файл (держит блокировку flock) */
+} RootCache;
+
+/*!
+ * \brief Открывает файл кэша, при необходимости создавая его
+ *
+ * Первый открывший файл процесс (единственный, кто получил
+ * исключительную блокировку flock) проверяет заголовок: файл другого
+ * формата или с повреждённым заголовком создаётся заново, а записи,
+ * которые остались недописанными после аварийного завершения, очищаются.
+ * Затем блокировка становится разделяемой, и файл могут открыть другие
+ * процессы. У существующего файла сохраняется его размер, даже если
+ * entries другой.
+ * \param[out] cache Кэш
+ * \param[in] path Имя файла
+ * \param[in] entries Количество записей нового файла (округляется вниз
+ * до степени двойки наборов, не меньше одного набора)
+ * \return 0 при успехе, -1 при ошибке (errno указывает причину; EINVAL -
+ * файл, открытый другим процессом, не в этом формате)
+ */
+int rootCacheOpen(RootCache* cache, const char* path, size_t entries);
+
+/*!
+ * \brief Ищет решение уравнения в кэше
+ * \param[in] cache Кэш
+ * \param[in] coef Коэффициенты a, b, c, d (d = 0 - квадратное уравнение)
+ * \param[out] result Решение (при попадании)
+ * \return 1 - решение найдено, 0 - промах, -1 - уравнение не кэшируется
+ */
+int rootCacheLookup(RootCache* cache, const double coef[4],
+                    EquationResult* result);
+
+/*!
+ * \brief Сохраняет решение уравнения, вытесняя самую давно
+ * использованную запись набора
+ *
+ * Если все записи набора в этот момент пишут другие обработчики или
+ * уравнение не кэшируется, решение не сохраняется.
+ * \param[in] cache Кэш
+ * \param[in] coef Коэффициенты a, b, c, d
+ * \param[in] result Решение, полученное ComputeQuadratic или ComputeCubic
+ */
+void rootCacheStore(RootCache* cache, const double coef[4],
+                    const EquationResult* result);
+
+/*!
+ * \brief Снимает отображение и закрывает файл кэша
+ * \param[in,out] cache Кэш
+ * \return 0 при успехе, -1 при ошибке
+ */
+int rootCacheClose(RootCache* cache);
+
+#endif //INC_6_LAB_ROOTCACHE_H
@@ -4,120 +4,633 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/signalfd.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
 
 #include "server.h"
-#include "logic.h"
 #include "interface.h"
+#include "address.h"
 #include "signals.h"
+#include "worker.h"
+#include "restart.h"
+#include "crash.h"
+#include "trace.h"
+#include "rootcache.h"
+#include "timerwheel.h"
 
-#define PORT 5555
-#define MAXBUF 1024
+#define DEFAULT_ROOT_CACHE_ENTRIES (1L << 20) // записей в новом кэше корней
+                                             // (64 МиБ)
+#define RESPAWN_DELAY_MS 1000 // наименьший промежуток между запусками
+                              // одного процесса-обработчика
 
-// Главная функция сервера
-int main(int argc, char* argv[])
+// Переменная для хранения дескриптора файла журнала
+extern FILE* logfd;
+
+// Всё, что нужно для запуска обработчиков в главном процессе или в
+// процессе-обработчике (опция -P)
+typedef struct
 {
-    int numbytes;
-    struct sockaddr_in servaddr, cliaddr;
-    char buffer[MAXBUF];
-    socklen_t len;
+    ServerOptions* options;         // параметры запуска
+    const SocketAddress* addresses; // адреса групп обработчиков
+    int processes;                  // процессов-обработчиков (не меньше 1)
+    int perProcess;                 // обработчиков в одном процессе
+    int total;                      // обработчиков во всех процессах
+    int fds[MAX_WORKERS];           // сокеты обработчиков по номерам
+                                    // (-1 - создаёт сам обработчик)
+    SharedStats* shared;            // счётчики в общей памяти
+    RootCache* roots;               // кэш корней (NULL - без кэша)
+    char** argv;                    // аргументы для перезапуска
+} ServerSetup;
 
-    char* logFile = NULL; // имя файла журнала
-    int timeout = 0; // время ожидания сообщений от клиента в секундах
+// Процесс-обработчик под надзором главного процесса
+typedef struct
+{
+    pid_t pid;          // 0 - процесс не работает
+    uint64_t started;   // время запуска, мс
+    uint64_t respawnAt; // время запуска вместо упавшего (0 - не нужен)
+} WorkerProcess;
 
-    // Разбираем аргументы командной строки
-    parseArgsServer(argc, argv, &logFile, &timeout);
+// Функция для ожидания сигналов управления сервером. Возвращает режим
+// остановки обработчиков
+static int waitForSignals(int sigfd, char* argv[], Worker* workers, int count,
+                          int child)
+{
+    while (1)
+    {
+        // Между сигналами записи обработчиков выводятся из буфера журнала
+        // не реже раза в LOG_FLUSH_MS: иначе при SIGKILL они пропали бы
+        struct pollfd fds = {sigfd, POLLIN, 0};
+        int ready = poll(&fds, 1, LOG_FLUSH_MS);
+        flushLog();
+        if (ready == -1 && errno != EINTR)
+        {
+            perror("poll");
+            exit(1);
+        }
+        struct signalfd_siginfo info;
+        if (ready <= 0 || read(sigfd, &info, sizeof(info)) != sizeof(info))
+        {
+            continue;
+        }
+        switch (info.ssi_signo)
+        {
+            case SIGHUP:
+            {
+                // Процесс-обработчик получает SIGHUP от главного процесса,
+                // когда сокеты уже переданы новому серверу
+                if (child)
+                {
+                    return WORKER_HANDOFF;
+                }
+                // Перезапуск: новый сервер получает сокеты обработчиков
+                printf("Перезапуск сервера.\n");
+                writeLog("%s\n", "Перезапуск сервера.");
+                int fds[MAX_WORKERS];
+                for (int i = 0; i < count; i++)
+                {
+                    fds[i] = workers[i].sockfd;
+                }
+                if (restartSpawn(argv, fds, count) == 0)
+                {
+                    writeLog("%s\n", "Новый сервер готов, завершаем работу.");
+                    return WORKER_HANDOFF;
+                }
+                // Новый сервер не запустился: продолжаем работу
+                writeLog("%s\n", "Не удалось перезапустить сервер.");
+                break;
+            }
+            case SIGUSR1:
+            {
+                // Выводим трассу обработки запросов
+                char path[64];
+                snprintf(path, sizeof(path), "trace-%ld.json",
+                         (long) getpid());
+                int events = traceDump(path);
+                if (events == -1)
+                {
+                    fprintf(stderr, "Трасса не записана: сервер собран "
+                                    "без --enable-trace.\n");
+                    break;
+                }
+                printf("Трасса записана в %s (событий: %d).\n", path, events);
+                writeLog("Трасса записана в %s (событий: %d).\n", path,
+                         events);
+                break;
+            }
+            case SIGINT:
+                printf("Программа прервана пользователем.\n");
+                writeLog("%s\n", "Программа прервана пользователем.");
+                return WORKER_DRAIN;
+            default:
+                printf("Программа завершена системой.\n");
+                writeLog("%s\n", "Программа завершена системой.");
+                return WORKER_DRAIN;
+        }
+    }
+}
 
-    int sockfd = -1; // дескриптор сокета
 
-    char* logFileName = "server.log";
+// Функция для блокировки сигналов управления и создания signalfd для них.
+// Блокировка наследуется потоками-обработчиками; главный процесс с
+// опцией -P получает ещё и SIGCHLD о завершении процессов-обработчиков
+static int openSignalFd(int supervisor)
+{
+    sigset_t controlSignals;
+    sigemptyset(&controlSignals);
+    sigaddset(&controlSignals, SIGINT);
+    sigaddset(&controlSignals, SIGTERM);
+    sigaddset(&controlSignals, SIGHUP);
+    sigaddset(&controlSignals, SIGUSR1);
+    if (supervisor)
+    {
+        sigaddset(&controlSignals, SIGCHLD);
+    }
+    pthread_sigmask(SIG_BLOCK, &controlSignals, NULL);
+    int sigfd = signalfd(-1, &controlSignals, SFD_CLOEXEC);
+    if (sigfd == -1)
+    {
+        perror("signalfd");
+        exit(1);
+    }
+    return sigfd;
+}
 
-    // Открываем файл журнала
-    openLog(&logFile, logFileName);
+// Функция для вычисления номера обработчика по номеру процесса и номеру
+// обработчика в процессе. Сокеты одного адреса идут подряд, поэтому при
+// перезапуске с другим числом процессов сокет не попадёт в чужую группу
+static int workerIndex(const ServerSetup* setup, int process, int local)
+{
+    int workers = setup->options->workers;
+    return local / workers * workers * setup->processes +
+           process * workers + local % workers;
+}
 
-    // Создаем сокет
-    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    // Проверяем на ошибки
-    if (sockfd == -1)
+// Функция для вывода адресов, на которых слушает сервер
+static void printListening(const ServerSetup* setup)
+{
+    const ServerOptions* options = setup->options;
+    for (int i = 0; i < options->hostCount; i++)
     {
-        perror("socket");
-        exit(1);
+        char address[ADDRESS_TEXT_SIZE];
+        addressFormat(&setup->addresses[i], address, sizeof(address));
+        if (options->processes > 0)
+        {
+            printf("Сервер слушает на %s (процессов: %d, обработчиков в "
+                   "процессе: %d)\n", address, options->processes,
+                   options->workers);
+            writeLog("Сервер слушает на %s (процессов: %d, обработчиков в "
+                     "процессе: %d)\n", address, options->processes,
+                     options->workers);
+            continue;
+        }
+        printf("Сервер слушает на %s (обработчиков: %d)\n", address,
+               options->workers);
+        writeLog("Сервер слушает на %s (обработчиков: %d)\n", address,
+                 options->workers);
+    }
+}
+
+// Функция для работы обработчиков одного процесса до сигнала остановки.
+// child - 1 в процессе-обработчике, 0 в единственном процессе сервера
+static void runWorkers(ServerSetup* setup, int process, int sigfd, int child)
+{
+    // Создаём обработчики; без опции -N их сокеты и пулы создаются здесь
+    static Worker workers[MAX_WORKERS];
+    ServerOptions* options = setup->options;
+    int count = setup->perProcess;
+    pthread_barrier_t ready;
+    pthread_barrier_init(&ready, NULL, count + 1);
+    for (int i = 0; i < count; i++)
+    {
+        Worker* worker = &workers[i];
+        int index = workerIndex(setup, process, i);
+        worker->id = index;
+        worker->cpu = options->cpuCount > 0 ?
+                      options->cpus[index % options->cpuCount] : -1;
+        worker->node = worker->cpu >= 0 ? cpuNumaNode(worker->cpu) : -1;
+        worker->address = setup->addresses[i / options->workers];
+        worker->options = options;
+        worker->roots = setup->roots;
+        worker->stats = &setup->shared->workers[index];
+        worker->shared = setup->shared;
+        worker->ready = &ready;
+        worker->peers = workers;
+        worker->peerCount = count;
+        worker->sockfd = setup->fds[index];
+        if (!options->numa)
+        {
+            workerPrepare(worker);
+        }
+        int error = pthread_create(&worker->thread, NULL, workerRun, worker);
+        if (error != 0)
+        {
+            fprintf(stderr, "pthread_create: %s\n", strerror(error));
+            exit(1);
+        }
     }
 
-    // Устанавливаем параметры сокета
-    servaddr.sin_family = AF_INET; // семейство адресов IPv4
-    servaddr.sin_addr.s_addr = inet_addr("127.0.0.1");
-    // автоматический выбор IP-адреса сервера
-    servaddr.sin_port = htons(PORT); // порт сервера
-    memset(servaddr.sin_zero, '\0', sizeof servaddr.sin_zero);
+    // Ждём, пока все обработчики привяжут свои сокеты, затем разрешаем
+    // им начать работу и перехватывать задачи друг у друга
+    pthread_barrier_wait(&ready);
+    pthread_barrier_wait(&ready);
 
-    // Привязываем сокет к адресу
-    if (bind(sockfd, (struct sockaddr *) &servaddr,
-            sizeof servaddr) == -1)
+    if (!child)
     {
-        perror("bind");
-        exit(1);
+        // Выводим информацию о сервере на экран и в файл журнала
+        printListening(setup);
+        // Предыдущий сервер может завершаться: новый уже принимает запросы
+        restartReady();
     }
 
-    // Выводим информацию о сервере на экран и в файл журнала
-    printf("Сервер слушает на %s:%d\n",
-           inet_ntoa(servaddr.sin_addr), ntohs(servaddr.sin_port));
-    writeLog("Сервер слушает на %s:%d\n",
-             inet_ntoa(servaddr.sin_addr), ntohs(servaddr.sin_port));
+    // Ждём сигнала, затем даём обработчикам ответить на принятые запросы
+    int mode = waitForSignals(sigfd, setup->argv, workers, count, child);
+    workerStop(workers, count, mode);
+    for (int i = 0; i < count; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+}
 
-    // Устанавливаем обработчики сигналов SIGINT, SIGTERM и SIGSEGV
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
-    signal(SIGSEGV, signalHandler);
+// Функция для запуска процесса-обработчика с номером process
+static void spawnProcess(ServerSetup* setup, WorkerProcess* children,
+                         int process, int sigfd)
+{
+    // Непустые буферы журнала и stdout иначе были бы выведены дважды
+    flushLog();
+    fflush(stdout);
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+        perror("fork");
+        children[process].respawnAt = monotonicMs() + RESPAWN_DELAY_MS;
+        return;
+    }
+    if (pid == 0)
+    {
+        // Процесс-обработчик получает SIGTERM, если главный процесс
+        // завершится, не остановив его (например, по SIGKILL)
+        close(sigfd);
+        if (prctl(PR_SET_PDEATHSIG, SIGTERM) == -1 || getppid() != parent)
+        {
+            exit(1);
+        }
+        // Отчёт о сбое должен указывать номер этого процесса
+        crashInit(fileno(logfd));
+        runWorkers(setup, process, openSignalFd(0), 1);
+        writeLog("Процесс-обработчик %d остановлен.\n", process);
+        closeLog();
+        exit(0);
+    }
+    children[process].pid = pid;
+    children[process].started = monotonicMs();
+    children[process].respawnAt = 0;
+    writeLog("Процесс-обработчик %d запущен (pid %ld).\n", process,
+             (long) pid);
+}
 
-    // Входим в бесконечный цикл обработки запросов от клиентов
+// Функция для отправки сигнала всем работающим процессам-обработчикам
+static void signalProcesses(const WorkerProcess* children, int count,
+                            int signo)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (children[i].pid != 0)
+        {
+            kill(children[i].pid, signo);
+        }
+    }
+}
+
+// Функция для учёта завершившихся процессов-обработчиков. Упавший процесс
+// (завершённый сигналом) запускается снова, если сервер не
+// останавливается. Возвращает код завершения процесса, который
+// завершился сам (и сервер должен остановиться), иначе -1
+static int reapProcesses(ServerSetup* setup, WorkerProcess* children,
+                         int stopping)
+{
+    int code = -1;
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        int process = -1;
+        for (int i = 0; i < setup->processes; i++)
+        {
+            if (children[i].pid == pid)
+            {
+                process = i;
+            }
+        }
+        // Не процесс-обработчик: например, сервер, не запустившийся при
+        // перезапуске
+        if (process == -1)
+        {
+            continue;
+        }
+        children[process].pid = 0;
+        if (stopping)
+        {
+            continue;
+        }
+        if (WIFSIGNALED(status))
+        {
+            // Процесс, упавший сразу после запуска, запускается снова не
+            // раньше чем через RESPAWN_DELAY_MS
+            printf("Процесс-обработчик %d завершён сигналом %d, "
+                   "запускаем заново.\n", process, WTERMSIG(status));
+            writeLog("Процесс-обработчик %d (pid %ld) завершён сигналом %d, "
+                     "запускаем заново.\n", process, (long) pid,
+                     WTERMSIG(status));
+            atomic_fetch_add(&setup->shared->restarts, 1);
+            uint64_t now = monotonicMs();
+            uint64_t earliest = children[process].started + RESPAWN_DELAY_MS;
+            children[process].respawnAt = earliest > now ? earliest : now;
+            continue;
+        }
+        // Процесс завершается сам только при ошибке запуска или по
+        // сроку ожидания запросов (опция -t): это касается всего сервера
+        code = WEXITSTATUS(status);
+        writeLog("Процесс-обработчик %d (pid %ld) завершился с кодом %d, "
+                 "останавливаем сервер.\n", process, (long) pid, code);
+    }
+    return code;
+}
+
+// Функция для ожидания завершения всех процессов-обработчиков
+static void waitProcesses(ServerSetup* setup, WorkerProcess* children,
+                          int sigfd)
+{
     while (1)
     {
-        // Устанавливаем таймер неактивности клиентской стороны
-        setTimer(timeout);
+        reapProcesses(setup, children, 1);
+        int running = 0;
+        for (int i = 0; i < setup->processes; i++)
+        {
+            running += children[i].pid != 0;
+        }
+        if (running == 0)
+        {
+            return;
+        }
+        // Остальные сигналы во время остановки не обрабатываются
+        struct signalfd_siginfo info;
+        if (read(sigfd, &info, sizeof(info)) == -1 && errno != EINTR)
+        {
+            perror("read(signalfd)");
+            exit(1);
+        }
+    }
+}
 
-        // Принимаем данные от клиента и запоминаем его адрес в cliaddr
-        len = sizeof(cliaddr); // длина адреса клиента
-        numbytes = recvfrom(sockfd, buffer, MAXBUF, 0, (struct sockaddr *) &cliaddr, &len);
-        // Проверяем на ошибки
+// Функция для надзора за процессами-обработчиками до сигнала остановки.
+// Возвращает код завершения сервера
+static int superviseProcesses(ServerSetup* setup, WorkerProcess* children,
+                              int sigfd)
+{
+    int count = setup->processes;
+    while (1)
+    {
+        // Запускаем упавшие процессы, срок перезапуска которых наступил
+        uint64_t now = monotonicMs();
+        int timeout = -1;
+        for (int i = 0; i < count; i++)
+        {
+            uint64_t respawnAt = children[i].respawnAt;
+            if (respawnAt != 0 && respawnAt <= now)
+            {
+                spawnProcess(setup, children, i, sigfd);
+            }
+            else if (respawnAt != 0 &&
+                     (timeout == -1 || respawnAt - now < (uint64_t) timeout))
+            {
+                timeout = (int) (respawnAt - now);
+            }
+        }
 
-        if (numbytes == -1)
+        // Буфер журнала выводится не реже раза в LOG_FLUSH_MS
+        if (timeout == -1 || timeout > LOG_FLUSH_MS)
         {
-            perror("recvfrom");
+            timeout = LOG_FLUSH_MS;
+        }
+        struct pollfd fds = {sigfd, POLLIN, 0};
+        int ready = poll(&fds, 1, timeout);
+        flushLog();
+        if (ready == -1 && errno != EINTR)
+        {
+            perror("poll");
             exit(1);
         }
-        buffer[numbytes] = '\0'; // добавляем нулевой символ в конец сообщения
-        // Выводим информацию о клиенте и его запросе на экран и в файл журнала
-        printf("Получен запрос от %s:%d\n",
-               inet_ntoa(cliaddr.sin_addr), ntohs(cliaddr.sin_port));
-        writeLog("Получен запрос от %s:%d\n",
-                 inet_ntoa(cliaddr.sin_addr), ntohs(cliaddr.sin_port));
-        printf("Пакет длиной %d байтов\n", numbytes);
-        writeLog("Пакет длиной %d байтов\n", numbytes);
-        printf("Пакет содержит \"%s\"\n", buffer);
-        writeLog("Пакет содержит \"%s\"\n", buffer);
+        struct signalfd_siginfo info;
+        if (ready <= 0 || read(sigfd, &info, sizeof(info)) != sizeof(info))
+        {
+            continue;
+        }
+        switch (info.ssi_signo)
+        {
+            case SIGCHLD:
+            {
+                int code = reapProcesses(setup, children, 0);
+                if (code != -1)
+                {
+                    signalProcesses(children, count, SIGTERM);
+                    waitProcesses(setup, children, sigfd);
+                    return code;
+                }
+                break;
+            }
+            case SIGHUP:
+                // Перезапуск: сокеты всех процессов получает новый сервер,
+                // а процессы-обработчики отвечают на принятые запросы
+                printf("Перезапуск сервера.\n");
+                writeLog("%s\n", "Перезапуск сервера.");
+                if (restartSpawn(setup->argv, setup->fds, setup->total) == 0)
+                {
+                    writeLog("%s\n", "Новый сервер готов, завершаем работу.");
+                    signalProcesses(children, count, SIGHUP);
+                    waitProcesses(setup, children, sigfd);
+                    return 0;
+                }
+                writeLog("%s\n", "Не удалось перезапустить сервер.");
+                break;
+            case SIGUSR1:
+                // Трассу записывает каждый процесс-обработчик в свой файл
+                signalProcesses(children, count, SIGUSR1);
+                break;
+            case SIGINT:
+                printf("Программа прервана пользователем.\n");
+                writeLog("%s\n", "Программа прервана пользователем.");
+                signalProcesses(children, count, SIGTERM);
+                waitProcesses(setup, children, sigfd);
+                return 0;
+            default:
+                printf("Программа завершена системой.\n");
+                writeLog("%s\n", "Программа завершена системой.");
+                signalProcesses(children, count, SIGTERM);
+                waitProcesses(setup, children, sigfd);
+                return 0;
+        }
+    }
+}
 
-        double a, b, c, d;
-        sscanf(buffer, "%lf %lf %lf %lf", &a, &b, &c, &d);
-        if (d == 0)
+// Главная функция сервера
+int main(int argc, char* argv[])
+{
+    SocketAddress addresses[MAX_LISTEN];
+    ServerOptions options;
+    memset(&options, 0, sizeof(options));
+
+    // Разбираем аргументы командной строки
+    parseArgsServer(argc, argv, &options);
+    if (options.hostCount == 0)
+    {
+        options.hosts[options.hostCount++] = DEFAULT_HOST;
+    }
+    if (options.port == 0)
+    {
+        options.port = DEFAULT_PORT;
+    }
+
+    // Разбираем адреса; на каждом из них слушает своя группа обработчиков
+    for (int i = 0; i < options.hostCount; i++)
+    {
+        if (addressParse(options.hosts[i], options.port,
+                         &addresses[i]) == -1)
         {
-            // квадратное уравнение
-            SolveQuadratic(a, b, c);
-            // решаем квадратное уравнение и выводим результаты
+            fprintf(stderr, "Неверный адрес: %s\n", options.hosts[i]);
+            exit(1);
         }
-        else if (d != 0)
+    }
+
+    // Обработчики выводят запросы в stdout через write(2) в обход stdio,
+    // поэтому сообщения главного потока не должны задерживаться в буфере
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // При перезапуске сокеты обработчиков приходят от предыдущего сервера
+    int inherited[MAX_WORKERS];
+    int inheritedCount = restartReceive(inherited, MAX_WORKERS);
+    if (inheritedCount == -1)
+    {
+        exit(1);
+    }
+    // Сокеты передаются по порядку адресов, поэтому группы обработчиков
+    // должны быть не меньше прежних
+    int groups = options.hostCount;
+    int processes = options.processes > 0 ? options.processes : 1;
+    if (inheritedCount > options.workers * groups * processes)
+    {
+        options.workers = (inheritedCount + groups * processes - 1) /
+                          (groups * processes);
+    }
+    // По умолчанию по одному обработчику на процессор из списка
+    if (options.workers == 0)
+    {
+        options.workers = options.cpuCount > 0 ? options.cpuCount : 1;
+    }
+    int total = options.workers * groups * processes;
+    if (total > MAX_WORKERS)
+    {
+        fprintf(stderr, "Всего обработчиков на всех адресах и во всех "
+                        "процессах должно быть не больше %d.\n", MAX_WORKERS);
+        exit(1);
+    }
+
+    char* logFileName = "server.log";
+
+    // Открываем файл журнала
+    openLog(&options.logFile, logFileName);
+    fcntl(fileno(logfd), F_SETFD, FD_CLOEXEC);
+
+    // При аварийном завершении отчёт выводится в stderr и в журнал
+    crashInit(fileno(logfd));
+
+    // Сигналы остановки, перезапуска и вывода трассы принимаются через
+    // signalfd в главном потоке
+    int sigfd = openSignalFd(options.processes > 0);
+
+    // Счётчики лежат в общей памяти: с опцией -P их видят все процессы
+    static ServerSetup setup;
+    setup.options = &options;
+    setup.addresses = addresses;
+    setup.processes = processes;
+    setup.perProcess = options.workers * groups;
+    setup.total = total;
+    setup.argv = argv;
+    setup.shared = workerSharedStats();
+    if (setup.shared == NULL)
+    {
+        perror("mmap");
+        exit(1);
+    }
+    setup.shared->count = total;
+    setup.shared->processes = options.processes;
+    for (int i = 0; i < total; i++)
+    {
+        setup.fds[i] = i < inheritedCount ? inherited[i] : -1;
+    }
+
+    // Кэш корней в файле общий для всех обработчиков; после перезапуска
+    // новый сервер открывает тот же файл и отвечает из него сразу
+    static RootCache roots;
+    if (options.rootCache != NULL)
+    {
+        long entries = options.rootCacheEntries > 0
+                       ? options.rootCacheEntries : DEFAULT_ROOT_CACHE_ENTRIES;
+        if (rootCacheOpen(&roots, options.rootCache, (size_t) entries) == -1)
         {
-            // кубическое уравнение
-            SolveCubic(a, b, c, d);
-            // решаем кубическое уравнение и выводим разложение на множители
+            perror(options.rootCache);
+            exit(1);
         }
-        else
+        writeLog("Кэш корней %s: записей %lu\n", options.rootCache,
+                 (unsigned long) (roots.mask + 1) * ROOTCACHE_WAYS);
+        setup.roots = &roots;
+    }
+
+    int code = 0;
+    if (options.processes == 0)
+    {
+        runWorkers(&setup, 0, sigfd, 0);
+    }
+    else
+    {
+        // Сокеты привязывает главный процесс: процесс, запущенный вместо
+        // упавшего, получает те же сокеты вместе с датаграммами, пришедшими
+        // в его отсутствие
+        for (int i = 0; i < total; i++)
+        {
+            if (setup.fds[i] == -1)
+            {
+                int cpu = options.cpuCount > 0
+                          ? options.cpus[i % options.cpuCount] : -1;
+                setup.fds[i] = workerBindSocket(
+                    &addresses[i / (options.workers * processes)], cpu);
+            }
+        }
+        static WorkerProcess children[MAX_WORKERS];
+        for (int i = 0; i < processes; i++)
         {
-            // неверный формат запроса
-            printf("Неверный формат запроса.\n");
-            writeLog("Неверный формат запроса.\n");
+            spawnProcess(&setup, children, i, sigfd);
         }
+        printListening(&setup);
+        restartReady();
+        code = superviseProcesses(&setup, children, sigfd);
+
+        char totals[512];
+        int length = workerFormatTotals(setup.shared, totals, sizeof(totals));
+        writeLog("%.*s", length, totals);
+    }
+
+    if (options.rootCache != NULL)
+    {
+        rootCacheClose(&roots);
     }
-}
\ No newline at end of file
+    writeLog("%s\n", "Сервер остановлен.");
+    fflush(stdout);
+    closeLog();
+    return code;
+}
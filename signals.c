@@ -8,8 +8,18 @@
 
 #include "signals.h"
 
+#define LOG_BUFFER_SIZE 65536 // буфер журнала
+#define LOG_RECORD_SIZE 4096 // наибольшая длина одной записи
+
 FILE* logfd; // имя файла журнала
 
+// Записи накапливаются в буфере и выводятся в файл только целиком:
+// в файл, открытый на дозапись, одновременно пишут старый и новый
+// сервер при перезапуске, и их записи не должны перемешиваться
+static char logBuffer[LOG_BUFFER_SIZE];
+static size_t logUsed;
+static int logDescriptor = -1; // дескриптор журнала для обработчика сбоя
+
 void signalHandler(int signum)
 {
     // Выводим сообщение об ошибке в зависимости от типа сигнала
@@ -23,10 +33,6 @@ void signalHandler(int signum)
             fprintf(stderr, "Программа завершена системой.\n");
             writeLog("%s\n", "Программа завершена системой.");
             break;
-        case SIGSEGV:
-            fprintf(stderr, "Программа вызвала ошибку сегментации.\n");
-            writeLog("%s\n", "Программа вызвала ошибку сегментации.");
-            break;
         default:
             fprintf(stderr, "Программа завершена неизвестным сигналом.\n");
             writeLog("%s\n", "Программа завершена неизвестным сигналом.");
@@ -36,7 +42,7 @@ void signalHandler(int signum)
     exit(1);
 }
 
-void timeoutHandler()
+void timeoutHandler(void)
 {
     // Выводим сообщение об ошибке
     fprintf(stderr, "Превышено время ожидания.\n");
@@ -61,48 +67,185 @@ void openLog(char** logFile, char* logFileName)
         perror("fopen");
         exit(1);
     }
+    logDescriptor = fileno(logfd);
+    // Накопленные записи выводятся и при выходе через exit
+    atexit(flushLog);
 }
 
-void writeLog(const char* format, ...)
+void flushLog(void)
 {
-    // Проверяем, что файл журнала открыт
     if (logfd == NULL)
     {
         return;
     }
+    flockfile(logfd);
+    size_t written = 0;
+    while (written < logUsed)
+    {
+        ssize_t result = write(fileno(logfd), logBuffer + written,
+                               logUsed - written);
+        if (result == -1)
+        {
+            break;
+        }
+        written += result;
+    }
+    logUsed = 0;
+    funlockfile(logfd);
+}
+
+void closeLog(void)
+{
+    flushLog();
+    if (logfd != NULL)
+    {
+        logDescriptor = -1;
+        fclose(logfd);
+        logfd = NULL;
+    }
+}
+
+void writePendingLog(void)
+{
+    // Блокировку файла взять нельзя: её может держать прерванный поток.
+    // logUsed увеличивается после копирования записи, поэтому
+    // выводятся только дописанные записи
+    size_t used = logUsed;
+    size_t written = 0;
+    while (logDescriptor != -1 && written < used)
+    {
+        ssize_t result = write(logDescriptor, logBuffer + written,
+                               used - written);
+        if (result <= 0)
+        {
+            break;
+        }
+        written += result;
+    }
+}
+
+// Записывает в record метку времени "[%Y-%m-%d %H:%M:%S] " и возвращает
+// её длину. Метка пересчитывается не чаще раза в секунду: localtime_r
+// и strftime дороже, чем разбор и решение самого запроса
+static size_t formatTimestamp(char* record)
+{
+    static __thread time_t cachedTime = -1;
+    static __thread char cachedStamp[64];
+    static __thread size_t cachedLength;
 
-    // Получаем текущее время и форматируем его в строку
     time_t t = time(NULL);
-    struct tm *tm = localtime(&t);
-    char time_str[20];
-    strftime(time_str, 20, "%Y-%m-%d %H:%M:%S", tm);
+    if (t != cachedTime)
+    {
+        // localtime_r, в отличие от localtime, не перечитывает часовой
+        // пояс (и не выделяет память) при каждом вызове
+        struct tm tm;
+        localtime_r(&t, &tm);
+        cachedLength = strftime(cachedStamp, sizeof(cachedStamp),
+                                "[%Y-%m-%d %H:%M:%S] ", &tm);
+        cachedTime = t;
+    }
+    memcpy(record, cachedStamp, cachedLength);
+    return cachedLength;
+}
+
+// Добавляет готовую запись в буфер журнала
+static void appendRecord(const char* record, size_t length)
+{
+    // Запись из нескольких потоков-обработчиков не должна перемешиваться:
+    // запись добавляется в буфер под блокировкой файла (она рекурсивна,
+    // поэтому flushLog можно вызвать, не снимая её)
+    flockfile(logfd);
+    if (logUsed + length > sizeof(logBuffer))
+    {
+        flushLog();
+    }
+    memcpy(logBuffer + logUsed, record, length);
+    logUsed += length;
+    funlockfile(logfd);
+}
 
-    // Выводим время в файл журнала
-    fprintf(logfd, "[%s] ", time_str);
+void writeLog(const char* format, ...)
+{
+    // Проверяем, что файл журнала открыт
+    if (logfd == NULL)
+    {
+        return;
+    }
+
+    // Получаем текущее время и форматируем его в строку.
+    char record[LOG_RECORD_SIZE];
+    size_t length = formatTimestamp(record);
 
     // Этот код позволяет записывать разные сообщения в файл журнала
     // с помощью одной функции write_log.
 
-    // Выводим сообщение в файл журнала с помощью переменного числа аргументов
+    // Выводим сообщение в запись журнала с помощью переменного числа
+    // аргументов
     va_list args;  // информация о списке аргументов.
     // Инициализировать переменную args с помощью макроса va_start, передав
     // ей последний известный параметр функции write_log. В данном случае,
     // это параметр format, который содержит формат сообщения.
     va_start(args, format);
-    // Первым параметром vfprintf является дескриптор файла журнала logfd,
-    // вторым - формат сообщения format, третьим - список аргументов args.
-    vfprintf(logfd, format, args);
+    // Первым параметром vsnprintf является буфер записи, вторым - его
+    // оставшийся размер, третьим - формат сообщения format, четвёртым -
+    // список аргументов args.
+    int written = vsnprintf(record + length, sizeof(record) - length, format,
+                            args);
     // Освобождаем ресурсы, связанные со списком аргументов args, с
     // помощью макроса va_end.
     va_end(args);
+    if (written < 0)
+    {
+        return;
+    }
+    length += written;
+    if (length >= sizeof(record))
+    {
+        // Слишком длинная запись обрезается
+        length = sizeof(record) - 1;
+        record[length - 1] = '\n';
+    }
+    appendRecord(record, length);
 }
 
-void setTimer(int timeout) {
-    // Проверяем, что время ожидания задано
-    if (timeout > 0) {
-        // Устанавливаем таймер с помощью alarm
-        alarm(timeout);
-        // Устанавливаем обработчик сигнала SIGALRM
-        signal(SIGALRM, timeoutHandler);
+void writeLogText(const char* text, size_t length)
+{
+    if (logfd == NULL || length == 0)
+    {
+        return;
     }
-}
\ No newline at end of file
+
+    // Каждая строка текста получает свою метку времени, как если бы
+    // она была записана отдельным вызовом writeLog
+    char record[LOG_RECORD_SIZE];
+    char stamp[64];
+    size_t stampLength = formatTimestamp(stamp);
+    size_t used = 0;
+    size_t position = 0;
+    while (position < length)
+    {
+        const char* line = text + position;
+        const char* newline = memchr(line, '\n', length - position);
+        size_t lineLength = newline != NULL ? (size_t) (newline - line) + 1
+                                            : length - position;
+        position += lineLength;
+        if (used + stampLength + lineLength > sizeof(record))
+        {
+            // Слишком длинная строка обрезается
+            if (used + stampLength + 1 > sizeof(record))
+            {
+                break;
+            }
+            lineLength = sizeof(record) - used - stampLength;
+        }
+        memcpy(record + used, stamp, stampLength);
+        used += stampLength;
+        memcpy(record + used, line, lineLength);
+        used += lineLength;
+    }
+    if (record[used - 1] != '\n')
+    {
+        record[used - 1] = '\n';
+    }
+    appendRecord(record, used);
+}
@@ -3,12 +3,20 @@
  * \brief Заголовочный файл с описанием функций
  *
  * Данный файл содержит в себе определение основных
- * функций, используемых для обработки сигналов и настройки таймера.
+ * функций, используемых для обработки сигналов и ведения журнала.
 */
 
 #ifndef INC_6_LAB_SIGNALS_H
 #define INC_6_LAB_SIGNALS_H
 
+#include <stddef.h>
+
+/*!
+ * \brief Наибольшее время, мс, которое запись может провести в буфере
+ * журнала: с таким периодом главный поток сервера выводит буфер в файл
+ */
+#define LOG_FLUSH_MS 1000
+
 /*!
  * \brief Функция для обработки сигналов, приводящих к завершению процесса
  * \param[in] signum Номер (тип) сигнала
@@ -16,9 +24,12 @@
 void signalHandler(int signum);
 
 /*!
- * \brief Функция для обработки таймера неактивности пользователя
+ * \brief Функция для завершения программы по истечении времени ожидания
+ *
+ * Вызывается из цикла обработки событий по таймеру колеса,
+ * а не из обработчика сигнала.
  */
-void timeoutHandler();
+void timeoutHandler(void);
 
 /*!
  * \brief Функция для открытия файла журнала для записи или создания его
@@ -28,16 +39,39 @@ void timeoutHandler();
 void openLog(char** logFile, char* logFileName);
 
 /*!
- * \brief  Функция для записи сообщений в файл журнала с помощью fprintf
+ * \brief Функция для вывода накопленных записей в файл журнала
+ */
+void flushLog(void);
+
+/*!
+ * \brief Функция для вывода накопленных записей и закрытия файла журнала
+ */
+void closeLog(void);
+
+/*!
+ * \brief Функция для вывода накопленных записей из обработчика сигнала
+ *
+ * Использует только write(2) и не берёт блокировку файла, поэтому
+ * допустима в обработчике аварийного сигнала: записи, сделанные до
+ * сбоя, не теряются вместе с буфером.
+ */
+void writePendingLog(void);
+
+/*!
+ * \brief  Функция для записи сообщений в файл журнала
  * \param[in] format Формат сообщения
  * \param[in] ... Остальные параметры
  */
 void writeLog(const char* format, ...);
 
 /*!
- * \brief  Функция для установки таймера неактивности пользователя
- * \param[in] timeout Время ожидания
+ * \brief Функция для записи готового текста в файл журнала без printf
+ *
+ * Текст может состоять из нескольких строк: каждая получает метку
+ * времени, а весь текст попадает в журнал одной записью.
+ * \param[in] text Текст
+ * \param[in] length Длина текста
  */
-void setTimer(int timeout);
+void writeLogText(const char* text, size_t length);
 
 #endif //INC_6_LAB_SIGNALS_H
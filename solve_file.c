@@ -0,0 +1,688 @@
+/*! Пакетный решатель уравнений из файла */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <libgen.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "solve_file.h"
+#include "logic.h"
+#include "format.h"
+#include "protocol.h"
+#include "eqfile.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 20) // буфер вывода одного потока
+#define LINE_TEXT_SIZE 1024 // строка результата: три корня по %.17f
+#define MAX_THREADS 256
+#define MIN_PART_SIZE (1 << 20) // меньшие части не стоят отдельного потока
+#define COEF_SIZE (4 * sizeof(double)) // уравнение в двоичном файле
+#define DEFAULT_PRECISION 6
+
+// Формат выходного файла
+typedef enum
+{
+    OUTPUT_TEXT,   // по строке "количество корни..." на уравнение
+    OUTPUT_BINARY, // записи SolvedRecord
+    OUTPUT_COEF,   // коэффициенты в двоичном виде (преобразование входа)
+    OUTPUT_COLUMNS // столбцовый файл уравнений с результатами (eqfile.h)
+} OutputFormat;
+
+// Часть входного файла и всё, что нужно потоку для её решения
+typedef struct
+{
+    const char* begin;      // начало части
+    const char* end;        // конец части
+    int binaryInput;        // часть - коэффициенты в двоичном виде
+    const EquationBatch* columns; // столбцовый входной файл или NULL
+    size_t first;           // первое уравнение части столбцового файла
+    size_t last;            // уравнение за последним
+    EquationBatch* output;  // столбцовый выходной файл или NULL
+    size_t index;           // следующая строка выходного файла
+    OutputFormat format;    // формат вывода
+    int precision;          // знаков после точки в текстовом выводе
+    int adaptive;           // повышать точность ненадёжных решений
+    int fast;               // решать кубические приближёнными функциями
+    int fd;                 // файл, в который пишет поток
+    char* buffer;           // буфер вывода
+    size_t used;            // занято в буфере
+    unsigned long solved;   // решено уравнений
+    unsigned long invalid;  // неверных уравнений
+    unsigned long escalated; // решено заново с повышенной точностью
+    int failed;             // ошибка записи
+    pthread_t thread;       // поток
+} Part;
+
+// Функция для получения монотонного времени в секундах
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Функция для записи всего буфера в файл
+static int writeAll(int fd, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        length -= (size_t) written;
+    }
+    return 0;
+}
+
+// Функция для сброса буфера вывода потока
+static void flushPart(Part* part)
+{
+    if (!part->failed && writeAll(part->fd, part->buffer, part->used) == -1)
+    {
+        perror("write");
+        part->failed = 1;
+    }
+    part->used = 0;
+}
+
+// Функция для вывода результата одного уравнения
+static void emitResult(Part* part, const double coef[4],
+                       const EquationResult* result, int valid)
+{
+    if (part->used + LINE_TEXT_SIZE > OUTPUT_BUFFER_SIZE)
+    {
+        flushPart(part);
+    }
+    char* out = part->buffer + part->used;
+
+    if (part->format == OUTPUT_COLUMNS)
+    {
+        // Корни столбцового файла находит ComputeBatch после разбора части
+        EquationBatch* output = part->output;
+        size_t i = part->index++;
+        output->a[i] = coef[0];
+        output->b[i] = coef[1];
+        output->c[i] = coef[2];
+        output->d[i] = coef[3];
+        output->degree[i] = !valid ? 0 : coef[3] == 0 ? 2 : 3;
+    }
+    else if (part->format == OUTPUT_COEF)
+    {
+        memcpy(out, coef, COEF_SIZE);
+        part->used += COEF_SIZE;
+    }
+    else if (part->format == OUTPUT_BINARY)
+    {
+        SolvedRecord record = {{0, 0, 0}, 0, -1};
+        if (valid)
+        {
+            memcpy(record.roots, result->roots,
+                   sizeof(double) * result->count);
+            record.rootCase = result->rootCase;
+            record.count = result->count;
+        }
+        memcpy(out, &record, sizeof(record));
+        part->used += sizeof(record);
+    }
+    else
+    {
+        // "2 2.500000 -1.000000" или "-" для неверного уравнения
+        TextBuffer text;
+        textInit(&text, out, LINE_TEXT_SIZE);
+        if (!valid)
+        {
+            textAppendLiteral(&text, "-");
+        }
+        else
+        {
+            textAppendInt(&text, result->count);
+            for (int i = 0; i < result->count; i++)
+            {
+                textAppendLiteral(&text, " ");
+                textAppendFixed(&text, result->roots[i], part->precision);
+            }
+        }
+        textAppendLiteral(&text, "\n");
+        part->used += text.length;
+    }
+}
+
+// Функция для решения одного уравнения (d = 0 - квадратное, как в запросах
+// сервера). Уравнение с нулевым старшим коэффициентом неверно
+static void solveOne(Part* part, const double coef[4], int valid)
+{
+    EquationResult result;
+    valid = valid && coef[0] != 0;
+    if (valid && part->format != OUTPUT_COEF &&
+        part->format != OUTPUT_COLUMNS)
+    {
+        if (part->adaptive)
+        {
+            part->escalated += ComputeAdaptive(coef[0], coef[1], coef[2],
+                                               coef[3], &result);
+        }
+        else if (coef[3] == 0)
+        {
+            ComputeQuadratic(coef[0], coef[1], coef[2], &result);
+        }
+        else if (part->fast)
+        {
+            ComputeCubicFast(coef[0], coef[1], coef[2], coef[3], &result);
+        }
+        else
+        {
+            ComputeCubic(coef[0], coef[1], coef[2], coef[3], &result);
+        }
+    }
+    if (valid)
+    {
+        part->solved++;
+    }
+    else
+    {
+        part->invalid++;
+    }
+    emitResult(part, coef, &result, valid);
+}
+
+// Поток: решает уравнения своей части входного файла
+static void* solvePart(void* arg)
+{
+    Part* part = arg;
+    size_t firstOutput = part->index;
+    double coef[4];
+
+    if (part->columns != NULL)
+    {
+        // Столбцовый файл: коэффициенты берутся из столбцов без разбора,
+        // у квадратного уравнения d не учитывается
+        const EquationBatch* in = part->columns;
+        for (size_t i = part->first; i < part->last; i++)
+        {
+            coef[0] = in->a[i];
+            coef[1] = in->b[i];
+            coef[2] = in->c[i];
+            coef[3] = in->degree[i] == 3 ? in->d[i] : 0;
+            solveOne(part, coef, in->degree[i] != 0);
+        }
+    }
+    else if (part->binaryInput)
+    {
+        for (const char* p = part->begin; p < part->end; p += COEF_SIZE)
+        {
+            memcpy(coef, p, COEF_SIZE);
+            solveOne(part, coef, 1);
+        }
+    }
+    else
+    {
+        // Строки разбираются прямо в отображении файла: за последней
+        // строкой без перевода строки стоит нулевая страница
+        const char* p = part->begin;
+        while (p < part->end)
+        {
+            const char* lineEnd = memchr(p, '\n', part->end - p);
+            if (lineEnd == NULL)
+            {
+                lineEnd = part->end;
+            }
+            Request request;
+            int valid = decodeRequest(p, lineEnd - p, &request) == 0 &&
+                        (request.type == REQUEST_SOLVE ||
+                         request.type == REQUEST_CERT);
+            coef[0] = valid ? request.a : 0;
+            coef[1] = valid ? request.b : 0;
+            coef[2] = valid ? request.c : 0;
+            coef[3] = valid ? request.d : 0;
+            solveOne(part, coef, valid);
+            p = lineEnd + 1;
+        }
+    }
+    if (part->output != NULL && part->adaptive)
+    {
+        part->escalated += ComputeBatchAdaptive(part->output, firstOutput,
+                                                part->index);
+    }
+    else if (part->output != NULL && part->fast)
+    {
+        ComputeBatchFast(part->output, firstOutput, part->index);
+    }
+    else if (part->output != NULL)
+    {
+        ComputeBatch(part->output, firstOutput, part->index);
+    }
+    flushPart(part);
+    return NULL;
+}
+
+// Функция для открытия временного файла рядом с выходным: оттуда его
+// содержимое копируется без выхода в пространство пользователя
+static int openTemporary(const char* output)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s", output);
+    char* dir = dirname(path);
+    int fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd != -1)
+    {
+        return fd;
+    }
+    // Файловая система без O_TMPFILE: создаём и сразу удаляем файл
+    char name[PATH_MAX];
+    snprintf(name, sizeof(name), "%s/.solve_file.XXXXXX", dir);
+    fd = mkstemp(name);
+    if (fd != -1)
+    {
+        unlink(name);
+    }
+    return fd;
+}
+
+// Функция для дописывания временного файла в конец выходного
+static int appendFile(int out, int in)
+{
+    if (lseek(in, 0, SEEK_SET) == -1)
+    {
+        return -1;
+    }
+    ssize_t copied;
+    while ((copied = copy_file_range(in, NULL, out, NULL, 1 << 30, 0)) > 0)
+    {
+    }
+    if (copied == 0)
+    {
+        return 0;
+    }
+    if (errno != EXDEV && errno != ENOSYS && errno != EINVAL &&
+        errno != EOPNOTSUPP)
+    {
+        return -1;
+    }
+    // Копирование в ядре недоступно: копируем через буфер
+    char buffer[1 << 16];
+    ssize_t length;
+    while ((length = read(in, buffer, sizeof(buffer))) > 0)
+    {
+        if (writeAll(out, buffer, (size_t) length) == -1)
+        {
+            return -1;
+        }
+    }
+    return length == 0 ? 0 : -1;
+}
+
+// Функция для отображения входного файла в память. За текстовым файлом
+// оставляется нулевая страница: разбор последней строки без перевода
+// строки не выйдет за отображение
+static const char* mapInput(int fd, size_t size, int binaryInput,
+                            size_t* mappedSize)
+{
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    *mappedSize = binaryInput ? size : (size + page) / page * page;
+    char* base = mmap(NULL, *mappedSize, PROT_READ,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+    if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) ==
+        MAP_FAILED)
+    {
+        munmap(base, *mappedSize);
+        return NULL;
+    }
+    // Потоки читают свои части от начала до конца
+    madvise(base, size, MADV_SEQUENTIAL);
+    return base;
+}
+
+// Функция для деления входного файла на части по границам уравнений
+static int splitInput(Part* parts, int count, const char* data, size_t size,
+                      int binaryInput)
+{
+    size_t records = size / COEF_SIZE;
+    const char* end = data + size;
+    const char* previous = data;
+    for (int i = 0; i < count; i++)
+    {
+        const char* next = end;
+        if (i + 1 < count && binaryInput)
+        {
+            next = data + records * (i + 1) / count * COEF_SIZE;
+        }
+        else if (i + 1 < count)
+        {
+            // Граница переносится за ближайший перевод строки
+            next = data + size * (i + 1) / count;
+            if (next < previous)
+            {
+                next = previous;
+            }
+            const char* newline = memchr(next, '\n', end - next);
+            next = newline == NULL ? end : newline + 1;
+        }
+        parts[i].begin = previous;
+        parts[i].end = next;
+        previous = next;
+    }
+    return count;
+}
+
+// Функция для деления столбцового файла на части по номерам уравнений
+static void splitColumns(Part* parts, int count, const EquationBatch* columns)
+{
+    for (int i = 0; i < count; i++)
+    {
+        parts[i].columns = columns;
+        parts[i].first = columns->count * i / count;
+        parts[i].last = columns->count * (i + 1) / count;
+    }
+}
+
+// Функция для подсчёта уравнений части (так же, как их перебирает
+// solvePart): нужна, чтобы заранее знать строки столбцового вывода
+static size_t countEquations(const Part* part)
+{
+    if (part->columns != NULL)
+    {
+        return part->last - part->first;
+    }
+    if (part->binaryInput)
+    {
+        return (size_t) (part->end - part->begin) / COEF_SIZE;
+    }
+    size_t lines = 0;
+    const char* p = part->begin;
+    while (p < part->end)
+    {
+        const char* lineEnd = memchr(p, '\n', part->end - p);
+        lines++;
+        if (lineEnd == NULL)
+        {
+            break;
+        }
+        p = lineEnd + 1;
+    }
+    return lines;
+}
+
+int main(int argc, char* argv[])
+{
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int binaryInput = 0;
+    int precision = DEFAULT_PRECISION;
+    int adaptive = 0;
+    int fast = 0;
+    OutputFormat format = OUTPUT_TEXT;
+    int usage = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:bO:p:aF")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j': // количество потоков
+                threads = atol(optarg);
+                break;
+            case 'b': // двоичный входной файл
+                binaryInput = 1;
+                break;
+            case 'O': // формат выходного файла
+                if (strcmp(optarg, "text") == 0)
+                {
+                    format = OUTPUT_TEXT;
+                }
+                else if (strcmp(optarg, "binary") == 0)
+                {
+                    format = OUTPUT_BINARY;
+                }
+                else if (strcmp(optarg, "coef") == 0)
+                {
+                    format = OUTPUT_COEF;
+                }
+                else if (strcmp(optarg, "columns") == 0)
+                {
+                    format = OUTPUT_COLUMNS;
+                }
+                else
+                {
+                    fprintf(stderr, "Формат вывода должен быть text, "
+                                    "binary, coef или columns.\n");
+                    return 1;
+                }
+                break;
+            case 'p': // знаков после точки
+                precision = atoi(optarg);
+                break;
+            case 'a': // повышение точности ненадёжных решений
+                adaptive = 1;
+                break;
+            case 'F': // приближённые функции в кубических уравнениях
+                fast = 1;
+                break;
+            default:
+                usage = 1;
+                break;
+        }
+    }
+    if (usage || optind + 2 != argc || threads < 1 || threads > MAX_THREADS ||
+        precision < 0 || precision > 17 || (adaptive && fast))
+    {
+        fprintf(stderr, "Использование: %s [-j threads] [-b] "
+                        "[-O text|binary|coef|columns] [-p precision] "
+                        "[-a | -F] input output\n", argv[0]);
+        return 1;
+    }
+    const char* inputName = argv[optind];
+    const char* outputName = argv[optind + 1];
+
+    int in = open(inputName, O_RDONLY | O_CLOEXEC);
+    if (in == -1)
+    {
+        perror(inputName);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(in, &st) == -1)
+    {
+        perror("fstat");
+        return 1;
+    }
+    size_t size = (size_t) st.st_size;
+
+    // Столбцовый файл узнаётся по подписи, опция -b для него не нужна
+    EquationFile columns;
+    int columnar = 0;
+    char magic[sizeof(EQFILE_MAGIC) - 1];
+    if (pread(in, magic, sizeof(magic), 0) == (ssize_t) sizeof(magic) &&
+        memcmp(magic, EQFILE_MAGIC, sizeof(magic)) == 0)
+    {
+        if (eqfileOpen(inputName, 0, &columns) == -1)
+        {
+            perror(inputName);
+            return 1;
+        }
+        long damaged = eqfileVerify(&columns);
+        if (damaged != -1)
+        {
+            fprintf(stderr, "Файл %s повреждён: не совпадает контрольная "
+                            "сумма блока %ld.\n", inputName, damaged);
+            return 1;
+        }
+        columnar = 1;
+    }
+    else if (binaryInput && size % COEF_SIZE != 0)
+    {
+        fprintf(stderr, "Размер двоичного файла %s не кратен %zu байтам.\n",
+                inputName, COEF_SIZE);
+        return 1;
+    }
+
+    int out = -1;
+    if (format != OUTPUT_COLUMNS)
+    {
+        out = open(outputName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0644);
+        if (out == -1)
+        {
+            perror(outputName);
+            return 1;
+        }
+    }
+
+    size_t mappedSize = 0;
+    const char* data = NULL;
+    if (!columnar && size > 0)
+    {
+        data = mapInput(in, size, binaryInput, &mappedSize);
+        if (data == NULL)
+        {
+            perror("mmap");
+            return 1;
+        }
+    }
+
+    // Мелкий файл не делится на части меньше MIN_PART_SIZE
+    int count = (int) threads;
+    if ((size_t) count > size / MIN_PART_SIZE)
+    {
+        count = size / MIN_PART_SIZE > 0 ? (int) (size / MIN_PART_SIZE) : 1;
+    }
+    static Part parts[MAX_THREADS];
+    if (columnar)
+    {
+        splitColumns(parts, count, &columns.batch);
+    }
+    else
+    {
+        splitInput(parts, count, data, size, binaryInput);
+    }
+
+    double start = nowSeconds();
+    EquationFile output;
+    if (format == OUTPUT_COLUMNS)
+    {
+        // Строки выходного файла распределяются между частями заранее
+        size_t total = 0;
+        for (int i = 0; i < count; i++)
+        {
+            parts[i].index = total;
+            total += countEquations(&parts[i]);
+        }
+        if (eqfileCreate(outputName, total, EQFILE_RESULTS | EQFILE_CHECKSUM,
+                         &output) == -1)
+        {
+            perror(outputName);
+            return 1;
+        }
+    }
+    for (int i = 0; i < count; i++)
+    {
+        Part* part = &parts[i];
+        part->binaryInput = binaryInput;
+        part->format = format;
+        part->precision = precision;
+        part->adaptive = adaptive;
+        part->fast = fast;
+        if (format == OUTPUT_COLUMNS)
+        {
+            // Потоки пишут прямо в отображение выходного файла
+            part->output = &output.batch;
+            part->fd = -1;
+        }
+        else
+        {
+            // Первая часть пишется прямо в выходной файл, остальные -
+            // во временные
+            part->fd = i == 0 ? out : openTemporary(outputName);
+            part->buffer = malloc(OUTPUT_BUFFER_SIZE);
+            if (part->fd == -1 || part->buffer == NULL)
+            {
+                perror("openTemporary");
+                return 1;
+            }
+        }
+        int error = pthread_create(&part->thread, NULL, solvePart, part);
+        if (error != 0)
+        {
+            fprintf(stderr, "pthread_create: %s\n", strerror(error));
+            return 1;
+        }
+    }
+
+    unsigned long solved = 0;
+    unsigned long invalid = 0;
+    unsigned long escalated = 0;
+    int failed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        Part* part = &parts[i];
+        pthread_join(part->thread, NULL);
+        if (i > 0 && part->fd != -1)
+        {
+            if (!failed && appendFile(out, part->fd) == -1)
+            {
+                perror("copy_file_range");
+                failed = 1;
+            }
+            close(part->fd);
+        }
+        failed |= part->failed;
+        solved += part->solved;
+        invalid += part->invalid;
+        escalated += part->escalated;
+        free(part->buffer);
+    }
+    if (format == OUTPUT_COLUMNS)
+    {
+        eqfileSeal(&output);
+        if (eqfileClose(&output) == -1)
+        {
+            perror("munmap");
+            failed = 1;
+        }
+    }
+    else if (close(out) == -1)
+    {
+        perror("close");
+        failed = 1;
+    }
+    double elapsed = nowSeconds() - start;
+    if (columnar)
+    {
+        eqfileClose(&columns);
+    }
+    else if (data != NULL)
+    {
+        munmap((void*) data, mappedSize);
+    }
+    close(in);
+
+    printf("Уравнений: %lu (неверных: %lu), потоков: %d, время: %.3f с, "
+           "%.1f МБ/с, %.0f уравнений/с\n", solved + invalid, invalid,
+           count, elapsed, size / elapsed / 1e6,
+           (solved + invalid) / elapsed);
+    if (adaptive)
+    {
+        printf("Решено заново с повышенной точностью: %lu "
+               "(%.3f%% решённых)\n",
+               escalated, solved > 0 ? 100.0 * escalated / solved : 0.0);
+    }
+    return failed;
+}
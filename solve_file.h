@@ -0,0 +1,39 @@
+/*!
+ * \file solve_file.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение основной функции пакетного
+ * решателя уравнений из файла без участия сервера. Входной файл
+ * (текстовый, по уравнению "a b c [d]" в строке, двоичный, по четыре
+ * числа double на уравнение, или столбцовый, eqfile.h) отображается
+ * в память и делится на части по числу потоков. Каждый поток решает свою
+ * часть и пишет результаты через свой буфер во временный файл; в конце
+ * временные файлы по порядку дописываются в выходной, поэтому порядок
+ * результатов совпадает с порядком уравнений. Столбцовый выходной файл
+ * потоки заполняют прямо в отображении, каждый со своей строки.
+*/
+
+#ifndef INC_6_LAB_SOLVE_FILE_H
+#define INC_6_LAB_SOLVE_FILE_H
+
+#include <stdint.h>
+
+/*!
+ * \brief Запись двоичного файла результатов
+ */
+typedef struct
+{
+    double roots[3];  /*!< Действительные корни */
+    int32_t rootCase; /*!< Случай расположения корней (RootCase) */
+    int32_t count;    /*!< Количество корней (-1 - неверное уравнение) */
+} SolvedRecord;
+
+/*!
+ * \brief Решает уравнения из файла и записывает результаты в файл
+ * \param[in] argc Количество аргументов командной строки
+ * \param[in] argv Массив указателей на строки, содержащие аргументы
+ * \return Код завершения
+ */
+int main(int argc, char* argv[]);
+
+#endif //INC_6_LAB_SOLVE_FILE_H
@@ -0,0 +1,191 @@
+/*! Тест выделений памяти при обработке запросов */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+#include "test_alloc.h"
+#include "worker.h"
+#include "protocol.h"
+
+#define TEST_WORKERS 2 // обработчиков, перехватывающих задачи друг у друга
+#define WARMUP_REQUESTS 2000 // запросов до начала подсчёта
+#define MEASURED_REQUESTS 20000 // запросов, при которых считаются выделения
+#define REPLY_TIMEOUT_MS 2000 // ожидание ответа, мс
+
+// Функции glibc, которые вызывают подменённые malloc, calloc и realloc
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+static atomic_ulong allocations; // вызовов malloc, calloc и realloc
+
+// Запросы всех видов, на которые сервер отвечает одной датаграммой
+static const char* requests[] = {
+        "1 -3 2",
+        "1 2 1",
+        "1 0 1",
+        "0 2 -4",
+        "1 -6 11 -6",
+        "2 -4 -22 24",
+        "1 0 0 -1e-300",
+        "@17 1 -3 2",
+        "@18 1 -6 11 -6",
+        CERT_PREFIX "1 -6 11 -6",
+        SWEEP_PREFIX "10 1 -6 11 -6 1 -6 11 -5",
+        EVAL_PREFIX "2 1 -6 11 -6 : 0.5 1 1.5 2 2.5 3",
+        EVAL_PREFIX "1cf 1 -3 2 0 : 0.1 0.2 0.3",
+        PING_REQUEST,
+        STATS_REQUEST,
+        "неверный запрос",
+};
+
+// Подменённое выделение памяти: считает вызов
+void* malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+// Подменённое выделение обнулённой памяти: считает вызов
+void* calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+// Подменённое изменение размера памяти: считает вызов
+void* realloc(void* pointer, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+// Функция для выбора свободного порта UDP на 127.0.0.1
+static int freePort(void)
+{
+    // Порт 0: свободный порт выбирает ядро
+    SocketAddress address;
+    memset(&address, 0, sizeof(address));
+    address.v4.sin_family = AF_INET;
+    address.v4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    socklen_t length = addressLength(&address);
+    if (sockfd == -1 || bind(sockfd, &address.any, length) == -1 ||
+        getsockname(sockfd, &address.any, &length) == -1)
+    {
+        perror("bind");
+        exit(1);
+    }
+    close(sockfd);
+    return ntohs(address.v4.sin_port);
+}
+
+// Функция для отправки count запросов по одному с ожиданием ответа.
+// Возвращает -1, если ответ не пришёл
+static int sendRequests(int sockfd, int count)
+{
+    char reply[MAXBUF];
+    for (int i = 0; i < count; i++)
+    {
+        const char* request = requests[i % (sizeof(requests) /
+                                            sizeof(requests[0]))];
+        if (send(sockfd, request, strlen(request), 0) == -1 ||
+            recv(sockfd, reply, sizeof(reply), 0) <= 0)
+        {
+            fprintf(stderr, "Нет ответа на запрос \"%s\".\n", request);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Основная функция теста
+int main(int argc, char* argv[])
+{
+    (void) argc;
+    (void) argv;
+    static ServerOptions options;
+    options.workers = TEST_WORKERS;
+    options.output = OUTPUT_SILENT;
+    options.port = freePort();
+
+    SharedStats* shared = workerSharedStats();
+    if (shared == NULL)
+    {
+        perror("mmap");
+        return 1;
+    }
+    shared->count = TEST_WORKERS;
+
+    // Обработчики запускаются так же, как в сервере без опции -N
+    static Worker workers[TEST_WORKERS];
+    pthread_barrier_t ready;
+    pthread_barrier_init(&ready, NULL, TEST_WORKERS + 1);
+    for (int i = 0; i < TEST_WORKERS; i++)
+    {
+        Worker* worker = &workers[i];
+        worker->id = i;
+        worker->cpu = -1;
+        worker->node = -1;
+        worker->sockfd = -1;
+        addressResolve("127.0.0.1", options.port, &worker->address);
+        worker->options = &options;
+        worker->stats = &shared->workers[i];
+        worker->shared = shared;
+        worker->ready = &ready;
+        worker->peers = workers;
+        worker->peerCount = TEST_WORKERS;
+        workerPrepare(worker);
+        if (pthread_create(&worker->thread, NULL, workerRun, worker) != 0)
+        {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    pthread_barrier_wait(&ready);
+    pthread_barrier_wait(&ready);
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct timeval timeout = {.tv_sec = REPLY_TIMEOUT_MS / 1000,
+                              .tv_usec = REPLY_TIMEOUT_MS % 1000 * 1000};
+    if (sockfd == -1 ||
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                   sizeof(timeout)) == -1 ||
+        connect(sockfd, &workers[0].address.any,
+                addressLength(&workers[0].address)) == -1)
+    {
+        perror("connect");
+        return 1;
+    }
+
+    // Прогрев: первые запросы могут выделять память в libc (например,
+    // при первом чтении часового пояса)
+    int result = sendRequests(sockfd, WARMUP_REQUESTS);
+    unsigned long before = atomic_load(&allocations);
+    if (result == 0)
+    {
+        result = sendRequests(sockfd, MEASURED_REQUESTS);
+    }
+    unsigned long count = atomic_load(&allocations) - before;
+
+    workerStop(workers, TEST_WORKERS, WORKER_DRAIN);
+    for (int i = 0; i < TEST_WORKERS; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+    close(sockfd);
+    if (result == -1)
+    {
+        return 1;
+    }
+    printf("Запросов: %d, выделений памяти: %lu\n", MEASURED_REQUESTS,
+           count);
+    return count == 0 ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+/*!
+ * \file test_alloc.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение основной функции теста
+ * выделений памяти сервера. Тест подменяет malloc, calloc и realloc
+ * функциями, которые считают вызовы, запускает обработчики сервера
+ * в своём процессе и отправляет им запросы: после прогрева обработка
+ * запросов не должна выделять память.
+*/
+
+#ifndef INC_6_LAB_TEST_ALLOC_H
+#define INC_6_LAB_TEST_ALLOC_H
+
+/*!
+ * \brief Запускает обработчики, прогревает их запросами и проверяет,
+ * что следующие запросы обрабатываются без выделения памяти
+ * \param[in] argc Количество аргументов командной строки
+ * \param[in] argv Массив указателей на строки, содержащие аргументы
+ * \return 0, если выделений не было, иначе 1
+ */
+int main(int argc, char* argv[]);
+
+#endif //INC_6_LAB_TEST_ALLOC_H
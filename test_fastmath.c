@@ -0,0 +1,180 @@
+/*! Тест точности приближённых функций из fastmath.h */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "test_fastmath.h"
+#include "fastmath.h"
+
+#define RANDOM_ARGUMENTS 1000000 // случайных аргументов каждой функции
+#define RANDOM_SEED 88172645463325252ull // начальное состояние xorshift
+#define CBRT_ULP 2.0 // границы ошибок из описания функций в fastmath.h
+#define ACOS_ULP 1.2
+#define COS_ULP 0.75
+#define SIN_ULP 1.2
+#define SKIP_CODE 77 // код пропуска теста для make check и ctest
+
+// Наибольшая ошибка функции и аргумент, на котором она достигнута
+typedef struct
+{
+    const char* name; // имя функции
+    double bound; // граница из описания функции, ulp
+    double error; // наибольшая ошибка, ulp
+    double argument; // аргумент с наибольшей ошибкой
+} Accuracy;
+
+// Аргументы, на которых ошибка близка к наибольшей, и границы отрезков
+static const double cbrtArguments[] = {
+        0x1.ffc4681886326p+1023, 0x1.f2f97dd8e17e1p+629,
+        0x1.b6e8d64369716p-607, DBL_MAX, DBL_MIN, 0x1p-1074, 0x1p-1060,
+        0x0.fffffffffffffp-1022, 1, 2, 3, 0x1p-3, 27, 1e300, 1e-300,
+};
+static const double acosArguments[] = {
+        0x1.14d5042629aap-1, 0x1.18187ed7dc7e6p-1, 0x1.2d0a8ea231806p-1,
+        0x1.194dbde01af7cp-1, 0x1.1f40ba2c05764p-1, 0.5, 0x1.0000000000001p-1,
+        0x1.fffffffffffffp-2, 1, 0x1.fffffffffffffp-1, 0, 0x1p-30,
+};
+static const double angleArguments[] = {
+        0x1.06059236b30b8p+0, 0x1.0ac2ed87819f7p+0, 0x1.08f5acfcb921bp+0,
+        0x1.0bcc1975179ddp+0, 0x1.0bd178f59f783p+0, 0x1.0c152382d7365p+0,
+        0x1.0c152382d7366p+0, 0x1p-30, 0x1p-1074, 0, 0.5, 1,
+};
+
+static uint64_t state = RANDOM_SEED; // состояние генератора xorshift
+
+// Функция для получения следующего псевдослучайного 64-битного числа
+static uint64_t nextRandom(void)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Функция для получения псевдослучайного числа из [0, 1)
+static double randomUnit(void)
+{
+    return (double) (nextRandom() >> 11) * 0x1p-53;
+}
+
+// Функция для получения псевдослучайного конечного положительного double
+// с равномерно распределёнными битами
+static double randomFinite(void)
+{
+    uint64_t bits = nextRandom() & 0x7FEFFFFFFFFFFFFFull;
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+// Функция для учёта ошибки value относительно эталона reference в ulp
+// правильно округлённого результата (у субнормальных - ulp DBL_MIN)
+static void account(Accuracy* accuracy, double argument, double value,
+                    long double reference)
+{
+    int exponent = reference == 0 ? DBL_MIN_EXP - 1 : ilogbl(reference);
+    if (exponent < DBL_MIN_EXP - 1)
+    {
+        exponent = DBL_MIN_EXP - 1;
+    }
+    double error = (double) (fabsl(value - reference) /
+                             ldexpl(1, exponent - (DBL_MANT_DIG - 1)));
+    if (!(error <= accuracy->error))
+    {
+        accuracy->error = error;
+        accuracy->argument = argument;
+    }
+}
+
+// Функция для проверки кубического корня на аргументе и его минусе
+static void checkCbrt(Accuracy* accuracy, double x)
+{
+    account(accuracy, x, fastCbrt(x), cbrtl(x));
+    account(accuracy, -x, fastCbrt(-x), cbrtl(-x));
+}
+
+// Функция для проверки арккосинуса на аргументе и его минусе
+static void checkAcos(Accuracy* accuracy, double x)
+{
+    account(accuracy, x, fastAcos(x), acosl(x));
+    account(accuracy, -x, fastAcos(-x), acosl(-x));
+}
+
+// Функция для проверки косинуса и синуса угла
+static void checkCosSin(Accuracy* cosine, Accuracy* sine, double theta)
+{
+    double c;
+    double s;
+    fastCosSin(theta, &c, &s);
+    account(cosine, theta, c, cosl(theta));
+    account(sine, theta, s, sinl(theta));
+}
+
+// Функция для проверки особых значений кубического корня: они
+// возвращаются точно
+static int checkCbrtSpecial(void)
+{
+    double zero = fastCbrt(-0.0);
+    int failed = fastCbrt(0.0) != 0 || zero != 0 || !signbit(zero) ||
+                 fastCbrt(INFINITY) != INFINITY ||
+                 fastCbrt(-INFINITY) != -INFINITY || !isnan(fastCbrt(NAN));
+    if (failed)
+    {
+        printf("fastCbrt: неверное значение в нуле, бесконечности или NaN\n");
+    }
+    return failed;
+}
+
+// Основная функция теста
+int main(int argc, char* argv[])
+{
+    (void) argc;
+    (void) argv;
+    // Эталон - функции long double: без расширенной точности сравнивать
+    // не с чем
+    if (LDBL_MANT_DIG < DBL_MANT_DIG + 8)
+    {
+        printf("long double не точнее double, тест пропущен\n");
+        return SKIP_CODE;
+    }
+
+    Accuracy cbrtAccuracy = {"fastCbrt", CBRT_ULP, 0, 0};
+    Accuracy acosAccuracy = {"fastAcos", ACOS_ULP, 0, 0};
+    Accuracy cosAccuracy = {"fastCosSin (cos)", COS_ULP, 0, 0};
+    Accuracy sinAccuracy = {"fastCosSin (sin)", SIN_ULP, 0, 0};
+    for (size_t i = 0; i < sizeof(cbrtArguments) / sizeof(double); i++)
+    {
+        checkCbrt(&cbrtAccuracy, cbrtArguments[i]);
+    }
+    for (size_t i = 0; i < sizeof(acosArguments) / sizeof(double); i++)
+    {
+        checkAcos(&acosAccuracy, acosArguments[i]);
+    }
+    for (size_t i = 0; i < sizeof(angleArguments) / sizeof(double); i++)
+    {
+        checkCosSin(&cosAccuracy, &sinAccuracy, angleArguments[i]);
+    }
+    for (int i = 0; i < RANDOM_ARGUMENTS; i++)
+    {
+        checkCbrt(&cbrtAccuracy, randomFinite());
+        checkAcos(&acosAccuracy, randomUnit());
+        checkCosSin(&cosAccuracy, &sinAccuracy, randomUnit() * (M_PI / 3));
+    }
+
+    int failed = checkCbrtSpecial();
+    const Accuracy* results[] = {&cbrtAccuracy, &acosAccuracy, &cosAccuracy,
+                                 &sinAccuracy};
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+    {
+        const Accuracy* accuracy = results[i];
+        int exceeded = !(accuracy->error <= accuracy->bound);
+        printf("%s: ошибка %.3f ulp при %a (граница %.2f ulp)%s\n",
+               accuracy->name, accuracy->error, accuracy->argument,
+               accuracy->bound, exceeded ? " - превышена" : "");
+        failed |= exceeded;
+    }
+    return failed ? 1 : 0;
+}
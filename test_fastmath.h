@@ -0,0 +1,25 @@
+/*!
+ * \file test_fastmath.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение основной функции теста
+ * точности приближённых функций из fastmath.h. Тест сравнивает их
+ * с функциями long double на аргументах, где при замере ошибка была
+ * наибольшей, и на случайных аргументах: ошибка не должна превышать
+ * границ из описания функций.
+*/
+
+#ifndef INC_6_LAB_TEST_FASTMATH_H
+#define INC_6_LAB_TEST_FASTMATH_H
+
+/*!
+ * \brief Проверяет, что ошибки fastCbrt, fastAcos и fastCosSin не больше
+ * границ из их описания, а особые значения кубического корня точны
+ * \param[in] argc Количество аргументов командной строки
+ * \param[in] argv Массив указателей на строки, содержащие аргументы
+ * \return 0, если границы не превышены, 77, если long double не точнее
+ * double и сравнивать не с чем, иначе 1
+ */
+int main(int argc, char* argv[]);
+
+#endif //INC_6_LAB_TEST_FASTMATH_H
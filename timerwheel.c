@@ -0,0 +1,205 @@
+/*! Функции колеса таймеров */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "timerwheel.h"
+
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+// Наибольшая задержка, которую покрывают все уровни
+#define WHEEL_RANGE ((1ull << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+// Функция для получения заголовка ячейки уровня
+static Timer* slotAt(TimerWheel* wheel, int level, uint64_t index)
+{
+    return &wheel->slots[level * WHEEL_SIZE + (index & WHEEL_MASK)];
+}
+
+// Функция для выделения ячеек колеса
+int timerWheelInit(TimerWheel* wheel, uint64_t now)
+{
+    size_t slots = (size_t) WHEEL_LEVELS * WHEEL_SIZE;
+    wheel->slots = malloc(sizeof(Timer) * slots);
+    if (wheel->slots == NULL)
+    {
+        return -1;
+    }
+    // Каждая ячейка - кольцевой список с фиктивным заголовком
+    for (size_t i = 0; i < slots; i++)
+    {
+        wheel->slots[i].next = &wheel->slots[i];
+        wheel->slots[i].prev = &wheel->slots[i];
+    }
+    wheel->current = now;
+    wheel->count = 0;
+    return 0;
+}
+
+// Функция для освобождения ячеек колеса
+void timerWheelDestroy(TimerWheel* wheel)
+{
+    free(wheel->slots);
+    wheel->slots = NULL;
+}
+
+// Функция для вставки таймера в ячейку по его сроку
+static void placeTimer(TimerWheel* wheel, Timer* timer)
+{
+    // Уровень определяется тем, насколько далеко срок: на уровне 0 лежат
+    // таймеры ближайшего оборота, выше - всё более дальние
+    uint64_t delta = timer->expires - wheel->current;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 &&
+           delta >= (1ull << (WHEEL_BITS * (level + 1))))
+    {
+        level++;
+    }
+    Timer* head = slotAt(wheel, level, timer->expires >> (WHEEL_BITS * level));
+    timer->next = head;
+    timer->prev = head->prev;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+// Функция для запуска таймера
+void timerAdd(TimerWheel* wheel, Timer* timer, uint64_t expires)
+{
+    // Таймер в прошлом сработает на ближайшем шаге, слишком далёкий -
+    // на границе последнего уровня
+    if (expires < wheel->current)
+    {
+        expires = wheel->current;
+    }
+    if (expires - wheel->current > WHEEL_RANGE)
+    {
+        expires = wheel->current + WHEEL_RANGE;
+    }
+    timer->expires = expires;
+    placeTimer(wheel, timer);
+    wheel->count++;
+}
+
+// Функция для отмены таймера
+void timerCancel(TimerWheel* wheel, Timer* timer)
+{
+    if (!timerPending(timer))
+    {
+        return;
+    }
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+    wheel->count--;
+}
+
+// Функция для проверки, запущен ли таймер
+int timerPending(const Timer* timer)
+{
+    return timer->next != NULL;
+}
+
+// Функция для переноса таймеров ячейки старшего уровня на младшие
+static void cascade(TimerWheel* wheel, int level)
+{
+    Timer* head = slotAt(wheel, level,
+                         wheel->current >> (WHEEL_BITS * level));
+    Timer* timer = head->next;
+    head->next = head;
+    head->prev = head;
+    while (timer != head)
+    {
+        Timer* next = timer->next;
+        placeTimer(wheel, timer);
+        timer = next;
+    }
+}
+
+// Функция для обработки одного шага колеса
+static int step(TimerWheel* wheel)
+{
+    // На границе оборота младшего уровня переносим вниз очередную ячейку
+    // следующего уровня, а на его границе - и более старших
+    for (int level = 1; level < WHEEL_LEVELS; level++)
+    {
+        if ((wheel->current & ((1ull << (WHEEL_BITS * level)) - 1)) != 0)
+        {
+            break;
+        }
+        cascade(wheel, level);
+    }
+
+    // Забираем весь список ячейки до вызова обработчиков: они могут
+    // запускать таймеры, которые должны попасть уже в следующий оборот
+    Timer* head = slotAt(wheel, 0, wheel->current);
+    Timer expired;
+    expired.next = head->next;
+    expired.prev = head->prev;
+    if (expired.next == head)
+    {
+        wheel->current++;
+        return 0;
+    }
+    expired.next->prev = &expired;
+    expired.prev->next = &expired;
+    head->next = head;
+    head->prev = head;
+    wheel->current++;
+
+    int fired = 0;
+    while (expired.next != &expired)
+    {
+        Timer* timer = expired.next;
+        timerCancel(wheel, timer);
+        timer->callback(timer);
+        fired++;
+    }
+    return fired;
+}
+
+// Функция для продвижения колеса
+int timerAdvance(TimerWheel* wheel, uint64_t now)
+{
+    int fired = 0;
+    while (wheel->current <= now)
+    {
+        // Пустое колесо можно сразу перевести на текущий момент
+        if (wheel->count == 0)
+        {
+            wheel->current = now + 1;
+            break;
+        }
+        fired += step(wheel);
+    }
+    return fired;
+}
+
+// Функция для определения времени до следующего шага колеса
+int timerNextTimeout(const TimerWheel* wheel, uint64_t now)
+{
+    if (wheel->count == 0)
+    {
+        return -1;
+    }
+    // Ищем ближайшую непустую ячейку нижнего уровня до конца оборота;
+    // дальше границы оборота ждать нельзя - там переносятся старшие уровни
+    uint64_t moment = wheel->current;
+    while ((moment & WHEEL_MASK) != 0)
+    {
+        const Timer* head = &wheel->slots[moment & WHEEL_MASK];
+        if (head->next != head)
+        {
+            break;
+        }
+        moment++;
+    }
+    return moment > now ? (int) (moment - now) : 0;
+}
+
+// Функция для получения монотонного времени
+uint64_t monotonicMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,118 @@
+/*!
+ * \file timerwheel.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение иерархического колеса таймеров.
+ * Таймер встраивается в структуру владельца, поэтому добавление и отмена
+ * не выделяют память и выполняются за O(1). Колесо не использует сигналы:
+ * его продвигает цикл обработки событий владельца.
+*/
+
+#ifndef INC_6_LAB_TIMERWHEEL_H
+#define INC_6_LAB_TIMERWHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * \brief Количество уровней колеса
+ */
+#define WHEEL_LEVELS 4
+
+/*!
+ * \brief Двоичный логарифм количества ячеек одного уровня
+ */
+#define WHEEL_BITS 8
+
+/*!
+ * \brief Количество ячеек одного уровня
+ */
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+
+/*!
+ * \brief Таймер, встраиваемый в структуру владельца
+ */
+typedef struct Timer
+{
+    struct Timer* next;               /*!< Следующий таймер ячейки */
+    struct Timer* prev;               /*!< Предыдущий таймер ячейки */
+    uint64_t expires;                 /*!< Момент срабатывания, мс */
+    void (*callback)(struct Timer*);  /*!< Вызывается при срабатывании */
+} Timer;
+
+/*!
+ * \brief Иерархическое колесо таймеров с шагом в одну миллисекунду
+ *
+ * Уровень 0 покрывает ближайшие 256 мс с шагом 1 мс, каждый следующий
+ * уровень - в 256 раз больший промежуток. Когда младший уровень делает
+ * оборот, таймеры очередной ячейки старшего уровня переносятся вниз.
+ */
+typedef struct
+{
+    Timer* slots;     /*!< Заголовки списков ячеек всех уровней */
+    uint64_t current; /*!< Ближайший необработанный момент, мс */
+    size_t count;     /*!< Количество запущенных таймеров */
+} TimerWheel;
+
+/*!
+ * \brief Выделяет ячейки колеса
+ * \param[out] wheel Колесо
+ * \param[in] now Текущее время, мс
+ * \return 0 при успехе, -1 при ошибке
+ */
+int timerWheelInit(TimerWheel* wheel, uint64_t now);
+
+/*!
+ * \brief Освобождает ячейки колеса
+ * \param[in] wheel Колесо
+ */
+void timerWheelDestroy(TimerWheel* wheel);
+
+/*!
+ * \brief Запускает таймер
+ * \param[in] wheel Колесо
+ * \param[in] timer Таймер (не должен быть запущен)
+ * \param[in] expires Момент срабатывания, мс
+ */
+void timerAdd(TimerWheel* wheel, Timer* timer, uint64_t expires);
+
+/*!
+ * \brief Отменяет таймер, если он запущен
+ * \param[in] wheel Колесо
+ * \param[in] timer Таймер
+ */
+void timerCancel(TimerWheel* wheel, Timer* timer);
+
+/*!
+ * \brief Проверяет, запущен ли таймер
+ * \param[in] timer Таймер
+ * \return 1, если таймер запущен
+ */
+int timerPending(const Timer* timer);
+
+/*!
+ * \brief Продвигает колесо до текущего момента и вызывает сработавшие таймеры
+ * \param[in] wheel Колесо
+ * \param[in] now Текущее время, мс
+ * \return Количество сработавших таймеров
+ */
+int timerAdvance(TimerWheel* wheel, uint64_t now);
+
+/*!
+ * \brief Определяет, сколько можно ждать событий до следующего шага колеса
+ *
+ * Для таймеров нижнего уровня возвращается точное время до срабатывания,
+ * для остальных - время до ближайшего переноса вниз.
+ * \param[in] wheel Колесо
+ * \param[in] now Текущее время, мс
+ * \return Время ожидания в мс или -1, если таймеров нет
+ */
+int timerNextTimeout(const TimerWheel* wheel, uint64_t now);
+
+/*!
+ * \brief Возвращает текущее монотонное время
+ * \return Время в миллисекундах
+ */
+uint64_t monotonicMs(void);
+
+#endif //INC_6_LAB_TIMERWHEEL_H
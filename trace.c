@@ -0,0 +1,168 @@
+/*! Функции трассировки обработки запросов */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include "trace.h"
+#include "interface.h"
+
+#ifdef ENABLE_TRACE
+
+// Событие: этап обработки с метками начала и конца
+typedef struct
+{
+    uint64_t begin;  // метка начала
+    uint64_t end;    // метка конца
+    uint32_t arg;    // аргумент события
+    uint32_t stage;  // этап
+} TraceEvent;
+
+// Кольцевой буфер событий одного потока
+typedef struct
+{
+    TraceEvent events[TRACE_RING_SIZE];
+    atomic_ulong head;  // количество записанных событий
+    int workerId;       // номер обработчика
+} TraceRing;
+
+// Имена этапов в трассе
+static const char* stageNames[TRACE_STAGES] = {"recv", "decode", "solve",
+                                               "log", "send"};
+
+static TraceRing* rings[MAX_WORKERS]; // буферы всех потоков
+static atomic_int ringCount;
+static __thread TraceRing* threadRing; // буфер текущего потока
+
+// Точка отсчёта для перевода меток в микросекунды
+static uint64_t originTicks;
+static uint64_t originNs;
+
+// Функция для получения CLOCK_MONOTONIC_RAW в наносекундах
+static uint64_t rawNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Функция для создания буфера текущего потока
+void traceThreadInit(int workerId)
+{
+    int index = atomic_fetch_add(&ringCount, 1);
+    if (index >= MAX_WORKERS)
+    {
+        return;
+    }
+    TraceRing* ring = calloc(1, sizeof(TraceRing));
+    if (ring == NULL)
+    {
+        perror("calloc");
+        return;
+    }
+    ring->workerId = workerId;
+    if (index == 0)
+    {
+        originTicks = traceNow();
+        originNs = rawNs();
+    }
+    threadRing = ring;
+    rings[index] = ring;
+}
+
+// Функция для записи события
+void traceRecord(TraceStage stage, uint64_t begin, uint64_t end,
+                 uint32_t arg)
+{
+    TraceRing* ring = threadRing;
+    if (ring == NULL)
+    {
+        return;
+    }
+    unsigned long head = atomic_load_explicit(&ring->head,
+                                              memory_order_relaxed);
+    TraceEvent* event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    event->begin = begin;
+    event->end = end;
+    event->arg = arg;
+    event->stage = stage;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Функция для вывода событий в файл
+int traceDump(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (out == NULL)
+    {
+        perror("fopen");
+        return -1;
+    }
+
+    // Сколько меток приходится на микросекунду: для счётчика тактов
+    // определяем по CLOCK_MONOTONIC_RAW с момента создания первого буфера
+    uint64_t ticks = traceNow() - originTicks;
+    uint64_t ns = rawNs() - originNs;
+    double ticksPerUs = ns > 0 ? ticks * 1000.0 / ns : 1000.0;
+
+    int count = atomic_load(&ringCount);
+    if (count > MAX_WORKERS)
+    {
+        count = MAX_WORKERS;
+    }
+    int written = 0;
+    const char* separator = "";
+    long pid = (long) getpid();
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (int i = 0; i < count; i++)
+    {
+        TraceRing* ring = rings[i];
+        if (ring == NULL)
+        {
+            continue;
+        }
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,"
+                     "\"tid\":%d,\"args\":{\"name\":\"Обработчик %d\"}}",
+                separator, pid, ring->workerId, ring->workerId);
+        separator = ",\n";
+
+        // Поток продолжает писать: выводим последние события буфера,
+        // пропуская те, что перезаписываются прямо сейчас
+        unsigned long head = atomic_load_explicit(&ring->head,
+                                                  memory_order_acquire);
+        unsigned long first = head > TRACE_RING_SIZE ?
+                              head - TRACE_RING_SIZE + 1 : 0;
+        for (unsigned long n = first; n < head; n++)
+        {
+            TraceEvent event = ring->events[n & (TRACE_RING_SIZE - 1)];
+            if (event.stage >= TRACE_STAGES || event.end < event.begin ||
+                event.begin < originTicks)
+            {
+                continue;
+            }
+            fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%ld,"
+                         "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                         "\"args\":{\"arg\":%u}}",
+                    stageNames[event.stage], pid, ring->workerId,
+                    (event.begin - originTicks) / ticksPerUs,
+                    (event.end - event.begin) / ticksPerUs, event.arg);
+            written++;
+        }
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    return written;
+}
+
+#else
+
+// Трассировка отключена при сборке
+int traceDump(const char* path)
+{
+    (void) path;
+    return -1;
+}
+
+#endif
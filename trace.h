@@ -0,0 +1,117 @@
+/*!
+ * \file trace.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение точек трассировки обработки
+ * запроса. Точки включаются при сборке (./configure --enable-trace,
+ * макрос ENABLE_TRACE), без этого макросы раскрываются в пустые
+ * выражения. Каждый поток пишет длительности этапов в свой кольцевой
+ * буфер; по запросу буферы выводятся в формате Chrome trace (JSON),
+ * который открывают chrome://tracing и Perfetto. Если доступен
+ * заголовок sys/sdt.h, каждая точка также является USDT-пробой
+ * solver:<этап> с аргументами начала и конца этапа.
+*/
+
+#ifndef INC_6_LAB_TRACE_H
+#define INC_6_LAB_TRACE_H
+
+#include <stdint.h>
+
+/*!
+ * \brief Этап обработки запроса
+ */
+typedef enum
+{
+    TRACE_RECV,   /*!< Приём датаграммы (recvfrom) */
+    TRACE_DECODE, /*!< Разбор запроса */
+    TRACE_SOLVE,  /*!< Решение уравнения и форматирование ответа */
+    TRACE_LOG,    /*!< Вывод на экран и в журнал */
+    TRACE_SEND,   /*!< Отправка ответа (sendto) */
+    TRACE_STAGES  /*!< Количество этапов */
+} TraceStage;
+
+/*!
+ * \brief Количество событий в буфере одного потока (степень двойки)
+ */
+#define TRACE_RING_SIZE 65536
+
+/*!
+ * \brief Выводит события всех потоков в файл формата Chrome trace
+ * \param[in] path Имя файла
+ * \return Количество выведенных событий или -1, если трассировка
+ * отключена при сборке или файл не удалось открыть
+ */
+int traceDump(const char* path);
+
+#ifdef ENABLE_TRACE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define TRACE_PROBE(probe, begin, end) DTRACE_PROBE2(solver, probe, begin, end)
+#else
+#define TRACE_PROBE(probe, begin, end) ((void) 0)
+#endif
+
+/*!
+ * \brief Возвращает метку времени: счётчик тактов процессора на x86,
+ * иначе CLOCK_MONOTONIC_RAW в наносекундах
+ * \return Метка времени
+ */
+static inline uint64_t traceNow(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/*!
+ * \brief Создаёт кольцевой буфер событий текущего потока
+ * \param[in] workerId Номер обработчика, под которым поток попадёт в трассу
+ */
+void traceThreadInit(int workerId);
+
+/*!
+ * \brief Записывает событие в буфер текущего потока
+ * \param[in] stage Этап
+ * \param[in] begin Метка начала
+ * \param[in] end Метка конца
+ * \param[in] arg Аргумент события (например, длина датаграммы)
+ */
+void traceRecord(TraceStage stage, uint64_t begin, uint64_t end,
+                 uint32_t arg);
+
+/*!
+ * \brief Отмечает начало этапа: объявляет переменную с меткой времени
+ */
+#define TRACE_BEGIN(var) uint64_t var = traceNow()
+
+/*!
+ * \brief Отмечает конец этапа, начатого TRACE_BEGIN
+ */
+#define TRACE_END(probe, stage, var, arg) \
+    do \
+    { \
+        uint64_t traceEnd = traceNow(); \
+        traceRecord(stage, var, traceEnd, arg); \
+        TRACE_PROBE(probe, var, traceEnd); \
+    } while (0)
+
+#else
+
+#define TRACE_BEGIN(var) ((void) 0)
+#define TRACE_END(probe, stage, var, arg) ((void) 0)
+#define traceThreadInit(workerId) ((void) 0)
+
+#endif
+
+#endif //INC_6_LAB_TRACE_H
@@ -0,0 +1,1023 @@
+/*! Функции потоков-обработчиков сервера */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sched.h>
+#include <pthread.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+#include "worker.h"
+#include "logic.h"
+#include "format.h"
+#include "signals.h"
+#include "protocol.h"
+#include "crash.h"
+#include "trace.h"
+#include "grid.h"
+
+#ifndef SO_INCOMING_CPU
+#define SO_INCOMING_CPU 49
+#endif
+
+#define QUEUE_CAPACITY 256 // задач в очереди обработчика (степень двойки)
+#define POOL_SLOTS (QUEUE_CAPACITY + 1) // буферы задач и буфер ответа
+#define RECV_BATCH 32 // датаграмм за один проход приёма
+#define IDLE_POLL_MS 100 // наибольшее ожидание запросов в простое
+#define PEER_CAPACITY 4096 // клиентов в таблице обработчика
+#define PEER_IDLE_MS 60000 // простой клиента до удаления из таблицы, мс
+#define REPLY_CACHE_SLOTS 1024 // ответов в кэше обработчика (степень двойки)
+#define REPLY_TTL_MS 10000 // время жизни ответа в кэше, мс
+#define OUTPUT_TEXT_SIZE (MAXBUF + 256) // описание запроса для вывода
+#define GRID_CHUNKS_PER_STEP 8 // блоков сетки за одно выполнение задачи
+
+// Режим остановки обработчиков
+static atomic_int stopMode = WORKER_RUNNING;
+
+// Задача: принятая датаграмма и всё, что нужно для ответа на неё.
+// Хранится в начале буфера пула обработчика, принявшего запрос
+typedef struct
+{
+    Worker* owner;        // обработчик, принявший запрос (владелец буфера)
+    int sockfd;           // сокет, на который пришёл запрос
+    SocketAddress peer;   // адрес клиента
+    socklen_t peerLength; // длина адреса клиента
+    int length;           // длина сообщения
+    long gridNext;        // следующий блок сетки (REQUEST_GRID)
+    long gridLast;        // последний блок сетки этой задачи (-1 - задача
+                          // ещё не выполнялась)
+    int gridPart;         // 1 - часть запроса сетки, отданная другим
+                          // обработчикам
+    char data[];          // сообщение, завершённое нулевым символом
+} Task;
+
+// Функция для определения узла NUMA процессора
+int cpuNumaNode(int cpu)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    if (dir == NULL)
+    {
+        return -1;
+    }
+    // Каталог процессора содержит ссылку nodeN на его узел
+    int node = -1;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (sscanf(entry->d_name, "node%d", &node) == 1)
+        {
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+// Функция для привязки текущего потока к процессору
+static void pinToCpu(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0)
+    {
+        fprintf(stderr, "Не удалось привязать обработчик к процессору %d: "
+                        "%s\n", cpu, strerror(error));
+        exit(1);
+    }
+}
+
+// Функция для создания и привязки сокета обработчика
+int workerBindSocket(const SocketAddress* address, int cpu)
+{
+    // Создаем сокет; он не должен достаться процессам, запущенным
+    // через exec, - новому серверу сокеты передаются явно
+    int family = address->any.sa_family;
+    int sockfd = socket(family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    // Проверяем на ошибки
+    if (sockfd == -1)
+    {
+        perror("socket");
+        exit(1);
+    }
+
+    // Каждый обработчик открывает свой сокет на том же адресе,
+    // ядро распределяет между ними датаграммы
+    int on = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &on,
+                   sizeof(on)) == -1)
+    {
+        perror("setsockopt(SO_REUSEPORT)");
+        exit(1);
+    }
+
+    // Просим ядро отдавать сокету датаграммы, принятые на процессоре
+    // обработчика, чтобы очереди сетевой карты совпадали с обработчиками
+    if (cpu >= 0 &&
+        setsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu,
+                   sizeof(cpu)) == -1)
+    {
+        perror("setsockopt(SO_INCOMING_CPU)");
+    }
+
+    // Сокет IPv6 принимает и запросы IPv4, если он привязан к адресу
+    // "::"; значение по умолчанию зависит от net.ipv6.bindv6only
+    int off = 0;
+    if (family == AF_INET6 &&
+        setsockopt(sockfd, IPPROTO_IPV6, IPV6_V6ONLY, &off,
+                   sizeof(off)) == -1)
+    {
+        perror("setsockopt(IPV6_V6ONLY)");
+    }
+
+    // Привязываем сокет к адресу
+    if (bind(sockfd, &address->any,
+             addressLength(address)) == -1)
+    {
+        perror("bind");
+        exit(1);
+    }
+    return sockfd;
+}
+
+// Функция для создания сокета и пула буферов обработчика
+void workerPrepare(Worker* worker)
+{
+    // Сокет, переданный предыдущим сервером, уже настроен и привязан
+    if (worker->sockfd == -1)
+    {
+        worker->sockfd = workerBindSocket(&worker->address, worker->cpu);
+    }
+
+    // Выделяем пул буферов задач и ответов один раз при запуске
+    if (poolInit(&worker->pool, POOL_SLOTS, sizeof(Task) + MAXBUF + 1,
+                 worker->options->hugePages) == -1)
+    {
+        exit(1);
+    }
+    // Заполняем страницы пула сразу, чтобы они были выделены
+    // на узле NUMA текущего потока, а не при первом запросе
+    memset(worker->pool.memory, 0, worker->pool.slotSize * POOL_SLOTS);
+    worker->txBuffer = poolAcquire(&worker->pool);
+    // Блок сетки не помещается в буфер пула
+    worker->gridBuffer = malloc(GRID_REPLY_SIZE);
+    if (worker->gridBuffer == NULL)
+    {
+        perror("malloc");
+        exit(1);
+    }
+
+    // Очередь задач вмещает все буферы пула, поэтому не переполняется
+    if (dequeInit(&worker->deque, QUEUE_CAPACITY) == -1)
+    {
+        perror("dequeInit");
+        exit(1);
+    }
+
+    // eventfd будит простаивающего обработчика, когда у других
+    // накопились задачи для перехвата
+    worker->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (worker->wakefd == -1)
+    {
+        perror("eventfd");
+        exit(1);
+    }
+    worker->seed = (unsigned int) worker->id * 2654435761u + 1;
+
+    // Сроки обработчика ведёт его собственное колесо таймеров
+    if (timerWheelInit(&worker->wheel, monotonicMs()) == -1 ||
+        peerTableInit(&worker->clients, PEER_CAPACITY, &worker->wheel,
+                      PEER_IDLE_MS) == -1)
+    {
+        perror("timerWheelInit");
+        exit(1);
+    }
+    // Ответы на запросы с номерами хранятся дольше, чем клиент повторяет
+    // запрос
+    if (replyCacheInit(&worker->replies, REPLY_CACHE_SLOTS,
+                       REPLY_TTL_MS) == -1)
+    {
+        perror("replyCacheInit");
+        exit(1);
+    }
+    // Без опции -b клиент может прислать подряд секундную норму запросов
+    const ServerOptions* options = worker->options;
+    peerTableLimit(&worker->clients, options->rateLimit,
+                   options->burst > 0 ? options->burst : options->rateLimit);
+}
+
+// Функция для записи счётчиков обработчиков в буфер
+int workerFormatStats(Worker* workers, int count, char* out, size_t size)
+{
+    size_t length = 0;
+    for (int i = 0; i < count && length < size; i++)
+    {
+        WorkerStats* stats = workers[i].stats;
+        int written = snprintf(out + length, size - length,
+                               "Обработчик %d: принято %lu, выполнено %lu, "
+                               "перехвачено %lu, в очереди %ld, "
+                               "наибольшая очередь %lu, клиентов %lu, "
+                               "удалено по простою %lu, отклонено %lu, "
+                               "повторов %lu, из кэша корней %lu, "
+                               "в кэш корней %lu\n", workers[i].id,
+                               atomic_load(&stats->received),
+                               atomic_load(&stats->executed),
+                               atomic_load(&stats->stolen),
+                               dequeSize(&workers[i].deque),
+                               atomic_load(&stats->maxDepth),
+                               atomic_load(&stats->clients),
+                               atomic_load(&stats->evicted),
+                               atomic_load(&stats->shed),
+                               atomic_load(&stats->duplicates),
+                               atomic_load(&stats->rootHits),
+                               atomic_load(&stats->rootMisses));
+        if (written < 0)
+        {
+            break;
+        }
+        length += written;
+    }
+    // Остальные процессы отвечают за свои очереди, но их счётчики видны
+    SharedStats* shared = count > 0 ? workers[0].shared : NULL;
+    if (shared != NULL && shared->processes > 0 && length < size)
+    {
+        length += workerFormatTotals(shared, out + length, size - length);
+    }
+    return length < size ? (int) length : (int) size - 1;
+}
+
+// Функция для записи сумм счётчиков всех процессов в буфер
+int workerFormatTotals(SharedStats* shared, char* out, size_t size)
+{
+    unsigned long received = 0;
+    unsigned long executed = 0;
+    unsigned long shed = 0;
+    unsigned long duplicates = 0;
+    unsigned long rootHits = 0;
+    for (int i = 0; i < shared->count; i++)
+    {
+        WorkerStats* stats = &shared->workers[i];
+        received += atomic_load(&stats->received);
+        executed += atomic_load(&stats->executed);
+        shed += atomic_load(&stats->shed);
+        duplicates += atomic_load(&stats->duplicates);
+        rootHits += atomic_load(&stats->rootHits);
+    }
+    int written = snprintf(out, size,
+                           "Всего (процессов %d, обработчиков %d): принято "
+                           "%lu, выполнено %lu, отклонено %lu, повторов %lu, "
+                           "из кэша корней %lu, перезапусков процессов "
+                           "%lu\n", shared->processes, shared->count,
+                           received, executed, shed, duplicates, rootHits,
+                           atomic_load(&shared->restarts));
+    if (written < 0)
+    {
+        return 0;
+    }
+    return (size_t) written < size ? written : (int) size - 1;
+}
+
+// Функция для выделения счётчиков в общей памяти
+SharedStats* workerSharedStats(void)
+{
+    // Анонимное отображение заполнено нулями
+    void* memory = mmap(NULL, sizeof(SharedStats), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+
+// Функция для пробуждения одного простаивающего обработчика
+static void wakeIdlePeer(Worker* worker)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    for (int i = 0; i < worker->peerCount; i++)
+    {
+        Worker* peer = &worker->peers[i];
+        int expected = 1;
+        if (peer != worker &&
+            atomic_compare_exchange_strong(&peer->idle, &expected, 0))
+        {
+            uint64_t one = 1;
+            if (write(peer->wakefd, &one, sizeof(one)) == -1)
+            {
+                perror("write(eventfd)");
+            }
+            return;
+        }
+    }
+}
+
+// Функция для публикации счётчиков таблицы клиентов
+static void updateClientStats(Worker* worker)
+{
+    atomic_store_explicit(&worker->stats->clients, worker->clients.count,
+                          memory_order_relaxed);
+    atomic_store_explicit(&worker->stats->evicted, worker->clients.evicted,
+                          memory_order_relaxed);
+    atomic_store_explicit(&worker->stats->shed, worker->clients.shed,
+                          memory_order_relaxed);
+}
+
+// Функция для отклонения запроса сверх ограничения частоты: до разбора
+// запроса клиенту отправляется короткий ответ "сервер занят" (или,
+// с опцией -D, ничего)
+static void shedRequest(Worker* worker, Task* task)
+{
+    if (worker->options->dropShed)
+    {
+        return;
+    }
+    if (sendto(worker->sockfd, BUSY_REPLY, sizeof(BUSY_REPLY) - 1,
+               MSG_DONTWAIT, (struct sockaddr *) &task->peer,
+               task->peerLength) == -1 && errno != EAGAIN &&
+        errno != EWOULDBLOCK)
+    {
+        perror("sendto");
+    }
+}
+
+// Функция для оценки стоимости запроса для ограничения частоты: ответ
+// на запрос сетки - по датаграмме на каждый блок, поэтому и стоит он
+// столько запросов, сколько блоков просит
+static unsigned long requestCost(const Task* task)
+{
+    uint64_t id;
+    size_t prefix = decodeRequestId(task->data, task->length, &id);
+    Request request;
+    if ((size_t) task->length - prefix < strlen(GRID_PREFIX) ||
+        memcmp(task->data + prefix, GRID_PREFIX, strlen(GRID_PREFIX)) != 0 ||
+        decodeRequest(task->data, task->length, &request) == -1 ||
+        request.type != REQUEST_GRID)
+    {
+        return 1;
+    }
+    return (unsigned long) (request.lastChunk - request.firstChunk + 1);
+}
+
+// Обработчик срока ожидания запросов: завершает сервер, если за время
+// из опции -t не пришло ни одного запроса
+static void inactivityExpired(Timer* timer)
+{
+    Worker* worker = (Worker*) ((char*) timer -
+                                offsetof(Worker, inactivity));
+    uint64_t limit = (uint64_t) worker->options->timeout * 1000;
+    uint64_t deadline = atomic_load(&worker->shared->lastRequestMs) + limit;
+    if (deadline > worker->wheel.current)
+    {
+        timerAdd(&worker->wheel, &worker->inactivity, deadline);
+        return;
+    }
+    timeoutHandler();
+}
+
+// Функция для ответа на повтор запроса с номером. Выполненный запрос
+// получает ответ из кэша, а повтор ещё выполняющегося отбрасывается:
+// ответ на первую попытку уйдёт клиенту сам. Возвращает 1, если
+// запрос оказался повтором
+static int answerDuplicate(Worker* worker, Task* task, uint64_t now)
+{
+    uint64_t id;
+    if (decodeRequestId(task->data, task->length, &id) == 0)
+    {
+        return 0;
+    }
+    int length;
+    ReplyLookup lookup = replyCacheLookup(&worker->replies, &task->peer, id,
+                                          now, task->data, &length);
+    if (lookup == REPLY_NEW)
+    {
+        return 0;
+    }
+    if (lookup == REPLY_CACHED &&
+        sendto(worker->sockfd, task->data, length, MSG_DONTWAIT,
+               (struct sockaddr *) &task->peer, task->peerLength) == -1 &&
+        errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        perror("sendto");
+    }
+    atomic_fetch_add_explicit(&worker->stats->duplicates, 1,
+                              memory_order_relaxed);
+    return 1;
+}
+
+// Функция для приёма накопившихся датаграмм в очередь задач
+static int receiveBatch(Worker* worker, uint64_t now)
+{
+    int received = 0;
+    int arrived = 0;
+    while (arrived < RECV_BATCH)
+    {
+        // Если все буферы заняты, датаграммы подождут в очереди сокета
+        char* buffer = poolAcquire(&worker->pool);
+        if (buffer == NULL)
+        {
+            break;
+        }
+        Task* task = (Task*) buffer;
+
+        // Принимаем данные от клиента и запоминаем его адрес
+        task->peerLength = sizeof(task->peer); // длина адреса клиента
+        TRACE_BEGIN(recvStart);
+        task->length = recvfrom(worker->sockfd, task->data, MAXBUF,
+                                MSG_DONTWAIT, (struct sockaddr *) &task->peer,
+                                &task->peerLength);
+        // Проверяем на ошибки
+        if (task->length == -1)
+        {
+            poolRelease(&worker->pool, buffer);
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                perror("recvfrom");
+                exit(1);
+            }
+            break;
+        }
+        TRACE_END(recv, TRACE_RECV, recvStart, task->length);
+        task->data[task->length] = '\0'; // добавляем нулевой символ
+        arrived++;
+        // Клиент, превысивший ограничение частоты, получает отказ до
+        // разбора запроса, и его запросы не занимают очередь
+        Peer* peer = peerTouch(&worker->clients, &task->peer, now);
+        if (!peerAdmit(&worker->clients, peer, requestCost(task), now))
+        {
+            shedRequest(worker, task);
+            poolRelease(&worker->pool, buffer);
+            continue;
+        }
+        // Повтор запроса, который уже выполнен или выполняется, не решается
+        // заново
+        if (answerDuplicate(worker, task, now))
+        {
+            poolRelease(&worker->pool, buffer);
+            continue;
+        }
+        task->owner = worker;
+        task->sockfd = worker->sockfd;
+        task->gridLast = -1;
+        // Очередь вмещает все буферы пула, но если она всё же полна,
+        // клиент получает отказ, а не остаётся без ответа
+        if (dequePush(&worker->deque, task) == -1)
+        {
+            shedRequest(worker, task);
+            poolRelease(&worker->pool, buffer);
+            break;
+        }
+        received++;
+    }
+    if (arrived == 0)
+    {
+        return 0;
+    }
+
+    // Запросы пришли: отодвигаем срок ожидания запросов
+    atomic_store(&worker->shared->lastRequestMs, now);
+    updateClientStats(worker);
+    if (received == 0)
+    {
+        return 0;
+    }
+
+    atomic_fetch_add(&worker->stats->received, received);
+    unsigned long depth = (unsigned long) dequeSize(&worker->deque);
+    if (depth > atomic_load(&worker->stats->maxDepth))
+    {
+        atomic_store(&worker->stats->maxDepth, depth);
+    }
+    // Лишние задачи могут забрать простаивающие обработчики
+    if (depth > 1)
+    {
+        wakeIdlePeer(worker);
+    }
+    return received;
+}
+
+// Функция для перехвата задачи у другого обработчика
+static Task* stealTask(Worker* worker)
+{
+    // Начинаем со случайного обработчика, чтобы не соревноваться
+    // всем за одну и ту же очередь
+    int start = rand_r(&worker->seed) % worker->peerCount;
+    for (int i = 0; i < worker->peerCount; i++)
+    {
+        Worker* victim = &worker->peers[(start + i) % worker->peerCount];
+        if (victim == worker)
+        {
+            continue;
+        }
+        Task* task = dequeSteal(&victim->deque);
+        if (task != NULL)
+        {
+            atomic_fetch_add(&worker->stats->stolen, 1);
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// Функция для ожидания запросов или задач для перехвата
+static void idleWait(Worker* worker)
+{
+    atomic_store(&worker->idle, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    // Задачи могли появиться, пока мы объявляли о простое
+    for (int i = 0; i < worker->peerCount; i++)
+    {
+        if (dequeSize(&worker->peers[i].deque) > 0)
+        {
+            atomic_store(&worker->idle, 0);
+            return;
+        }
+    }
+
+    // Спим не дольше, чем до ближайшего шага колеса таймеров
+    int timeout = timerNextTimeout(&worker->wheel, monotonicMs());
+    if (timeout < 0 || timeout > IDLE_POLL_MS)
+    {
+        timeout = IDLE_POLL_MS;
+    }
+    struct pollfd fds[2] = {{worker->sockfd, POLLIN, 0},
+                            {worker->wakefd, POLLIN, 0}};
+    if (poll(fds, 2, timeout) == -1 && errno != EINTR)
+    {
+        perror("poll");
+        exit(1);
+    }
+    if (fds[1].revents & POLLIN)
+    {
+        uint64_t value;
+        if (read(worker->wakefd, &value, sizeof(value)) == -1)
+        {
+            perror("read(eventfd)");
+        }
+    }
+    atomic_store(&worker->idle, 0);
+}
+
+// Функция для вывода запроса и ответа на экран и в журнал. Текст
+// собирается без printf и выводится одним вызовом writev, а в журнал
+// попадает одной записью
+static void writeOutput(Worker* worker, Task* task, const char* reply,
+                        int replyLength, int invalid)
+{
+    OutputMode mode = worker->options->output;
+    if (mode == OUTPUT_SILENT)
+    {
+        return;
+    }
+    char buffer[OUTPUT_TEXT_SIZE];
+    char peer[ADDRESS_TEXT_SIZE];
+    TextBuffer text;
+    textInit(&text, buffer, sizeof(buffer));
+    int peerLength = addressFormat(&task->peer, peer, sizeof(peer));
+
+    if (mode == OUTPUT_COMPACT)
+    {
+        // 127.0.0.1:40000 "1 -3 2" -> 118 байт
+        textAppend(&text, peer, peerLength);
+        textAppendLiteral(&text, " \"");
+        textAppend(&text, task->data, task->length);
+        if (invalid)
+        {
+            textAppendLiteral(&text, "\" -> неверный формат\n");
+        }
+        else
+        {
+            textAppendLiteral(&text, "\" -> ");
+            textAppendInt(&text, replyLength);
+            textAppendLiteral(&text, " байт\n");
+        }
+        if (write(STDOUT_FILENO, text.data, text.length) == -1)
+        {
+            // вывод на экран необязателен
+        }
+        writeLogText(text.data, text.length);
+        return;
+    }
+
+    // Выводим информацию о клиенте и его запросе на экран и в файл журнала
+    textAppendLiteral(&text, "Получен запрос от ");
+    textAppend(&text, peer, peerLength);
+    textAppendLiteral(&text, "\nПакет длиной ");
+    textAppendInt(&text, task->length);
+    textAppendLiteral(&text, " байтов\nПакет содержит \"");
+    textAppendString(&text, task->data);
+    textAppendLiteral(&text, "\"\n");
+    // На экран после описания запроса выводится ответ
+    struct iovec parts[2] = {
+        {.iov_base = text.data, .iov_len = text.length},
+        {.iov_base = (void*) reply, .iov_len = replyLength}
+    };
+    if (writev(STDOUT_FILENO, parts, 2) == -1)
+    {
+        // вывод на экран необязателен
+    }
+    // В журнал - только описание запроса и сообщение об ошибке формата
+    if (invalid)
+    {
+        textAppend(&text, reply, replyLength);
+    }
+    writeLogText(text.data, text.length);
+}
+
+// Функция для возврата буфера задачи в пул обработчика, который её принял
+static void releaseTask(Worker* worker, Task* task)
+{
+    if (task->owner == worker)
+    {
+        poolRelease(&worker->pool, (char*) task);
+    }
+    else
+    {
+        poolReleaseRemote(&task->owner->pool, (char*) task);
+    }
+}
+
+// Функция для раздачи блоков запроса сетки: копии задачи с хвостовыми
+// частями диапазона блоков встают в очередь обработчика, и простаивающие
+// обработчики перехватывают их. Копии занимают буферы пула этого
+// обработчика; если буферов нет, оставшиеся блоки выполнит сама задача
+static void splitGrid(Worker* worker, Task* task)
+{
+    long chunks = task->gridLast - task->gridNext + 1;
+    long parts = chunks < worker->peerCount ? chunks : worker->peerCount;
+    long size = (chunks + parts - 1) / parts;
+    while (task->gridLast - task->gridNext + 1 > size)
+    {
+        Task* part = (Task*) poolAcquire(&worker->pool);
+        if (part == NULL)
+        {
+            break;
+        }
+        memcpy(part, task, sizeof(Task) + task->length + 1);
+        part->owner = worker;
+        part->gridPart = 1;
+        part->gridNext = task->gridLast - size + 1;
+        if (dequePush(&worker->deque, part) == -1)
+        {
+            poolRelease(&worker->pool, (char*) part);
+            break;
+        }
+        task->gridLast = part->gridNext - 1;
+        wakeIdlePeer(worker);
+    }
+}
+
+// Функция для выполнения запроса сетки. За один раз задача отправляет
+// не больше GRID_CHUNKS_PER_STEP блоков и встаёт в конец очереди, чтобы
+// большая сетка не задерживала другие запросы. В очередь задача
+// возвращается только к обработчику, который её принял: в его очереди
+// места хватает на все буферы его пула, а перехваченная задача занимает
+// буфер чужого пула и выполняется до конца сразу
+static void executeGrid(Worker* worker, Task* task, const Request* request)
+{
+    long counts[4];
+    long total = gridPoints(request, counts);
+    if (task->gridLast == -1)
+    {
+        task->gridNext = request->firstChunk;
+        task->gridLast = request->lastChunk;
+        task->gridPart = 0;
+        char summary[128];
+        int length = snprintf(summary, sizeof(summary),
+                              "Сетка: уравнений %ld, блоки %ld-%ld\n", total,
+                              request->firstChunk, request->lastChunk);
+        writeOutput(worker, task, summary, length, 0);
+        splitGrid(worker, task);
+    }
+
+    // Каждый блок начинается с номера запроса, как и обычный ответ
+    TextBuffer prefix;
+    textInit(&prefix, worker->gridBuffer, ID_PREFIX_SIZE + 1);
+    if (request->id != 0)
+    {
+        textAppendLiteral(&prefix, ID_PREFIX);
+        textAppendUnsigned(&prefix, request->id);
+        textAppendLiteral(&prefix, " ");
+    }
+    while (1)
+    {
+        for (int i = 0; i < GRID_CHUNKS_PER_STEP &&
+                        task->gridNext <= task->gridLast; i++)
+        {
+            int warm;
+            int length = gridEncodeChunk(request, counts, task->gridNext++,
+                                         worker->gridBuffer + prefix.length,
+                                         GRID_REPLY_SIZE - prefix.length,
+                                         &warm);
+            if (length == -1)
+            {
+                continue;
+            }
+            length += (int) prefix.length;
+            if (sendto(task->sockfd, worker->gridBuffer, length, 0,
+                       (struct sockaddr *) &task->peer,
+                       task->peerLength) == -1)
+            {
+                perror("sendto");
+            }
+        }
+        if (task->gridNext > task->gridLast)
+        {
+            break;
+        }
+        // Если очередь полна, продолжаем без очереди
+        if (task->owner == worker && dequePush(&worker->deque, task) == 0)
+        {
+            return;
+        }
+    }
+    // Запрос выполнен, когда отправлены блоки исходной задачи
+    if (task->gridPart == 0)
+    {
+        atomic_fetch_add(&worker->stats->executed, 1);
+    }
+    releaseTask(worker, task);
+}
+
+// Функция для решения квадратного (d = 0) или кубического уравнения
+// запроса. С кэшем корней (опция -c) решение сначала ищется в нём, а
+// новое решение сохраняется туда для всех обработчиков
+static void solveEquation(Worker* worker, const Request* request,
+                          EquationResult* result)
+{
+    const double coef[4] = {request->a, request->b, request->c, request->d};
+    int found = worker->roots != NULL
+                ? rootCacheLookup(worker->roots, coef, result) : -1;
+    if (found == 1)
+    {
+        atomic_fetch_add_explicit(&worker->stats->rootHits, 1,
+                                  memory_order_relaxed);
+        return;
+    }
+    if (request->d == 0)
+    {
+        ComputeQuadratic(request->a, request->b, request->c, result);
+    }
+    else
+    {
+        ComputeCubic(request->a, request->b, request->c, request->d, result);
+    }
+    if (found == 0)
+    {
+        rootCacheStore(worker->roots, coef, result);
+        atomic_fetch_add_explicit(&worker->stats->rootMisses, 1,
+                                  memory_order_relaxed);
+    }
+}
+
+// Функция для выполнения одной задачи
+static void executeTask(Worker* worker, Task* task)
+{
+    char* txBuffer = worker->txBuffer;
+
+    // Запрос попадёт в отчёт, если его выполнение приведёт к сбою
+    crashRecord(worker->id, task->data, task->length);
+
+    // Разбираем запрос прямо в приёмном буфере, а ответ формируем
+    // сразу в буфере отправки
+    Request request;
+    int replyLength;
+    TRACE_BEGIN(decodeStart);
+    int decoded = decodeRequest(task->data, task->length, &request);
+    TRACE_END(decode, TRACE_DECODE, decodeStart, task->length);
+
+    // Ответ на запрос сетки - много датаграмм, и он не кэшируется
+    if (decoded == 0 && request.type == REQUEST_GRID)
+    {
+        executeGrid(worker, task, &request);
+        return;
+    }
+
+    // Ответ на запрос с номером начинается с того же номера
+    TextBuffer prefix;
+    textInit(&prefix, txBuffer, ID_PREFIX_SIZE + 1);
+    if (request.id != 0)
+    {
+        textAppendLiteral(&prefix, ID_PREFIX);
+        textAppendUnsigned(&prefix, request.id);
+        textAppendLiteral(&prefix, " ");
+    }
+    char* reply = txBuffer + prefix.length;
+    size_t replySize = MAXBUF - prefix.length;
+
+    TRACE_BEGIN(solveStart);
+    if (decoded == -1)
+    {
+        // неверный формат запроса
+        replyLength = snprintf(reply, replySize,
+                               "Неверный формат запроса.\n");
+    }
+    else if (request.type == REQUEST_STATS)
+    {
+        // статистика обработчиков
+        replyLength = workerFormatStats(worker->peers, worker->peerCount,
+                                        reply, replySize);
+    }
+    else if (request.type == REQUEST_PING)
+    {
+        // проверка сервера клиентом
+        replyLength = snprintf(reply, replySize, "%s", PONG_REPLY);
+    }
+    else if (request.type == REQUEST_SWEEP)
+    {
+        // решаем уравнения вдоль пути, уточняя корни соседних точек
+        double from[4] = {request.a, request.b, request.c, request.d};
+        replyLength = FormatSweep(reply, replySize, from, request.to,
+                                  request.points);
+    }
+    else if (request.type == REQUEST_EVAL)
+    {
+        // значения многочлена и производных в точках
+        double coef[4] = {request.a, request.b, request.c, request.d};
+        replyLength = FormatEvaluation(reply, replySize, coef, request.x,
+                                       request.points, request.derivatives,
+                                       request.evalFlags);
+    }
+    else if (request.type == REQUEST_CERT)
+    {
+        // решаем уравнение в интервальной арифметике
+        replyLength = FormatCertified(reply, replySize, request.a,
+                                      request.b, request.c, request.d);
+    }
+    else if (request.d == 0)
+    {
+        // решаем квадратное уравнение
+        EquationResult result;
+        solveEquation(worker, &request, &result);
+        replyLength = FormatQuadraticRoots(reply, replySize, request.a,
+                                           request.b, request.c, &result);
+    }
+    else
+    {
+        // решаем кубическое уравнение и раскладываем на множители
+        EquationResult result;
+        solveEquation(worker, &request, &result);
+        replyLength = FormatCubicRoots(reply, replySize, request.a,
+                                       request.b, request.c, request.d,
+                                       &result);
+    }
+    TRACE_END(solve, TRACE_SOLVE, solveStart, replyLength);
+    int datagramLength = (int) prefix.length + replyLength;
+
+    // Отправляем ответ через сокет, на который пришёл запрос. Вывод на
+    // экран и в журнал идёт после отправки и не задерживает ответ
+    TRACE_BEGIN(sendStart);
+    if (sendto(task->sockfd, txBuffer, datagramLength, 0,
+               (struct sockaddr *) &task->peer, task->peerLength) == -1)
+    {
+        perror("sendto");
+    }
+    TRACE_END(send, TRACE_SEND, sendStart, datagramLength);
+
+    // Повтор этого запроса получит тот же ответ из кэша обработчика,
+    // который принял запрос
+    if (request.id != 0)
+    {
+        replyCacheStore(&task->owner->replies, &task->peer, request.id,
+                        monotonicMs(), txBuffer, datagramLength);
+    }
+
+    TRACE_BEGIN(logStart);
+    writeOutput(worker, task, reply, replyLength, decoded == -1);
+    TRACE_END(log, TRACE_LOG, logStart, replyLength);
+
+    // Возвращаем буфер задачи в пул обработчика, который её принял
+    releaseTask(worker, task);
+    atomic_fetch_add(&worker->stats->executed, 1);
+}
+
+// Функция для выполнения всех задач своей очереди. NULL от dequeSteal
+// ещё не значит, что очередь пуста: задачу мог забрать перехватчик,
+// а следующая осталась, поэтому цикл идёт до пустой очереди
+static void executeOwnTasks(Worker* worker)
+{
+    while (dequeSize(&worker->deque) > 0)
+    {
+        Task* task = dequeSteal(&worker->deque);
+        if (task != NULL)
+        {
+            executeTask(worker, task);
+        }
+    }
+}
+
+// Функция для завершения работы обработчика без потери запросов
+static void workerDrain(Worker* worker, int mode)
+{
+    // При остановке датаграммы, уже стоящие в очереди сокета, - тоже
+    // ожидающие ответа запросы. При перезапуске их прочитает новый сервер
+    if (mode == WORKER_DRAIN)
+    {
+        while (receiveBatch(worker, monotonicMs()) > 0)
+        {
+            executeOwnTasks(worker);
+        }
+    }
+    executeOwnTasks(worker);
+    writeLog("Обработчик %d остановлен: принято %lu, выполнено %lu, "
+             "отклонено %lu\n", worker->id,
+             atomic_load(&worker->stats->received),
+             atomic_load(&worker->stats->executed),
+             worker->clients.shed);
+}
+
+// Функция для остановки обработчиков
+void workerStop(Worker* workers, int count, int mode)
+{
+    atomic_store(&stopMode, mode);
+    // Будим простаивающих, чтобы они увидели режим остановки
+    for (int i = 0; i < count; i++)
+    {
+        uint64_t one = 1;
+        if (write(workers[i].wakefd, &one, sizeof(one)) == -1)
+        {
+            perror("write(eventfd)");
+        }
+    }
+}
+
+// Основная функция потока-обработчика
+void* workerRun(void* arg)
+{
+    Worker* worker = arg;
+
+    // Отчёт о сбое и трасса этого потока укажут номер обработчика
+    crashThreadInit(worker->id);
+    traceThreadInit(worker->id);
+
+    if (worker->cpu >= 0)
+    {
+        pinToCpu(worker->cpu);
+    }
+    if (worker->options->numa)
+    {
+        // Сокет и пул создаются уже на процессоре обработчика
+        workerPrepare(worker);
+    }
+
+    writeLog("Обработчик %d: процессор %d, узел NUMA %d\n",
+             worker->id, worker->cpu, worker->node);
+
+    // Сообщаем главному потоку, что обработчик готов, и ждём остальных:
+    // до этого их очереди ещё не созданы
+    pthread_barrier_wait(worker->ready);
+    pthread_barrier_wait(worker->ready);
+
+    // Срок ожидания запросов для всего сервера отслеживает первый обработчик
+    if (worker->id == 0 && worker->options->timeout > 0)
+    {
+        uint64_t now = monotonicMs();
+        atomic_store(&worker->shared->lastRequestMs, now);
+        worker->inactivity.callback = inactivityExpired;
+        timerAdd(&worker->wheel, &worker->inactivity,
+                 now + (uint64_t) worker->options->timeout * 1000);
+    }
+
+    // Входим в цикл обработки запросов от клиентов до остановки сервера
+    while (1)
+    {
+        int mode = atomic_load(&stopMode);
+        if (mode != WORKER_RUNNING)
+        {
+            workerDrain(worker, mode);
+            break;
+        }
+
+        // Таймеры продвигает сам цикл обработки, без сигналов
+        uint64_t now = monotonicMs();
+        if (timerAdvance(&worker->wheel, now) > 0)
+        {
+            updateClientStats(worker);
+        }
+        receiveBatch(worker, now);
+        // Свои задачи берём с того же конца, что и перехватчики, то есть
+        // в порядке поступления: иначе ранние запросы ждали бы поздних
+        Task* task = dequeSteal(&worker->deque);
+        if (task == NULL)
+        {
+            task = stealTask(worker);
+        }
+        if (task != NULL)
+        {
+            executeTask(worker, task);
+            continue;
+        }
+        idleWait(worker);
+    }
+    return NULL;
+}
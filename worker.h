@@ -0,0 +1,189 @@
+/*!
+ * \file worker.h
+ * \brief Заголовочный файл с описанием функций
+ *
+ * Данный файл содержит в себе определение потоков-обработчиков сервера.
+ * Каждый обработчик владеет своим сокетом (SO_REUSEPORT), своим пулом
+ * буферов, своей очередью задач и своим колесом таймеров и может быть
+ * привязан к процессору.
+ * Принятые датаграммы становятся задачами в очереди принявшего их
+ * обработчика; простаивающие обработчики перехватывают задачи у занятых,
+ * а ответ всегда уходит через сокет, на который пришёл запрос.
+ * С опцией -P обработчики работают в нескольких процессах; их счётчики
+ * лежат в общей памяти, которую видят все процессы.
+*/
+
+#ifndef INC_6_LAB_WORKER_H
+#define INC_6_LAB_WORKER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "interface.h"
+#include "address.h"
+#include "pool.h"
+#include "deque.h"
+#include "timerwheel.h"
+#include "peers.h"
+#include "replycache.h"
+#include "rootcache.h"
+
+/*!
+ * \brief Режим работы обработчиков
+ */
+typedef enum
+{
+    WORKER_RUNNING, /*!< Обработчики принимают и выполняют запросы */
+    WORKER_DRAIN,   /*!< Ответить на все принятые и ждущие в сокете
+                         запросы и завершиться */
+    WORKER_HANDOFF  /*!< Ответить на принятые запросы и завершиться;
+                         сокеты читает новый сервер */
+} WorkerMode;
+
+/*!
+ * \brief Счётчики обработчика, доступные через запрос статистики
+ */
+typedef struct
+{
+    atomic_ulong received; /*!< Принято датаграмм */
+    atomic_ulong executed; /*!< Выполнено задач */
+    atomic_ulong stolen;   /*!< Из них перехвачено у других обработчиков */
+    atomic_ulong maxDepth; /*!< Наибольшая длина очереди */
+    atomic_ulong clients;  /*!< Клиентов в таблице обработчика */
+    atomic_ulong evicted;  /*!< Клиентов, удалённых по простою */
+    atomic_ulong shed;     /*!< Запросов, отклонённых ограничением частоты */
+    atomic_ulong duplicates; /*!< Повторов запросов, не решавшихся заново */
+    atomic_ulong rootHits;   /*!< Уравнений, решение которых взято из кэша
+                                  корней */
+    atomic_ulong rootMisses; /*!< Уравнений, решённых и сохранённых в кэш
+                                  корней */
+} WorkerStats;
+
+/*!
+ * \brief Счётчики всех обработчиков сервера в общей памяти
+ *
+ * Отображение создаётся до запуска процессов-обработчиков (опция -P),
+ * поэтому его видят все процессы, а счётчики процесса, перезапущенного
+ * после сбоя, продолжаются с прежних значений.
+ */
+typedef struct
+{
+    WorkerStats workers[MAX_WORKERS]; /*!< Счётчики обработчиков по
+                                           номерам */
+    int count;                        /*!< Обработчиков во всех процессах */
+    int processes;                    /*!< Процессов-обработчиков (0 - все
+                                           обработчики - потоки одного
+                                           процесса) */
+    atomic_ulong restarts;            /*!< Процессов, перезапущенных после
+                                           сбоя */
+    _Atomic uint64_t lastRequestMs;   /*!< Время последнего принятого
+                                           сервером запроса, мс */
+} SharedStats;
+
+/*!
+ * \brief Поток-обработчик запросов
+ */
+typedef struct Worker
+{
+    int id;                      /*!< Номер обработчика */
+    int cpu;                     /*!< Процессор (-1 - без привязки) */
+    int node;                    /*!< Узел NUMA процессора (-1 - неизвестен) */
+    int sockfd;                  /*!< Сокет обработчика (-1 - создать) */
+    int wakefd;                  /*!< eventfd для пробуждения при простое */
+    atomic_int idle;             /*!< 1, пока обработчик ждёт в poll */
+    BufferPool pool;             /*!< Буферы задач и ответов */
+    char* txBuffer;              /*!< Буфер отправки этого обработчика */
+    char* gridBuffer;            /*!< Буфер отправки блоков сетки */
+    TaskDeque deque;             /*!< Очередь задач */
+    WorkerStats* stats;          /*!< Счётчики (в SharedStats) */
+    SharedStats* shared;         /*!< Счётчики всех обработчиков сервера */
+    TimerWheel wheel;            /*!< Таймеры обработчика */
+    PeerTable clients;           /*!< Клиенты, приславшие запросы */
+    ReplyCache replies;          /*!< Недавние ответы на запросы с номерами */
+    RootCache* roots;            /*!< Общий кэш корней (NULL - без кэша) */
+    Timer inactivity;            /*!< Срок ожидания запросов (опция -t) */
+    unsigned int seed;           /*!< Состояние выбора жертвы перехвата */
+    SocketAddress address;       /*!< Адрес, на котором слушает обработчик */
+    const ServerOptions* options; /*!< Параметры запуска сервера */
+    struct Worker* peers;        /*!< Все обработчики сервера */
+    int peerCount;               /*!< Количество обработчиков */
+    pthread_barrier_t* ready;    /*!< Барьер готовности всех обработчиков */
+    pthread_t thread;            /*!< Поток */
+} Worker;
+
+/*!
+ * \brief Определяет узел NUMA, к которому относится процессор
+ * \param[in] cpu Номер процессора
+ * \return Номер узла или -1, если он неизвестен
+ */
+int cpuNumaNode(int cpu);
+
+/*!
+ * \brief Выделяет счётчики обработчиков в общей памяти
+ * (MAP_SHARED | MAP_ANONYMOUS), доступной процессам, созданным fork
+ * \return Обнулённые счётчики или NULL при ошибке
+ */
+SharedStats* workerSharedStats(void);
+
+/*!
+ * \brief Создаёт сокет обработчика с SO_REUSEPORT и привязывает его
+ * к адресу
+ *
+ * При ошибке выводит сообщение и завершает программу.
+ * \param[in] address Адрес
+ * \param[in] cpu Процессор, датаграммы которого получает сокет
+ * (SO_INCOMING_CPU; -1 - любой)
+ * \return Дескриптор сокета
+ */
+int workerBindSocket(const SocketAddress* address, int cpu);
+
+/*!
+ * \brief Создаёт сокет обработчика, его пул буферов, очередь задач,
+ * колесо таймеров и таблицу клиентов
+ *
+ * Вызывается либо из главного потока, либо (с опцией -N) из самого
+ * обработчика после привязки к процессору: ядро размещает структуры
+ * сокета, а первая запись в страницы пула - память на узле NUMA
+ * текущего процессора.
+ * \param[in] worker Обработчик
+ */
+void workerPrepare(Worker* worker);
+
+/*!
+ * \brief Записывает счётчики всех обработчиков процесса в буфер; при
+ * нескольких процессах-обработчиках добавляет суммы по всем процессам
+ * \param[in] workers Массив обработчиков
+ * \param[in] count Количество обработчиков
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \return Длина записанного текста
+ */
+int workerFormatStats(Worker* workers, int count, char* out, size_t size);
+
+/*!
+ * \brief Записывает в буфер суммы счётчиков обработчиков всех процессов
+ * \param[in] shared Счётчики всех обработчиков
+ * \param[out] out Буфер для текста
+ * \param[in] size Размер буфера
+ * \return Длина записанного текста
+ */
+int workerFormatTotals(SharedStats* shared, char* out, size_t size);
+
+/*!
+ * \brief Переводит обработчики в режим остановки и будит их
+ *
+ * Обработчики отвечают на принятые запросы и завершают свои потоки.
+ * \param[in] workers Массив обработчиков
+ * \param[in] count Количество обработчиков
+ * \param[in] mode WORKER_DRAIN или WORKER_HANDOFF
+ */
+void workerStop(Worker* workers, int count, int mode);
+
+/*!
+ * \brief Основная функция потока-обработчика
+ * \param[in] arg Указатель на Worker
+ * \return NULL
+ */
+void* workerRun(void* arg);
+
+#endif //INC_6_LAB_WORKER_H